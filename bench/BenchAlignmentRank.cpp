@@ -0,0 +1,130 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include <chrono>
+#include <random>
+#include "../src/common.h"
+#include "../src/AlignmentRank.h"
+//**************************************************************
+
+/*
+ * Micro-benchmark for similarity search alignment ranking
+ *
+ * Compares the previous comparison path (copy of the other alignment's
+ * results by value, log10 of both e-values on each call) against the
+ * precomputed SimSearchRankKey comparator. Prints comparisons per second.
+ *
+ * Usage: BenchAlignmentRank [alignment count] [rounds]
+ */
+
+// Mirrors the ranking related layout of QuerySequence::SimSearchResults
+struct LegacyResults {
+    std::string fields[20];
+    fp32        tax_score;
+    fp64        e_val_raw;
+    fp64        coverage_raw;
+    bool        contaminant;
+};
+
+static bool legacy_is_better(const LegacyResults &first, const LegacyResults &other, bool overall) {
+    const LegacyResults second = other;     // Previous code copied the alignment by value
+
+    fp64 eval1 = first.e_val_raw;
+    fp64 eval2 = second.e_val_raw;
+    fp64 cov1 = first.coverage_raw;
+    fp64 cov2 = second.coverage_raw;
+    fp64 coverage_dif = fabs(cov1 - cov2);
+    if (!overall) {
+        fp64 log1 = eval1 != 0.0 ? log10(eval1) : 0.0;
+        fp64 log2 = eval2 != 0.0 ? log10(eval2) : 0.0;
+        if (fabs(log1 - log2) < SimSearchRankKey::E_VAL_DIF) {
+            if (coverage_dif > SimSearchRankKey::COV_DIF) return cov1 > cov2;
+            if (first.contaminant && !second.contaminant) return false;
+            if (!first.contaminant && second.contaminant) return true;
+            if (first.tax_score == second.tax_score) return eval1 < eval2;
+            return first.tax_score > second.tax_score;
+        }
+        return eval1 < eval2;
+    }
+    if (coverage_dif > SimSearchRankKey::COV_DIF) return cov1 > cov2;
+    if (first.contaminant && !second.contaminant) return false;
+    if (!first.contaminant && second.contaminant) return true;
+    if (first.tax_score == second.tax_score) return cov1 > cov2;
+    return first.tax_score > second.tax_score;
+}
+
+template<typename T, typename F>
+static fp64 run(const std::vector<T> &items, uint32 rounds, F compare, uint64 &wins) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32 r = 0; r < rounds; r++) {
+        for (size_t i = 1; i < items.size(); i++) {
+            wins += compare(items[i], items[i - 1], (i & 1) != 0);
+        }
+    }
+    std::chrono::duration<fp64> elapsed = std::chrono::steady_clock::now() - start;
+    return (fp64)rounds * (items.size() - 1) / elapsed.count();
+}
+
+int main(int argc, const char **argv) {
+    size_t count  = argc > 1 ? std::stoul(argv[1]) : 100000;
+    uint32 rounds = argc > 2 ? (uint32) std::stoul(argv[2]) : 20;
+    uint64 legacy_wins = 0;
+    uint64 key_wins = 0;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<fp64> exp_dist(-180.0, -1.0);
+    std::uniform_real_distribution<fp64> cov_dist(10.0, 100.0);
+    std::uniform_int_distribution<int>   tax_dist(0, 12);
+    std::bernoulli_distribution          contam_dist(0.1);
+
+    std::vector<LegacyResults>    legacy(count);
+    std::vector<SimSearchRankKey> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        LegacyResults &res = legacy[i];
+        for (std::string &field : res.fields) field = "field_value_" + std::to_string(i);
+        res.e_val_raw    = pow(10.0, exp_dist(gen));
+        res.coverage_raw = cov_dist(gen);
+        res.tax_score    = (fp32) tax_dist(gen);
+        res.contaminant  = contam_dist(gen);
+        keys[i] = SimSearchRankKey::make(res.e_val_raw, res.coverage_raw, res.tax_score, res.contaminant);
+    }
+
+    fp64 legacy_rate = run(legacy, rounds, legacy_is_better, legacy_wins);
+    fp64 key_rate = run(keys, rounds, SimSearchRankKey::is_better, key_wins);
+
+    std::cout << "Alignments: " << count << " Rounds: " << rounds << std::endl;
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "Previous comparator:  " << legacy_rate << " comparisons/sec" << std::endl;
+    std::cout << "Rank key comparator:  " << key_rate << " comparisons/sec" << std::endl;
+    std::cout << std::setprecision(2) << "Speedup: " << key_rate / legacy_rate << "x" << std::endl;
+    if (legacy_wins != key_wins) {
+        std::cout << "WARNING: comparators disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include <chrono>
+#include <random>
+#include "../src/common.h"
+#include "../src/CodonTranslator.h"
+//**************************************************************
+
+/*
+ * Micro-benchmark for the codon translation kernel
+ *
+ * Builds a random FASTA style sequence block (60 bases per line, ~1% N)
+ * and times base encoding and six frame translation for each SIMD level
+ * the CPU supports. Prints Gbases/s per level. Translations of every level
+ * are compared against the scalar reference for each genetic code.
+ *
+ * Usage: BenchCodonTranslator [bases] [repeats]
+ */
+
+static const uint64 LINE_LENGTH = 60;
+
+static std::string random_sequence(uint64 bases) {
+    std::mt19937_64 rng(42);
+    std::string     seq;
+    const char      nucleotides[] = "ACGT";
+
+    seq.reserve(bases + bases / LINE_LENGTH + 1);
+    for (uint64 i = 0; i < bases; i++) {
+        seq += rng() % 100 == 0 ? 'N' : nucleotides[rng() % 4];
+        if ((i + 1) % LINE_LENGTH == 0) seq += '\n';
+    }
+    return seq;
+}
+
+static fp64 gbases_per_sec(uint64 bases, uint32 repeats, std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<fp64> elapsed = std::chrono::steady_clock::now() - start;
+    return (fp64) bases * repeats / elapsed.count() / 1e9;
+}
+
+int main(int argc, const char **argv) {
+    uint64              bases   = argc > 1 ? std::stoull(argv[1]) : 50000000;
+    uint32              repeats = argc > 2 ? (uint32) std::stoul(argv[2]) : 5;
+    std::string         seq     = random_sequence(bases);
+    std::vector<uint8>  codes;
+    std::string         reference[6];
+    std::string         proteins[6];
+    bool                matched = true;
+    CodonTranslator     translator;
+    CodonTranslator::SIMD_LEVEL max_level = CodonTranslator::get_simd_level();
+
+    std::cout << "Bases: " << bases << " Repeats: " << repeats << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    // Every level must match scalar, for every genetic code
+    for (uint16 table = 1; table <= 33; table++) {
+        if (!translator.set_table(table)) continue;
+        CodonTranslator::set_simd_level(CodonTranslator::SIMD_SCALAR);
+        translator.translate_six_frames(seq.data(), seq.size(), reference);
+        for (int level = CodonTranslator::SIMD_SSE4; level <= max_level; level++) {
+            CodonTranslator::set_simd_level((CodonTranslator::SIMD_LEVEL) level);
+            translator.translate_six_frames(seq.data(), seq.size(), proteins);
+            for (uint8 frame = 0; frame < 6; frame++) {
+                if (proteins[frame] != reference[frame]) {
+                    std::cout << "WARNING: " << CodonTranslator::simd_name((CodonTranslator::SIMD_LEVEL) level) <<
+                              " differs from scalar, table " << table << " frame " << (int) frame << std::endl;
+                    matched = false;
+                }
+            }
+        }
+    }
+    translator.set_table(CodonTranslator::DEFAULT_TABLE);
+
+    for (int level = CodonTranslator::SIMD_SCALAR; level <= max_level; level++) {
+        const char *name = CodonTranslator::simd_name(CodonTranslator::set_simd_level((CodonTranslator::SIMD_LEVEL) level));
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32 i = 0; i < repeats; i++) translator.encode(seq.data(), seq.size(), codes);
+        fp64 encode_rate = gbases_per_sec(bases, repeats, start);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32 i = 0; i < repeats; i++) translator.translate_six_frames(seq.data(), seq.size(), proteins);
+        fp64 six_frame_rate = gbases_per_sec(bases, repeats, start);
+
+        std::cout << name << " encode:      " << encode_rate    << " Gbases/s" << std::endl;
+        std::cout << name << " six frame:   " << six_frame_rate << " Gbases/s" << std::endl;
+    }
+    if (!matched) return 1;
+    return 0;
+}
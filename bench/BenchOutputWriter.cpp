@@ -0,0 +1,152 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include <chrono>
+#include <sstream>
+#include "../src/common.h"
+#include "../src/OutputWriter.h"
+//**************************************************************
+
+/*
+ * Micro-benchmark for delimited output rows
+ *
+ * Compares the previous row path (fresh std::stringstream per row, row
+ * streamed into std::ofstream followed by std::endl) against formatting
+ * into a reused row buffer written through OutputWriter. Prints rows per
+ * second for TSV and CSV. Output of both paths is compared byte for byte.
+ *
+ * Usage: BenchOutputWriter [row count] [output directory]
+ */
+
+void FS_dprint(const std::string&) {}
+
+static const uint32 FIELD_COUNT = 30;      // Roughly the default final annotation headers
+
+static std::string legacy_row(const std::vector<std::string> &fields, char delim) {
+    std::stringstream stream;
+    std::string temp;
+
+    for (const std::string &field : fields) {
+        temp = field;
+        stream << temp << delim;
+    }
+    return stream.str();
+}
+
+static void buffered_row(const std::vector<std::string> &fields, char delim, std::string &row) {
+    static thread_local std::string temp;
+
+    for (const std::string &field : fields) {
+        temp = field;
+        row += temp;
+        row += delim;
+    }
+}
+
+static fp64 run_legacy(const std::vector<std::vector<std::string>> &rows, char delim, const std::string &path) {
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    for (const std::vector<std::string> &fields : rows) {
+        file << legacy_row(fields, delim) << std::endl;
+    }
+    file.close();
+    std::chrono::duration<fp64> elapsed = std::chrono::steady_clock::now() - start;
+    return rows.size() / elapsed.count();
+}
+
+static fp64 run_buffered(const std::vector<std::vector<std::string>> &rows, char delim, const std::string &path) {
+    auto start = std::chrono::steady_clock::now();
+    OutputWriter writer;
+    std::string  row;
+    writer.open(path, false);
+    for (const std::vector<std::string> &fields : rows) {
+        row.clear();
+        buffered_row(fields, delim, row);
+        row += '\n';
+        writer.write(row);
+    }
+    writer.close();
+    std::chrono::duration<fp64> elapsed = std::chrono::steady_clock::now() - start;
+    return rows.size() / elapsed.count();
+}
+
+static bool same_file(const std::string &first, const std::string &second) {
+    std::ifstream file1(first, std::ios::binary);
+    std::ifstream file2(second, std::ios::binary);
+    std::stringstream data1;
+    std::stringstream data2;
+    data1 << file1.rdbuf();
+    data2 << file2.rdbuf();
+    return data1.str() == data2.str();
+}
+
+int main(int argc, const char **argv) {
+    size_t      count = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::string out_dir = argc > 2 ? argv[2] : ".";
+    bool        matched = true;
+
+    std::vector<std::vector<std::string>> rows(count);
+    for (size_t i = 0; i < count; i++) {
+        rows[i].reserve(FIELD_COUNT);
+        rows[i].push_back("TRINITY_DN" + std::to_string(i) + "_c0_g1_i1");
+        for (uint32 j = 1; j < FIELD_COUNT; j++) {
+            // Mix of empty, short, and GO term sized fields
+            if ((i + j) % 5 == 0) {
+                rows[i].push_back("");
+            } else if ((i + j) % 5 == 1) {
+                rows[i].push_back("GO:0005524-ATP binding(L=3),GO:0016887-ATPase activity(L=4)");
+            } else {
+                rows[i].push_back("value_" + std::to_string(i * j));
+            }
+        }
+    }
+
+    std::cout << "Rows: " << count << " Fields: " << FIELD_COUNT << std::endl;
+    std::cout << std::fixed;
+    for (char delim : {'\t', ','}) {
+        std::string name = delim == '\t' ? "TSV" : "CSV";
+        std::string legacy_path = out_dir + "/bench_legacy." + name;
+        std::string buffered_path = out_dir + "/bench_buffered." + name;
+
+        fp64 legacy_rate = run_legacy(rows, delim, legacy_path);
+        fp64 buffered_rate = run_buffered(rows, delim, buffered_path);
+
+        std::cout << std::setprecision(0);
+        std::cout << name << " previous writer:  " << legacy_rate << " rows/sec" << std::endl;
+        std::cout << name << " buffered writer:  " << buffered_rate << " rows/sec" << std::endl;
+        std::cout << std::setprecision(2) << name << " speedup: " << buffered_rate / legacy_rate << "x" << std::endl;
+        if (!same_file(legacy_path, buffered_path)) matched = false;
+        remove(legacy_path.c_str());
+        remove(buffered_path.c_str());
+    }
+    if (!matched) {
+        std::cout << "WARNING: outputs differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_ALIGNMENTRANK_H
+#define ENTAP_ALIGNMENTRANK_H
+
+//*********************** Includes *****************************
+#include <cmath>
+#include "common.h"
+//**************************************************************
+
+/**
+ * ======================================================================
+ * Struct SimSearchRankKey
+ *
+ * Description          - Plain ranking fields of a similarity search
+ *                        alignment, computed once when the alignment is
+ *                        created so comparisons never touch strings or
+ *                        recompute logarithms
+ *
+ * Notes                - Kept header only so it can be used without the
+ *                        rest of the alignment classes
+ * =====================================================================
+ */
+struct SimSearchRankKey {
+    fp64  log_eval;         // log10 of e-value, 0 when e-value is 0
+    fp64  e_val;
+    fp64  coverage;
+    fp32  tax_score;
+    bool  contaminant;
+
+    static constexpr fp64 E_VAL_DIF = 8;    // Orders of magnitude between "equal" e-values
+    static constexpr fp64 COV_DIF   = 5;    // Coverage difference considered significant
+
+    static SimSearchRankKey make(fp64 e_val, fp64 coverage, fp32 tax_score, bool contaminant) {
+        SimSearchRankKey key;
+        key.log_eval    = e_val != 0.0 ? log10(e_val) : 0.0;
+        key.e_val       = e_val;
+        key.coverage    = coverage;
+        key.tax_score   = tax_score;
+        key.contaminant = contaminant;
+        return key;
+    }
+
+    /**
+     * ======================================================================
+     * Function bool SimSearchRankKey::is_better(const SimSearchRankKey &first,
+     *                                           const SimSearchRankKey &second,
+     *                                           bool overall)
+     *
+     * Description          - Determines whether first ranks above second
+     *
+     * Notes                - Hits from the same database are ranked primarily
+     *                        by e-value. Overall hits across databases ignore
+     *                        e-value and rank by coverage, contamination and
+     *                        taxonomic score
+     *
+     * @param first         - Key of candidate alignment
+     * @param second        - Key of alignment to compare against
+     * @param overall       - True when comparing across databases
+     *
+     * @return              - True if first is the better alignment
+     *
+     * =====================================================================
+     */
+    static bool is_better(const SimSearchRankKey &first, const SimSearchRankKey &second, bool overall) {
+        fp64 coverage_dif = fabs(first.coverage - second.coverage);
+
+        if (!overall) {
+            // For hits of the same database "better hit"
+            if (fabs(first.log_eval - second.log_eval) >= E_VAL_DIF) {
+                return first.e_val < second.e_val;
+            }
+            if (coverage_dif > COV_DIF) return first.coverage > second.coverage;
+            if (first.contaminant != second.contaminant) return !first.contaminant;
+            if (first.tax_score == second.tax_score) return first.e_val < second.e_val;
+            return first.tax_score > second.tax_score;
+        } else {
+            // For overall best hits between databases "best hit"
+            if (coverage_dif > COV_DIF) return first.coverage > second.coverage;
+            if (first.contaminant != second.contaminant) return !first.contaminant;
+            if (first.tax_score == second.tax_score) return first.coverage > second.coverage;
+            return first.tax_score > second.tax_score;
+        }
+    }
+};
+
+#endif //ENTAP_ALIGNMENTRANK_H
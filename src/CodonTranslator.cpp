@@ -0,0 +1,560 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include <cstring>
+#include "CodonTranslator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CT_X86_SIMD
+#include <immintrin.h>
+#endif
+//**************************************************************
+
+// NCBI genetic codes, amino acids in NCBI (TCAG) codon order
+struct GeneticCode {
+    uint16      id;
+    const char *amino_acids;
+};
+
+static const GeneticCode GENETIC_CODES[] = {
+    {1,  "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Standard
+    {2,  "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG"},   // Vertebrate mitochondrial
+    {3,  "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Yeast mitochondrial
+    {4,  "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Mold, protozoan, coelenterate mito, mycoplasma
+    {5,  "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG"},   // Invertebrate mitochondrial
+    {6,  "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Ciliate, dasycladacean, hexamita nuclear
+    {9,  "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},   // Echinoderm, flatworm mitochondrial
+    {10, "FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Euplotid nuclear
+    {11, "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Bacterial, archaeal, plant plastid
+    {12, "FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Alternative yeast nuclear
+    {13, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG"},   // Ascidian mitochondrial
+    {14, "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},   // Alternative flatworm mitochondrial
+    {16, "FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Chlorophycean mitochondrial
+    {21, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG"},   // Trematode mitochondrial
+    {22, "FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Scenedesmus obliquus mitochondrial
+    {23, "FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Thraustochytrium mitochondrial
+    {24, "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"},   // Rhabdopleuridae mitochondrial
+    {25, "FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Candidate division SR1, gracilibacteria
+    {26, "FFLLSSSSYY**CC*WLLLAPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Pachysolen tannophilus nuclear
+    {29, "FFLLSSSSYYYYCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Mesodinium nuclear
+    {30, "FFLLSSSSYYEECC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"},   // Peritrich nuclear
+    {33, "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"},   // Cephalodiscidae mitochondrial
+};
+
+static const uint8 NCBI_BASE_ORDER[4] = {2, 1, 3, 0};   // A, C, G, T position in TCAG
+static const char  NUC_CHARS[]        = "ACGTN";
+
+static const GeneticCode *find_code(uint16 table_id) {
+    for (const GeneticCode &code : GENETIC_CODES) {
+        if (code.id == table_id) return &code;
+    }
+    return nullptr;
+}
+
+static inline uint8 encode_base(char c) {
+    switch (c | 0x20) {
+        case 'a': return 0;
+        case 'c': return 1;
+        case 'g': return 2;
+        case 't':
+        case 'u': return 3;
+        default:  return CodonTranslator::NUC_AMBIGUOUS;
+    }
+}
+
+static inline uint8 complement_base(uint8 code) {
+    return code < CodonTranslator::NUC_AMBIGUOUS ? (uint8) (3 - code) : code;
+}
+
+//------------------------- Scalar kernels -------------------------//
+
+static void encode_scalar(const char *seq, uint64 len, uint8 *codes) {
+    for (uint64 i = 0; i < len; i++) codes[i] = encode_base(seq[i]);
+}
+
+static void reverse_complement_scalar(const uint8 *codes, uint64 len, uint8 *out) {
+    for (uint64 i = 0; i < len; i++) out[i] = complement_base(codes[len - 1 - i]);
+}
+
+static void codon_indices_scalar(const uint8 *codes, uint64 count, uint8 *codons) {
+    for (uint64 i = 0; i < count; i++) {
+        codons[i] = (uint8) (codes[i] * 25 + codes[i + 1] * 5 + codes[i + 2]);
+    }
+}
+
+static void lookup_scalar(const char *table, const uint8 *codons, uint64 count, char *out) {
+    for (uint64 i = 0; i < count; i++) out[i] = table[codons[i]];
+}
+
+// Splits every third value into its frame, frames[f][i] = in[i * 3 + f] for i < count
+static void split_frames_scalar(const char *in, uint64 count, char *frames[3]) {
+    for (uint64 i = 0; i < count; i++) {
+        frames[0][i] = in[i * 3];
+        frames[1][i] = in[i * 3 + 1];
+        frames[2][i] = in[i * 3 + 2];
+    }
+}
+
+#ifdef CT_X86_SIMD
+//------------------------- SSE4.1 kernels -------------------------//
+
+__attribute__((target("sse4.1")))
+static void encode_sse4(const char *seq, uint64 len, uint8 *codes) {
+    const __m128i lower = _mm_set1_epi8(0x20);
+    uint64 i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i c   = _mm_or_si128(_mm_loadu_si128((const __m128i*) (seq + i)), lower);
+        __m128i ret = _mm_set1_epi8(CodonTranslator::NUC_AMBIGUOUS);
+        ret = _mm_blendv_epi8(ret, _mm_setzero_si128(), _mm_cmpeq_epi8(c, _mm_set1_epi8('a')));
+        ret = _mm_blendv_epi8(ret, _mm_set1_epi8(1), _mm_cmpeq_epi8(c, _mm_set1_epi8('c')));
+        ret = _mm_blendv_epi8(ret, _mm_set1_epi8(2), _mm_cmpeq_epi8(c, _mm_set1_epi8('g')));
+        ret = _mm_blendv_epi8(ret, _mm_set1_epi8(3), _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('t')),
+                                                                  _mm_cmpeq_epi8(c, _mm_set1_epi8('u'))));
+        _mm_storeu_si128((__m128i*) (codes + i), ret);
+    }
+    encode_scalar(seq + i, len - i, codes + i);
+}
+
+__attribute__((target("sse4.1")))
+static void reverse_complement_sse4(const uint8 *codes, uint64 len, uint8 *out) {
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    uint64 i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*) (codes + len - i - 16));
+        c = _mm_shuffle_epi8(c, reverse);
+        // 0-3 become 3-0, ambiguous (4) becomes 7 and is clamped back to 4
+        c = _mm_min_epu8(_mm_xor_si128(c, _mm_set1_epi8(3)), _mm_set1_epi8(CodonTranslator::NUC_AMBIGUOUS));
+        _mm_storeu_si128((__m128i*) (out + i), c);
+    }
+    for (; i < len; i++) out[i] = complement_base(codes[len - 1 - i]);
+}
+
+__attribute__((target("sse4.1")))
+static void codon_indices_sse4(const uint8 *codes, uint64 count, uint8 *codons) {
+    uint64 i = 0;
+
+    // Byte adds only, largest index is 124
+    for (; i + 16 <= count; i += 16) {
+        __m128i n1 = _mm_loadu_si128((const __m128i*) (codes + i));
+        __m128i n2 = _mm_loadu_si128((const __m128i*) (codes + i + 1));
+        __m128i n3 = _mm_loadu_si128((const __m128i*) (codes + i + 2));
+        __m128i t  = _mm_add_epi8(n1, n1);
+        t  = _mm_add_epi8(_mm_add_epi8(t, t), n1);                  // n1 * 5
+        t  = _mm_add_epi8(t, n2);
+        __m128i t2 = _mm_add_epi8(t, t);
+        t  = _mm_add_epi8(_mm_add_epi8(t2, t2), t);                 // (n1 * 5 + n2) * 5
+        _mm_storeu_si128((__m128i*) (codons + i), _mm_add_epi8(t, n3));
+    }
+    codon_indices_scalar(codes + i, count - i, codons + i);
+}
+
+__attribute__((target("sse4.1")))
+static void lookup_sse4(const char *table, const uint8 *codons, uint64 count, char *out) {
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    __m128i       rows[8];
+    uint64        i = 0;
+
+    for (uint8 k = 0; k < 8; k++) rows[k] = _mm_loadu_si128((const __m128i*) (table + k * 16));
+
+    // 128 entry lookup, low nibble selects within a 16 entry row, high nibble selects the row
+    for (; i + 16 <= count; i += 16) {
+        __m128i c   = _mm_loadu_si128((const __m128i*) (codons + i));
+        __m128i lo  = _mm_and_si128(c, low_mask);
+        __m128i hi  = _mm_and_si128(_mm_srli_epi16(c, 4), low_mask);
+        __m128i ret = _mm_setzero_si128();
+        for (uint8 k = 0; k < 8; k++) {
+            __m128i row = _mm_shuffle_epi8(rows[k], lo);
+            ret = _mm_or_si128(ret, _mm_and_si128(row, _mm_cmpeq_epi8(hi, _mm_set1_epi8(k))));
+        }
+        _mm_storeu_si128((__m128i*) (out + i), ret);
+    }
+    lookup_scalar(table, codons + i, count - i, out + i);
+}
+
+__attribute__((target("sse4.1")))
+static void split_frames_sse4(const char *in, uint64 count, char *frames[3]) {
+    __m128i masks[3][3];
+    uint64  i = 0;
+
+    // masks[f][c] picks the bytes of frame f held in 16 byte chunk c of 48
+    for (uint8 f = 0; f < 3; f++) {
+        for (uint8 c = 0; c < 3; c++) {
+            alignas(16) int8 mask[16];
+            for (uint8 k = 0; k < 16; k++) {
+                int pos = k * 3 + f - c * 16;
+                mask[k] = (int8) (pos >= 0 && pos < 16 ? pos : -1);
+            }
+            masks[f][c] = _mm_load_si128((const __m128i*) mask);
+        }
+    }
+    for (; i + 16 <= count; i += 16) {
+        __m128i c0 = _mm_loadu_si128((const __m128i*) (in + i * 3));
+        __m128i c1 = _mm_loadu_si128((const __m128i*) (in + i * 3 + 16));
+        __m128i c2 = _mm_loadu_si128((const __m128i*) (in + i * 3 + 32));
+        for (uint8 f = 0; f < 3; f++) {
+            __m128i ret = _mm_or_si128(_mm_shuffle_epi8(c0, masks[f][0]), _mm_shuffle_epi8(c1, masks[f][1]));
+            ret = _mm_or_si128(ret, _mm_shuffle_epi8(c2, masks[f][2]));
+            _mm_storeu_si128((__m128i*) (frames[f] + i), ret);
+        }
+    }
+    char *rest[3] = {frames[0] + i, frames[1] + i, frames[2] + i};
+    split_frames_scalar(in + i * 3, count - i, rest);
+}
+
+//-------------------------- AVX2 kernels --------------------------//
+// Tails are finished by the SSE4.1 kernels, FASTA lines are often only 60 bases.
+// Upper halves are cleared first, the compiler does not always do it and
+// legacy SSE code after dirty AVX state is several times slower
+
+
+__attribute__((target("avx2")))
+static void encode_avx2(const char *seq, uint64 len, uint8 *codes) {
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    uint64 i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i c   = _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (seq + i)), lower);
+        __m256i ret = _mm256_set1_epi8(CodonTranslator::NUC_AMBIGUOUS);
+        ret = _mm256_blendv_epi8(ret, _mm256_setzero_si256(), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('a')));
+        ret = _mm256_blendv_epi8(ret, _mm256_set1_epi8(1), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('c')));
+        ret = _mm256_blendv_epi8(ret, _mm256_set1_epi8(2), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('g')));
+        ret = _mm256_blendv_epi8(ret, _mm256_set1_epi8(3),
+                                 _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('t')),
+                                                 _mm256_cmpeq_epi8(c, _mm256_set1_epi8('u'))));
+        _mm256_storeu_si256((__m256i*) (codes + i), ret);
+    }
+    _mm256_zeroupper();
+    encode_sse4(seq + i, len - i, codes + i);
+}
+
+__attribute__((target("avx2")))
+static void reverse_complement_avx2(const uint8 *codes, uint64 len, uint8 *out) {
+    const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    uint64 i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i*) (codes + len - i - 32));
+        c = _mm256_shuffle_epi8(c, reverse);                // Reverse within lanes
+        c = _mm256_permute2x128_si256(c, c, 1);             // Swap lanes
+        c = _mm256_min_epu8(_mm256_xor_si256(c, _mm256_set1_epi8(3)),
+                            _mm256_set1_epi8(CodonTranslator::NUC_AMBIGUOUS));
+        _mm256_storeu_si256((__m256i*) (out + i), c);
+    }
+    _mm256_zeroupper();
+    reverse_complement_sse4(codes, len - i, out + i);
+}
+
+__attribute__((target("avx2")))
+static void codon_indices_avx2(const uint8 *codes, uint64 count, uint8 *codons) {
+    uint64 i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i n1 = _mm256_loadu_si256((const __m256i*) (codes + i));
+        __m256i n2 = _mm256_loadu_si256((const __m256i*) (codes + i + 1));
+        __m256i n3 = _mm256_loadu_si256((const __m256i*) (codes + i + 2));
+        __m256i t  = _mm256_add_epi8(n1, n1);
+        t  = _mm256_add_epi8(_mm256_add_epi8(t, t), n1);
+        t  = _mm256_add_epi8(t, n2);
+        __m256i t2 = _mm256_add_epi8(t, t);
+        t  = _mm256_add_epi8(_mm256_add_epi8(t2, t2), t);
+        _mm256_storeu_si256((__m256i*) (codons + i), _mm256_add_epi8(t, n3));
+    }
+    _mm256_zeroupper();
+    codon_indices_sse4(codes + i, count - i, codons + i);
+}
+
+__attribute__((target("avx2")))
+static void lookup_avx2(const char *table, const uint8 *codons, uint64 count, char *out) {
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i       rows[8];
+    uint64        i = 0;
+
+    for (uint8 k = 0; k < 8; k++) {
+        rows[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) (table + k * 16)));
+    }
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i c   = _mm256_loadu_si256((const __m256i*) (codons + i));
+        __m256i lo  = _mm256_and_si256(c, low_mask);
+        __m256i hi  = _mm256_and_si256(_mm256_srli_epi16(c, 4), low_mask);
+        __m256i ret = _mm256_setzero_si256();
+        for (uint8 k = 0; k < 8; k++) {
+            __m256i row = _mm256_shuffle_epi8(rows[k], lo);
+            ret = _mm256_or_si256(ret, _mm256_and_si256(row, _mm256_cmpeq_epi8(hi, _mm256_set1_epi8(k))));
+        }
+        _mm256_storeu_si256((__m256i*) (out + i), ret);
+    }
+    _mm256_zeroupper();
+    lookup_sse4(table, codons + i, count - i, out + i);
+}
+#endif
+
+//---------------------------- Dispatch ----------------------------//
+
+struct TranslateKernels {
+    void (*encode)(const char*, uint64, uint8*);
+    void (*reverse_complement)(const uint8*, uint64, uint8*);
+    void (*codon_indices)(const uint8*, uint64, uint8*);
+    void (*lookup)(const char*, const uint8*, uint64, char*);
+    void (*split_frames)(const char*, uint64, char*[3]);
+};
+
+static const TranslateKernels KERNELS[] = {
+    {encode_scalar, reverse_complement_scalar, codon_indices_scalar, lookup_scalar, split_frames_scalar},
+#ifdef CT_X86_SIMD
+    {encode_sse4, reverse_complement_sse4, codon_indices_sse4, lookup_sse4, split_frames_sse4},
+    {encode_avx2, reverse_complement_avx2, codon_indices_avx2, lookup_avx2, split_frames_sse4},
+#endif
+};
+
+static CodonTranslator::SIMD_LEVEL supported_level() {
+#ifdef CT_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return CodonTranslator::SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return CodonTranslator::SIMD_SSE4;
+#endif
+    return CodonTranslator::SIMD_SCALAR;
+}
+
+static const CodonTranslator::SIMD_LEVEL MAX_LEVEL = supported_level();
+static CodonTranslator::SIMD_LEVEL       active_level = MAX_LEVEL;
+
+
+CodonTranslator::CodonTranslator(uint16 table_id) {
+    if (!set_table(table_id)) set_table(DEFAULT_TABLE);
+}
+
+
+/**
+ * ======================================================================
+ * Function bool CodonTranslator::set_table(uint16 table_id)
+ *
+ * Description          - Builds codon index to amino acid table from an
+ *                        NCBI genetic code
+ *
+ * Notes                - Codons with an ambiguous base become 'X'
+ *
+ * @param table_id      - NCBI translation table number (1 = standard)
+ *
+ * @return              - False if table is unknown (table unchanged)
+ *
+ * =====================================================================
+ */
+bool CodonTranslator::set_table(uint16 table_id) {
+    const GeneticCode *code = find_code(table_id);
+
+    if (code == nullptr) return false;
+    memset(_amino_acids, 'X', sizeof(_amino_acids));
+    for (uint8 a = 0; a < 4; a++) {
+        for (uint8 b = 0; b < 4; b++) {
+            for (uint8 c = 0; c < 4; c++) {
+                _amino_acids[a * 25 + b * 5 + c] = code->amino_acids[NCBI_BASE_ORDER[a] * 16 +
+                                                                     NCBI_BASE_ORDER[b] * 4 +
+                                                                     NCBI_BASE_ORDER[c]];
+            }
+        }
+    }
+    _table_id = table_id;
+    return true;
+}
+
+uint16 CodonTranslator::get_table() const {
+    return _table_id;
+}
+
+
+/**
+ * ======================================================================
+ * Function uint64 CodonTranslator::encode(const char *seq, uint64 len,
+ *                                         std::vector<uint8> &codes)
+ *
+ * Description          - Converts bases to codes (A, C, G, T/U = 0-3,
+ *                        anything else 4), case insensitive
+ *
+ * Notes                - Line breaks (\n and \r\n) are skipped so FASTA
+ *                        sequence blocks can be passed directly
+ *
+ * @param seq           - Bases
+ * @param len           - Bytes in seq
+ * @param codes         - Codes, resized to the number of bases
+ *
+ * @return              - Number of bases
+ *
+ * =====================================================================
+ */
+uint64 CodonTranslator::encode(const char *seq, uint64 len, std::vector<uint8> &codes) const {
+    const char *end = seq + len;
+    const char *line_end;
+    uint64      line_len;
+    uint64      count = 0;
+
+    codes.resize(len);
+    while (seq < end) {
+        line_end = (const char*) memchr(seq, '\n', (size_t) (end - seq));
+        if (line_end == nullptr) line_end = end;
+        line_len = (uint64) (line_end - seq);
+        if (line_len > 0 && seq[line_len - 1] == '\r') line_len--;
+        KERNELS[active_level].encode(seq, line_len, codes.data() + count);
+        count += line_len;
+        seq = line_end + 1;
+    }
+    codes.resize(count);
+    return count;
+}
+
+
+// Codon index of every position (count = bases - 2), codes must hold count + 2 bases
+void CodonTranslator::codon_indices(const uint8 *codes, uint64 count, uint8 *codons) const {
+    KERNELS[active_level].codon_indices(codes, count, codons);
+}
+
+// Amino acid of each codon index
+void CodonTranslator::translate_codons(const uint8 *codons, uint64 count, char *amino_acids) const {
+    KERNELS[active_level].lookup(_amino_acids, codons, count, amino_acids);
+}
+
+
+/**
+ * ======================================================================
+ * Function void CodonTranslator::translate(const std::vector<uint8> &codes,
+ *                                          uint8 frame, std::string &protein)
+ *
+ * Description          - Translates one frame of coded bases
+ *
+ * Notes                - Stop codons are kept as '*', trailing partial
+ *                        codon is dropped
+ *
+ * @param codes         - Coded bases (see encode)
+ * @param frame         - Offset of first codon (0-2)
+ * @param protein       - Translation, replaced
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void CodonTranslator::translate(const std::vector<uint8> &codes, uint8 frame, std::string &protein) const {
+    static thread_local std::vector<uint8> codons;
+    uint64 count;
+
+    protein.clear();
+    if (codes.size() < (uint64) frame + 3) return;
+    count = (codes.size() - frame) / 3;
+    codons.resize(count);
+    for (uint64 i = 0; i < count; i++) {
+        const uint8 *codon = codes.data() + frame + i * 3;
+        codons[i] = (uint8) (codon[0] * 25 + codon[1] * 5 + codon[2]);
+    }
+    protein.resize(count);
+    translate_codons(codons.data(), count, &protein[0]);
+}
+
+
+/**
+ * ======================================================================
+ * Function void CodonTranslator::translate_six_frames(const char *seq, uint64 len,
+ *                                                     std::string proteins[6])
+ *
+ * Description          - Translates all six frames of a sequence
+ *
+ * Notes                - Frames 0-2 are forward, 3-5 reverse complement
+ *                      - Codon index and amino acid of every position is
+ *                        computed once per strand, frames are read from it
+ *
+ * @param seq           - Bases (line breaks allowed)
+ * @param len           - Bytes in seq
+ * @param proteins      - Translation of each frame, replaced
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void CodonTranslator::translate_six_frames(const char *seq, uint64 len, std::string proteins[6]) const {
+    static thread_local std::vector<uint8> strands[2];
+    static thread_local std::vector<uint8> codons;
+    static thread_local std::string        amino_acids;
+    uint64 bases;
+
+    bases = encode(seq, len, strands[0]);
+    reverse_complement(strands[0], strands[1]);
+    for (uint8 strand = 0; strand < 2; strand++) {
+        for (uint8 frame = 0; frame < 3; frame++) proteins[strand * 3 + frame].clear();
+        if (bases < 3) continue;
+        codons.resize(bases - 2);
+        amino_acids.resize(bases - 2);
+        codon_indices(strands[strand].data(), bases - 2, codons.data());
+        translate_codons(codons.data(), bases - 2, &amino_acids[0]);
+        // Every frame has at least (bases - 2) / 3 codons, frames 0 and 1 may have one more
+        char *frames[3];
+        for (uint8 frame = 0; frame < 3; frame++) {
+            proteins[strand * 3 + frame].resize((bases - frame) / 3);
+            frames[frame] = &proteins[strand * 3 + frame][0];
+        }
+        KERNELS[active_level].split_frames(amino_acids.data(), (bases - 2) / 3, frames);
+        for (uint8 frame = 0; frame < 2; frame++) {
+            std::string &protein = proteins[strand * 3 + frame];
+            if (protein.size() > (bases - 2) / 3) protein.back() = amino_acids[frame + (protein.size() - 1) * 3];
+        }
+    }
+}
+
+
+// Reverse complement of coded bases, ambiguous stays ambiguous
+void CodonTranslator::reverse_complement(const std::vector<uint8> &codes, std::vector<uint8> &out) {
+    out.resize(codes.size());
+    KERNELS[active_level].reverse_complement(codes.data(), codes.size(), out.data());
+}
+
+// Coded bases back to ACGTN
+void CodonTranslator::decode(const uint8 *codes, uint64 len, char *bases) {
+    for (uint64 i = 0; i < len; i++) bases[i] = NUC_CHARS[codes[i]];
+}
+
+bool CodonTranslator::is_valid_table(uint16 table_id) {
+    return find_code(table_id) != nullptr;
+}
+
+CodonTranslator::SIMD_LEVEL CodonTranslator::get_simd_level() {
+    return active_level;
+}
+
+// Benchmarks only, not thread safe. Level is capped at what the CPU supports
+CodonTranslator::SIMD_LEVEL CodonTranslator::set_simd_level(SIMD_LEVEL level) {
+    active_level = level > MAX_LEVEL ? MAX_LEVEL : level;
+    return active_level;
+}
+
+const char *CodonTranslator::simd_name(SIMD_LEVEL level) {
+    switch (level) {
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_SSE4: return "SSE4.1";
+        default:        return "scalar";
+    }
+}
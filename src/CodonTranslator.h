@@ -0,0 +1,87 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_CODONTRANSLATOR_H
+#define ENTAP_CODONTRANSLATOR_H
+
+//*********************** Includes *****************************
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * Nucleotide to protein translation. Bases are coded 0-3 (A, C, G, T/U),
+ * anything else is 4. Every codon position gets an index
+ * (n1 * 25 + n2 * 5 + n3) into a 125 entry amino acid table built from an
+ * NCBI genetic code. Codons with an ambiguous base translate to 'X'.
+ *
+ * Encoding, reverse complement, codon indexing and table lookup have
+ * scalar, SSE4.1 and AVX2 versions. The fastest one supported by the CPU
+ * is picked once at start up. All versions give identical results.
+ */
+class CodonTranslator {
+
+public:
+    enum SIMD_LEVEL {
+        SIMD_SCALAR,
+        SIMD_SSE4,
+        SIMD_AVX2
+    };
+
+    static constexpr uint8  NUC_AMBIGUOUS  = 4;
+    static constexpr uint8  CODON_COUNT    = 125;
+    static constexpr uint8  CODON_ATG      = 0 * 25 + 3 * 5 + 2;
+    static constexpr uint16 DEFAULT_TABLE  = 1;       // NCBI standard code
+    static constexpr char   STOP_CHAR      = '*';
+
+    explicit CodonTranslator(uint16 table_id = DEFAULT_TABLE);
+
+    bool set_table(uint16 table_id);
+    uint16 get_table() const;
+    char amino_acid(uint8 codon) const {return _amino_acids[codon];}
+    bool is_stop(uint8 codon) const {return _amino_acids[codon] == STOP_CHAR;}
+
+    uint64 encode(const char *seq, uint64 len, std::vector<uint8> &codes) const;
+    void codon_indices(const uint8 *codes, uint64 len, uint8 *codons) const;
+    void translate_codons(const uint8 *codons, uint64 count, char *amino_acids) const;
+    void translate(const std::vector<uint8> &codes, uint8 frame, std::string &protein) const;
+    void translate_six_frames(const char *seq, uint64 len, std::string proteins[6]) const;
+
+    static void reverse_complement(const std::vector<uint8> &codes, std::vector<uint8> &out);
+    static void decode(const uint8 *codes, uint64 len, char *bases);
+    static bool is_valid_table(uint16 table_id);
+    static SIMD_LEVEL get_simd_level();
+    static SIMD_LEVEL set_simd_level(SIMD_LEVEL level);
+    static const char *simd_name(SIMD_LEVEL level);
+
+private:
+    uint16  _table_id;
+    char    _amino_acids[128];          // Padded for 128 entry vector lookup
+};
+
+
+#endif //ENTAP_CODONTRANSLATOR_H
@@ -55,6 +55,8 @@ namespace entapConfig {
 
     //****************** Local Prototype Functions******************
     void init_entap_database();
+    void init_mapped_database(std::string&, std::stringstream&);
+    void init_eggnog_index(std::string&, std::stringstream&);
     void init_uniprot(std::vector<std::string>&, std::string);
     void init_ncbi(std::vector<std::string>&, std::string);
     void init_diamond_index(std::string, int);
@@ -295,6 +297,7 @@ namespace entapConfig {
      */
     void init_eggnog(int threads) {
         std::string sql_outpath;
+        std::string sql_path;           // SQL database used (existing or downloaded)
         std::string fasta_outpath;
         std::string fasta_temp_filename;
         std::string dmnd_outpath;
@@ -344,6 +347,7 @@ namespace entapConfig {
                 // Downloaded successfully
                 FS_dprint("Success! EggNOG SQL database downloaded to: " + sql_outpath);
                 log_msg << "EggNOG SQL database written to: " + sql_outpath << std::endl;
+                sql_path = sql_outpath;
             }
         } else {
             // Already exists, skip
@@ -353,7 +357,9 @@ namespace entapConfig {
             FS_dprint("EggNOG SQL database already exists at: " + path +
                 " skipping");
             log_msg << "EggNOG SQL Database skipped, exists at: " << path << std::endl;
+            sql_path = path;
         }
+        init_eggnog_index(sql_path, log_msg);
 
         // Check if DIAMOND EggNOG database exists
         if (!_pFileSystem->file_exists(EGG_DMND_PATH) && !_pFileSystem->file_exists(dmnd_outpath)) {
@@ -402,10 +408,91 @@ namespace entapConfig {
         _pFileSystem->print_stats(temp);
     }
 
+    /**
+     * ======================================================================
+     * Function void init_eggnog_index(std::string &sql_path,
+     *                                 std::stringstream &log_msg)
+     *
+     * Description          - Compiles the EggNOG SQL database into the memory
+     *                        mapped EggNOG index if not done already, or if
+     *                        the SQL database has changed since
+     *
+     * Notes                - Index is written next to the SQL database and
+     *                        used automatically at run time.
+     *                        Not fatal, SQL database still works
+     *
+     * @param sql_path      - Path to EggNOG SQL database
+     * @param log_msg       - Configuration log
+     *
+     * @return              - None
+     * ======================================================================
+     */
+    void init_eggnog_index(std::string &sql_path, std::stringstream &log_msg) {
+        std::string    index_path = EggnogDatabase::get_index_path(sql_path);
+        EggnogDatabase eggnogDatabase(_pFileSystem, _pEntapDatabase, nullptr);
+
+        if (_pFileSystem->file_exists(index_path)) {
+            EggnogIndex index;
+            if (index.open(index_path) && index.is_built_from(sql_path)) {
+                log_msg << "EggNOG index already exists at: " << index_path << std::endl;
+                return;
+            }
+            log_msg << "EggNOG index is out of date, recompiling: " << index_path << std::endl;
+        }
+        if (eggnogDatabase.open_sql(sql_path) == EggnogDatabase::ERR_EGG_OK &&
+            eggnogDatabase.compile_index(index_path) == EggnogDatabase::ERR_EGG_OK) {
+            log_msg << "EggNOG index written to: " << index_path << std::endl;
+        } else {
+            FS_dprint("Unable to compile EggNOG index: " + eggnogDatabase.print_err());
+            _pFileSystem->delete_file(index_path);
+            log_msg << "Unable to write EggNOG index, SQL database will be used" << std::endl;
+        }
+    }
+
     void handle_state() {
         state = static_cast<InitStates>(state+1);
     }
 
+    /**
+     * ======================================================================
+     * Function void init_mapped_database(std::string &serial_path,
+     *                                    std::stringstream &log_msg)
+     *
+     * Description          - Converts the serialized EnTAP database to the
+     *                        memory mapped format if not done already, or
+     *                        if the serialized database has changed since
+     *
+     * Notes                - Mapped copy is written next to the serialized
+     *                        database and used automatically at run time.
+     *                        Not fatal, serialized database still works
+     *
+     * @param serial_path   - Path to serialized database
+     * @param log_msg       - Configuration log
+     *
+     * @return              - None
+     * ======================================================================
+     */
+    void init_mapped_database(std::string &serial_path, std::stringstream &log_msg) {
+        std::string   mapped_path = EntapDatabase::get_mapped_path(serial_path);
+        EntapDatabase database(_pFileSystem);
+
+        if (MappedDatabase::is_mapped_database(serial_path)) return;
+        if (_pFileSystem->file_exists(mapped_path)) {
+            MappedDatabase mapped;
+            if (mapped.open(mapped_path) && mapped.is_built_from(serial_path)) {
+                log_msg << "Memory mapped database already exists at: " << mapped_path << std::endl;
+                return;
+            }
+            log_msg << "Memory mapped database is out of date, regenerating: " << mapped_path << std::endl;
+        }
+        if (database.convert_serialized_database(serial_path, mapped_path) == EntapDatabase::ERR_DATA_OK) {
+            log_msg << "Memory mapped database written to: " << mapped_path << std::endl;
+        } else {
+            FS_dprint("Unable to convert database: " + database.print_error_log());
+            log_msg << "Unable to write memory mapped database, serialized database will be used" << std::endl;
+        }
+    }
+
     void init_entap_database() {
         bool              generate_databases;    // Whether user would like to generate rather tahn download
         vect_uint16_t     databases;
@@ -461,6 +548,7 @@ namespace entapConfig {
                 if (_pFileSystem->file_exists(database_outpath)) path = database_outpath;
                 FS_dprint("File already exists at: " + path);
                 log_msg << "Database skipped, already exists at: " << path << std::endl;
+                if (database_type == EntapDatabase::ENTAP_SERIALIZED) init_mapped_database(path, log_msg);
                 continue; // Don't redownload
             }
 
@@ -477,6 +565,7 @@ namespace entapConfig {
             if (database_err == EntapDatabase::ERR_DATA_OK) {
                 FS_dprint("Success! Database written to: " + database_outpath);
                 log_msg << "Database written to: " + database_outpath << std::endl;
+                if (database_type == EntapDatabase::ENTAP_SERIALIZED) init_mapped_database(database_outpath, log_msg);
             } else {
                 // Fatal if any databases fail
                 throw ExceptionHandler(_pEntapDatabase->print_error_log(), ERR_ENTAP_INIT_DATA_GENERIC);
@@ -51,6 +51,7 @@ namespace entapExecute {
     void verify_state(std::queue<char> &, bool &);
     bool valid_state(enum ExecuteStates);
     void exit_error(ExecuteStates);
+    void print_timings();
     //**************************************************************
 
 /**
@@ -125,20 +126,26 @@ namespace entapExecute {
             verify_state(state_queue, state_flag);         // Set state transition
 
             // Initialize Query Data
-            pQUERY_DATA = new QueryData(
-                    _input_path,        // User transcriptome
-                    _entap_outpath,     // Transcriptome directory
-                    _pUserInput,        // User input map
-                    _pFileSystem);      // Filesystem object
+            {
+                Instrumentation::ScopedTimer timer("transcriptome_input");
+                pQUERY_DATA = new QueryData(
+                        _input_path,        // User transcriptome
+                        _entap_outpath,     // Transcriptome directory
+                        _pUserInput,        // User input map
+                        _pFileSystem);      // Filesystem object
+            }
 
             // Initialize Graphing Manager
             pGraphingManager = new GraphingManager(GRAPHING_EXE);
 
             // Initialize EnTAP database
-            pEntapDatabase = new EntapDatabase(filesystem);
-            if (!pEntapDatabase->set_database(entap_database_type)) {
-                throw ExceptionHandler("Unable to initialize EnTAP database\n" +
-                                       pEntapDatabase->print_error_log(), ERR_ENTAP_READ_ENTAP_DATA_GENERIC);
+            {
+                Instrumentation::ScopedTimer timer("entap_database_load");
+                pEntapDatabase = new EntapDatabase(filesystem);
+                if (!pEntapDatabase->set_database(entap_database_type)) {
+                    throw ExceptionHandler("Unable to initialize EnTAP database\n" +
+                                           pEntapDatabase->print_error_log(), ERR_ENTAP_READ_ENTAP_DATA_GENERIC);
+                }
             }
 
             entap_data_ptrs._pEntapDatbase = pEntapDatabase;
@@ -162,6 +169,7 @@ namespace entapExecute {
                             pQUERY_DATA->header_set(ENTAP_HEADER_FRAME, false);
                         } else {
                             FS_dprint("Continuing with frame selection process...");
+                            Instrumentation::ScopedTimer timer("frame_selection");
                             std::unique_ptr<FrameSelection> frame_selection(new FrameSelection(
                                     _input_path, entap_data_ptrs
                             ));
@@ -185,6 +193,7 @@ namespace entapExecute {
                             pQUERY_DATA->header_set(ENTAP_HEADER_EXP_FPKM, false);
                         } else {
                             // Proceed with expression analysis
+                            Instrumentation::ScopedTimer timer("expression");
                             std::unique_ptr<ExpressionAnalysis> expression(new ExpressionAnalysis(
                                 original_input, entap_data_ptrs
                             ));
@@ -205,6 +214,7 @@ namespace entapExecute {
                         break;
                     case SIMILARITY_SEARCH: {
                         FS_dprint("STATE - SIMILARITY SEARCH");
+                        Instrumentation::ScopedTimer timer("similarity_search");
                         // Spawn sim search object
                         std::unique_ptr<SimilaritySearch> sim_search(new SimilaritySearch(
                                 _databases,
@@ -217,6 +227,7 @@ namespace entapExecute {
                     }
                     case GENE_ONTOLOGY: {
                         FS_dprint("STATE - GENE ONTOLOGY");
+                        Instrumentation::ScopedTimer timer("ontology");
                         std::unique_ptr<Ontology> ontology(new Ontology(
                                 _input_path,
                                 entap_data_ptrs
@@ -233,7 +244,11 @@ namespace entapExecute {
             }
 
             // *************************** Exit Stuff ********************** //
-            pQUERY_DATA->final_statistics(final_out_dir, ontology_flags);
+            {
+                Instrumentation::ScopedTimer timer("final_statistics");
+                pQUERY_DATA->final_statistics(final_out_dir, ontology_flags);
+            }
+            print_timings();
            // _pFileSystem->directory_iterate(FileSystem::FILE_ITER_DELETE_EMPTY, _outpath);   // Delete empty files
             delete pQUERY_DATA;
             delete pGraphingManager;
@@ -243,6 +258,7 @@ namespace entapExecute {
             delete pGraphingManager;
             delete pEntapDatabase;
             exit_error(executeStates);
+            print_timings();
             throw e;
         }
     }
@@ -421,4 +437,32 @@ namespace entapExecute {
         ss << "------------------------------------";
         std::cerr<<ss.str()<<std::endl;
     }
+
+
+    /**
+     * ======================================================================
+     * Function void print_timings()
+     *
+     * Description          - Writes timings.json to the output directory and
+     *                        a timing summary to the log file
+     *
+     * Notes                - Failure to write the report is not fatal
+     *
+     * @return              - None
+     * ======================================================================
+     */
+    void print_timings() {
+        std::stringstream out_msg;
+        std::string       timings_path;
+        std::string       summary;
+
+        timings_path = PATHS(_outpath, TIMINGS_FILENAME);
+        if (!Instrumentation::write_json(timings_path)) {
+            FS_dprint("WARNING: unable to write timings to: " + timings_path);
+        }
+        _pFileSystem->format_stat_stream(out_msg, "Run Timings");
+        out_msg << Instrumentation::summary() << "\nFull report: " << timings_path;
+        summary = out_msg.str();
+        _pFileSystem->print_stats(summary);
+    }
 }
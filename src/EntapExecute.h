@@ -38,6 +38,7 @@
 #include "FileSystem.h"
 #include "UserInput.h"
 #include "Ontology.h"
+#include "Instrumentation.h"
 #include "common.h"
 
 //**************************************************************
@@ -50,6 +51,7 @@ namespace entapExecute {
     const std::string TRANSCRIPTOME_FINAL_TAG = "_final.fasta";
     const std::string TRANSCRIPTOME_FRAME_TAG = "_frame_selected.fasta";
     const std::string TRANSCRIPTOME_FILTERED_TAG = "_expression_filtered.fasta";
+    const std::string TIMINGS_FILENAME        = "timings.json";
 
     //**************************************************************
 
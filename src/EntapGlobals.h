@@ -185,11 +185,13 @@ enum SIMILARITY_SOFTWARE {
 
 enum EXPRESSION_SOFTWARE {
     EXP_RSEM,
+    EXP_EM_QUANT,
     EXP_COUNT
 };
 
 enum FRAME_SELECTION_SOFTWARE {
     FRAME_GENEMARK_ST,
+    FRAME_ORF_FINDER,
     FRAME_SOFTWARE_COUNT
 };
 
@@ -70,15 +70,13 @@ EntapModule::EntapModule(std::string &execution_stage_path, std::string &in_hits
 go_format_t EntapModule::EM_parse_go_list(std::string list, EntapDatabase* database,char delim) {
 
     go_format_t output;
-    std::string temp;
-    std::vector<std::vector<std::string>>results;
 
     if (list.empty()) return output;
-    std::istringstream ss(list);
-    while (std::getline(ss,temp,delim)) {
-        GoEntry term_info =
-                database->get_go_entry(temp);
-        output[term_info.category].push_back(temp + "-" + term_info.term +
+    vect_str_t go_ids = split_string(list, delim);
+    std::vector<GoEntry> entries = database->get_go_entries(go_ids);
+    for (uint64 i = 0; i < go_ids.size(); i++) {
+        GoEntry &term_info = entries[i];
+        output[term_info.category].push_back(go_ids[i] + "-" + term_info.term +
                                              "(L=" + term_info.level + ")");
     }
     return output;
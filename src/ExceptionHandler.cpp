@@ -145,6 +145,10 @@ void ExceptionHandler::print_msg(FileSystem* filesystem) {
             added_msg << "Ensure GeneMarkS-T ran properly and the files are all located within "
                     "the frame_selection directory.";
             break;
+        case ERR_ENTAP_RUN_ORF_FINDER:
+            added_msg << "Ensure your transcriptome contains nucleotide sequences and that the "
+                    "frame_selection directory can be written to.";
+            break;
         case ERR_ENTAP_RUN_RSEM_VALIDATE:
             added_msg << "Ensure that you have specified the correct path to the RSEM "
                     "directory and have it properly compiled.";
@@ -156,6 +160,10 @@ void ExceptionHandler::print_msg(FileSystem* filesystem) {
         case ERR_ENTAP_RUN_RSEM_EXPRESSION_PARSE:
             added_msg << "Ensure that RSEM ran properly and the output has sequences in it!";
             break;
+        case ERR_ENTAP_RUN_EXPRESSION_EM:
+            added_msg << "Ensure your BAM/SAM file was aligned against this transcriptome and that "
+                    "alignments of each read are grouped together (not coordinate sorted).";
+            break;
         case ERR_ENTAP_RUN_SIM_SEARCH_FILTER:
             added_msg << "Ensure the similarity searching finished properly and your output files"
                     " are not empty.";
@@ -195,7 +203,10 @@ void ExceptionHandler::print_msg(FileSystem* filesystem) {
 
     added_msg << "\n" << what();
     out_msg = added_msg.str();
-    if (filesystem != nullptr) FS_dprint(out_msg);
+    if (filesystem != nullptr) {
+        FS_dprint(out_msg, Logger::LOG_ERROR);
+        FS_debug_log().flush();     // Make sure error reaches debug file before exit
+    }
     std::cerr << out_msg << std::endl;
 }
 
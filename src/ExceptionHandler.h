@@ -66,10 +66,12 @@ enum entap_err {
     ERR_ENTAP_RUN_GENEMARK_PARSE          = 101u,
     ERR_ENTAP_RUN_GENEMARK_STATS          = 102u,
     ERR_ENTAP_RUN_GENEMARK_MOVE           = 103u,
+    ERR_ENTAP_RUN_ORF_FINDER              = 104u,
     ERR_ENTAP_RUN_RSEM_VALIDATE           = 110u,
     ERR_ENTAP_RUN_RSEM_CONVERT            = 111u,
     ERR_ENTAP_RUN_RSEM_EXPRESSION         = 112u,
     ERR_ENTAP_RUN_RSEM_EXPRESSION_PARSE   = 113u,
+    ERR_ENTAP_RUN_EXPRESSION_EM           = 114u,
     ERR_ENTAP_RUN_FILTER                  = 120u,
     ERR_ENTAP_RUN_SIM_SEARCH_FILTER       = 140u,
     ERR_ENTAP_RUN_SIM_SEARCH_RUN          = 141u,
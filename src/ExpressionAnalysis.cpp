@@ -28,6 +28,7 @@
 
 //*********************** Includes *****************************
 #include "ExpressionAnalysis.h"
+#include "Instrumentation.h"
 
 //**************************************************************
 
@@ -62,7 +63,7 @@ ExpressionAnalysis::ExpressionAnalysis(std::string &input,EntapDataPtrs& entap_d
 
     _entap_data = entap_data;
 
-    _software_flag = EXP_RSEM;
+    _software_flag = _pUserInput->get_user_input<uint16>(_pUserInput->INPUT_FLAG_EXP_SOFTWARE);
     _threads       = _pUserInput->get_supported_threads();
     _exepath       = RSEM_EXE_DIR;
     _outpath       = _pFileSystem->get_root_path();
@@ -81,8 +82,8 @@ ExpressionAnalysis::ExpressionAnalysis(std::string &input,EntapDataPtrs& entap_d
  * Function std::string ExpressionAnalysis::execute(std::string input)
  *
  * Description          - Entry into expression analysis
- *                      - Spawns whichever module user selects (currently
- *                        only RSEM)
+ *                      - Spawns whichever module user selects (RSEM or
+ *                        the built in EM quantification)
  *                      - Creates/removes output directories as instructed
  *
  * Notes                - Entry
@@ -106,8 +107,14 @@ std::string ExpressionAnalysis::execute(std::string input) {
         ptr = spawn_object();
         ptr->set_data(_threads, _fpkm, _issingle);  // Will remove later
         verify_data = ptr->verify_files();
-        if (!verify_data.files_exist) ptr->execute();
-        ptr->parse();
+        if (!verify_data.files_exist) {
+            Instrumentation::ScopedTimer timer("run");
+            ptr->execute();
+        }
+        {
+            Instrumentation::ScopedTimer timer("parse");
+            ptr->parse();
+        }
         output = ptr->get_final_fasta();
     } catch (const ExceptionHandler &e) {
         ptr.reset();
@@ -121,8 +128,8 @@ std::string ExpressionAnalysis::execute(std::string input) {
  * ======================================================================
  * Function std::unique_ptr<AbstractExpression> ExpressionAnalysis::spawn_object()
  *
- * Description          - Spawns module to be used within pipeline (currently
- *                        only RSEM)
+ * Description          - Spawns module to be used within pipeline, RSEM
+ *                        (default) or the built in EM quantification
  *
  * Notes                - None
  *
@@ -141,6 +148,16 @@ std::unique_ptr<AbstractExpression> ExpressionAnalysis::spawn_object() {
                     _exepath,
                     _alignpath
             ));
+#ifdef ENTAP_EM_QUANT
+        case EXP_EM_QUANT:
+            return std::unique_ptr<AbstractExpression>(new ModEMQuant(
+                    _rsem_dir,
+                    _inpath,
+                    _entap_data,
+                    _exepath,
+                    _alignpath
+            ));
+#endif
         default:
             return std::unique_ptr<AbstractExpression>(new ModRSEM(
                     _rsem_dir,
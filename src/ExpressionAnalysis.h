@@ -38,6 +38,7 @@
 #include "FileSystem.h"
 #include "expression/AbstractExpression.h"
 #include "expression/ModRSEM.h"
+#include "expression/ModEMQuant.h"
 
 class AbstractExpression;
 
@@ -0,0 +1,182 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "FastaScanner.h"
+#include "FileSystem.h"
+//**************************************************************
+
+
+FastaScanner::FastaScanner(const char *begin, const char *end) {
+    _begin = begin;
+    _pos   = begin;
+    _end   = end;
+}
+
+
+/**
+ * ======================================================================
+ * Function bool FastaScanner::next_record(FastaRecord &record)
+ *
+ * Description          - Finds the next record beginning with '>' at the
+ *                        start of a line and sets header/sequence views
+ *                      - Sequence block runs until the next record or end
+ *                        of buffer
+ *
+ * Notes                - Any data before the first header is skipped
+ *
+ * @param record        - Record to be populated
+ *
+ * @return              - False if no more records are in the buffer
+ *
+ * =====================================================================
+ */
+bool FastaScanner::next_record(FastaRecord &record) {
+    const char *header;
+    const char *header_end;
+    const char *seq_end;
+
+    // Find header, '>' must begin a line
+    header = _pos;
+    while (true) {
+        header = static_cast<const char*>(memchr(header, FileSystem::FASTA_FLAG, _end - header));
+        if (header == nullptr) {
+            _pos = _end;
+            return false;
+        }
+        if (header == _begin || header[-1] == '\n') break;
+        header++;
+    }
+
+    header_end = static_cast<const char*>(memchr(header, '\n', _end - header));
+    if (header_end == nullptr) header_end = _end;
+
+    record.header     = header;
+    record.header_len = (uint64) (header_end - header);
+    if (record.header_len > 0 && header[record.header_len - 1] == '\r') record.header_len--;
+
+    // Sequence runs until the next header line
+    record.sequence = header_end < _end ? header_end + 1 : _end;
+    seq_end = record.sequence;
+    while (true) {
+        seq_end = static_cast<const char*>(memchr(seq_end, FileSystem::FASTA_FLAG, _end - seq_end));
+        if (seq_end == nullptr) {
+            seq_end = _end;
+            break;
+        }
+        if (seq_end[-1] == '\n') break;
+        seq_end++;
+    }
+    record.sequence_len = (uint64) (seq_end - record.sequence);
+    _pos = seq_end;
+    return true;
+}
+
+uint64 FastaScanner::bytes_scanned() const {
+    return (uint64) (_pos - _begin);
+}
+
+
+/**
+ * ======================================================================
+ * Function const char *FastaScanner::next_line(const char *pos, const char *end,
+ *                                              const char *&line_end)
+ *
+ * Description          - Returns line starting at pos, setting line_end to
+ *                        the end of the line (newline/carriage return
+ *                        excluded)
+ *
+ * Notes                - None
+ *
+ * @param pos           - Start of line
+ * @param end           - End of buffer
+ * @param line_end      - Set to end of line content
+ *
+ * @return              - Start of next line (end if finished)
+ *
+ * =====================================================================
+ */
+const char *FastaScanner::next_line(const char *pos, const char *end, const char *&line_end) {
+    const char *newline;
+
+    newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    if (newline == nullptr) {
+        line_end = end;
+    } else {
+        line_end = newline;
+    }
+    if (line_end > pos && line_end[-1] == '\r') line_end--;
+    return newline == nullptr ? end : newline + 1;
+}
+
+
+/**
+ * ======================================================================
+ * Function std::vector<const char*> FastaScanner::split_records(const char *begin,
+ *                                              const char *end, uint32 chunks)
+ *
+ * Description          - Splits a buffer into roughly equal byte ranges
+ *                        that each begin on a record header, so ranges can
+ *                        be scanned independently
+ *
+ * Notes                - Ranges may be empty if a single record spans
+ *                        more than one split point
+ *
+ * @param begin         - Start of buffer
+ * @param end           - End of buffer
+ * @param chunks        - Number of ranges wanted
+ *
+ * @return              - chunks+1 boundaries, range i is [i, i+1)
+ *
+ * =====================================================================
+ */
+std::vector<const char*> FastaScanner::split_records(const char *begin, const char *end, uint32 chunks) {
+    std::vector<const char*> bounds;
+    const char              *split;
+    uint64                   size;
+
+    if (chunks == 0) chunks = 1;
+    size = (uint64) (end - begin);
+    bounds.push_back(begin);
+    for (uint32 i = 1; i < chunks; i++) {
+        split = begin + (size * i) / chunks;
+        if (split < bounds.back()) split = bounds.back();
+        // Move forward to the next header
+        while (split < end) {
+            split = static_cast<const char*>(memchr(split, FileSystem::FASTA_FLAG, end - split));
+            if (split == nullptr) {
+                split = end;
+                break;
+            }
+            if (split == begin || split[-1] == '\n') break;
+            split++;
+        }
+        bounds.push_back(split);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
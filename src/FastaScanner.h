@@ -0,0 +1,71 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ENTAP_FASTASCANNER_H
+#define ENTAP_FASTASCANNER_H
+
+//*********************** Includes *****************************
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * View of a single FASTA record inside a buffer. Nothing is copied, pointers
+ * remain valid for as long as the underlying buffer (mapping) does.
+ */
+struct FastaRecord {
+    const char *header;         // Start of header line, including '>'
+    uint64      header_len;     // Header length, newline excluded
+    const char *sequence;       // Start of sequence lines (may contain newlines)
+    uint64      sequence_len;   // Length of sequence block
+};
+
+
+/**
+ * Walks FASTA records in a memory buffer. Record and line boundaries are
+ * located with memchr, which libc implements with vector instructions.
+ */
+class FastaScanner {
+
+public:
+    FastaScanner(const char *begin, const char *end);
+
+    bool next_record(FastaRecord &record);
+    uint64 bytes_scanned() const;
+
+    static const char *next_line(const char *pos, const char *end, const char *&line_end);
+    static std::vector<const char*> split_records(const char *begin, const char *end, uint32 chunks);
+
+private:
+    const char *_begin;
+    const char *_pos;
+    const char *_end;
+};
+
+
+#endif //ENTAP_FASTASCANNER_H
@@ -101,7 +101,8 @@ void FileSystem::close_file(std::ofstream &ofstream) {
  * Description          - Handles printing to EnTAP debug file
  *                      - Adds bo to each entry
  *
- * Notes                - None
+ * Notes                - Message is queued and written by the debug
+ *                        logger's background thread (no file I/O here)
  *
  * @param msg           - Message to be sent to debug file
  * @return              - None
@@ -109,10 +110,23 @@ void FileSystem::close_file(std::ofstream &ofstream) {
  * =====================================================================
  */
 void FS_dprint(const std::string &msg) {
-    std::ofstream debug_file(DEBUG_FILE_PATH, std::ios::out | std::ios::app);
+    FS_debug_log().log(Logger::LOG_DEBUG, msg);
+}
+
+void FS_dprint(const std::string &msg, Logger::LOG_LEVELS level) {
+    FS_debug_log().log(level, msg);
+}
 
-    debug_file << get_cur_time() << ": " + msg << std::endl;
-    debug_file.close();
+// Debug file logger, opened by FileSystem::init_log
+Logger &FS_debug_log() {
+    static Logger debug_log(true);
+    return debug_log;
+}
+
+// Statistics/log file logger, opened by FileSystem::init_log
+static Logger &FS_stats_log() {
+    static Logger stats_log(false);
+    return stats_log;
 }
 
 
@@ -122,7 +136,7 @@ void FS_dprint(const std::string &msg) {
  *
  * Description          - Handles printing to EnTAP statistics/log file
  *
- * Notes                - None
+ * Notes                - Written asynchronously, like FS_dprint
  *
  * @param msg           - Message to be sent to log file
  * @return              - None
@@ -130,9 +144,7 @@ void FS_dprint(const std::string &msg) {
  * =====================================================================
  */
 void FileSystem::print_stats(std::string &msg) {
-    std::ofstream log_file(LOG_FILE_PATH, std::ios::out | std::ios::app);
-    log_file << msg << std::endl;
-    close_file(log_file);
+    FS_stats_log().log(Logger::LOG_INFO, msg);
 }
 
 
@@ -564,6 +576,11 @@ void FileSystem::init_log() {
     LOG_FILE_PATH   = PATHS(_root_path, log_file_name);
     delete_file(DEBUG_FILE_PATH);
     delete_file(LOG_FILE_PATH);
+    FS_debug_log().open(DEBUG_FILE_PATH);
+#ifdef ENTAP_HOT_LOG
+    FS_debug_log().set_level(Logger::LOG_TRACE);
+#endif
+    FS_stats_log().open(LOG_FILE_PATH);
     FS_dprint("Start - EnTAP");
 }
 
@@ -877,7 +894,7 @@ std::string FileSystem::get_extension(FileSystem::ENT_FILE_TYPES type) {
     }
 }
 
-bool FileSystem::initialize_file(std::ofstream *file_stream, std::vector<ENTAP_HEADERS> &headers,
+bool FileSystem::initialize_file(std::ostream *file_stream, std::vector<ENTAP_HEADERS> &headers,
                                  FileSystem::ENT_FILE_TYPES type) {
     bool ret;
 
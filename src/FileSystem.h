@@ -33,11 +33,21 @@
 #include "common.h"
 #include "TerminalCommands.h"
 #include "EntapGlobals.h"
+#include "Logger.h"
 //**************************************************************
 
 
 // Keeping global for now
 void FS_dprint(const std::string&);
+void FS_dprint(const std::string&, Logger::LOG_LEVELS);
+Logger &FS_debug_log();
+
+// Debug output inside hot loops, compiled out unless built with ENTAP_HOT_LOG
+#ifdef ENTAP_HOT_LOG
+#define FS_DPRINT_HOT(x)    FS_dprint(x, Logger::LOG_TRACE)
+#else
+#define FS_DPRINT_HOT(x)    do {} while (0)
+#endif
 
 //***************** Global Prototype Functions *****************
 class FileSystem {
@@ -113,7 +123,7 @@ public:
     bool decompress_file(std::string &in_path, std::string &out_dir, ENT_FILE_TYPES);
 
     bool print_headers(std::ofstream &file_stream, std::vector<ENTAP_HEADERS> &headers, char delim);
-    bool initialize_file(std::ofstream *file_stream, std::vector<ENTAP_HEADERS> &headers, ENT_FILE_TYPES type);
+    bool initialize_file(std::ostream *file_stream, std::vector<ENTAP_HEADERS> &headers, ENT_FILE_TYPES type);
     void format_stat_stream(std::stringstream &stream, std::string title);
 
 //**************************************************************
@@ -31,6 +31,8 @@
 #include "ExceptionHandler.h"
 #include "EntapGlobals.h"
 #include "frame_selection/ModGeneMarkST.h"
+#include "frame_selection/ModOrfFinder.h"
+#include "Instrumentation.h"
 #include "FileSystem.h"
 //**************************************************************
 
@@ -69,7 +71,7 @@ FrameSelection::FrameSelection(std::string &input, EntapDataPtrs &entap_data) {
 
     _outpath         = _pFileSystem->get_root_path();
     _overwrite       = _pUserInput->has_input(_pUserInput->INPUT_FLAG_OVERWRITE);
-    _software_flag   = FRAME_GENEMARK_ST;
+    _software_flag   = _pUserInput->get_user_input<uint16>(_pUserInput->INPUT_FLAG_FRAME_SOFTWARE);
 
     _mod_out_dir   = PATHS(_outpath, FRAME_SELECTION_OUT_DIR);
 }
@@ -107,10 +109,14 @@ std::string FrameSelection::execute(std::string input) {
         ptr = spawn_object();
         verify_data = ptr->verify_files();
         if (!verify_data.files_exist) {
+            Instrumentation::ScopedTimer timer("run");
             ptr->execute();
             output = ptr->get_final_faa();
         } else output = verify_data.output_paths[0];
-        ptr->parse();
+        {
+            Instrumentation::ScopedTimer timer("parse");
+            ptr->parse();
+        }
         ptr.reset();
         return output;
     } catch (const ExceptionHandler &e) {
@@ -126,7 +132,7 @@ std::string FrameSelection::execute(std::string input) {
  *
  * Description           - Spawns object for specified frame selection software
  *
- * Notes                 - Currently only GeneMarkS-T support
+ * Notes                 - GeneMarkS-T (default) or the built in ORF finder
  *
  *
  * @return               - Frame Selection module object
@@ -144,6 +150,13 @@ std::unique_ptr<AbstractFrame> FrameSelection::spawn_object() {
                     _entap_data_ptrs,
                     _exe_path
             ));
+        case FRAME_ORF_FINDER:
+            return std::unique_ptr<AbstractFrame>(new ModOrfFinder(
+                    _mod_out_dir,
+                    _inpath,
+                    _entap_data_ptrs,
+                    _exe_path
+            ));
         default:
             return std::unique_ptr<AbstractFrame>(new ModGeneMarkST(
                     _mod_out_dir,
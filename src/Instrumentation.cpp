@@ -0,0 +1,296 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "Instrumentation.h"
+#include <mutex>
+#include <memory>
+//**************************************************************
+
+struct Instrumentation::Registry {
+    std::mutex                                        lock;
+    std::vector<StageStats>                           stages;     // First start order
+    std::vector<CommandStats>                         commands;
+    std::map<std::string, std::unique_ptr<Counter>>   counters;
+};
+
+static thread_local std::vector<std::string> timer_stack;     // Open timer paths on this thread
+
+
+Instrumentation::ScopedTimer::ScopedTimer(const std::string &name) {
+    _path = timer_stack.empty() ? name : timer_stack.back() + "/" + name;
+    timer_stack.push_back(_path);
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.lock);
+        get_stage(reg, _path);          // Keeps report in start order
+    }
+    getrusage(RUSAGE_SELF, &_self_start);
+    getrusage(RUSAGE_CHILDREN, &_child_start);
+    _start = std::chrono::steady_clock::now();
+}
+
+Instrumentation::ScopedTimer::~ScopedTimer() {
+    struct rusage self_end;
+    struct rusage child_end;
+    fp64          wall_secs;
+
+    wall_secs = std::chrono::duration<fp64>(std::chrono::steady_clock::now() - _start).count();
+    getrusage(RUSAGE_SELF, &self_end);
+    getrusage(RUSAGE_CHILDREN, &child_end);
+    if (!timer_stack.empty()) timer_stack.pop_back();
+    add_stage(_path, wall_secs, _self_start, self_end, _child_start, child_end);
+}
+
+
+Instrumentation::Registry &Instrumentation::registry() {
+    static Registry registry;
+    return registry;
+}
+
+
+// Returns counter for name (created at 0), reference stays valid, cache it outside loops
+Instrumentation::Counter &Instrumentation::counter(const std::string &name) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.lock);
+    std::unique_ptr<Counter> &ret = reg.counters[name];
+
+    if (ret == nullptr) ret.reset(new Counter(0));
+    return *ret;
+}
+
+
+/**
+ * ======================================================================
+ * Function void Instrumentation::add_command(const std::string &command,
+ *                                            const std::string &stage, int status,
+ *                                            fp64 wall_secs,
+ *                                            const struct rusage &child_start,
+ *                                            const struct rusage &child_end)
+ *
+ * Description          - Records an external command run
+ *
+ * Notes                - CPU time is the RUSAGE_CHILDREN difference across
+ *                        the command, commands running at the same time
+ *                        share what was reaped while they ran
+ *                      - Max RSS is the largest child reaped so far
+ *
+ * @param command       - Command that was executed
+ * @param stage         - Stage to record command under, current stage of
+ *                        the calling thread if empty
+ * @param status        - Exit status
+ * @param wall_secs     - Wall time of command
+ * @param child_start   - RUSAGE_CHILDREN before command
+ * @param child_end     - RUSAGE_CHILDREN after command
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void Instrumentation::add_command(const std::string &command, const std::string &stage, int status,
+                                  fp64 wall_secs, const struct rusage &child_start,
+                                  const struct rusage &child_end) {
+    CommandStats stats;
+    uint64       pos;
+
+    // Program is the basename of the first token
+    stats.program = command.substr(0, command.find_first_of(" \t\n"));
+    pos = stats.program.rfind('/');
+    if (pos != std::string::npos) stats.program = stats.program.substr(pos + 1);
+    stats.command    = command;
+    stats.stage      = stage.empty() ? current_stage() : stage;
+    stats.status     = status;
+    stats.wall_secs  = wall_secs;
+    stats.user_secs  = cpu_secs(child_start.ru_utime, child_end.ru_utime);
+    stats.sys_secs   = cpu_secs(child_start.ru_stime, child_end.ru_stime);
+    stats.max_rss_kb = (uint64) child_end.ru_maxrss;
+
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.lock);
+    reg.commands.push_back(stats);
+}
+
+
+void Instrumentation::add_stage(const std::string &path, fp64 wall_secs, const struct rusage &self_start,
+                                const struct rusage &self_end, const struct rusage &child_start,
+                                const struct rusage &child_end) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.lock);
+    StageStats *stats = &get_stage(reg, path);
+
+    stats->calls++;
+    stats->wall_secs       += wall_secs;
+    stats->user_secs       += cpu_secs(self_start.ru_utime, self_end.ru_utime);
+    stats->sys_secs        += cpu_secs(self_start.ru_stime, self_end.ru_stime);
+    stats->child_user_secs += cpu_secs(child_start.ru_utime, child_end.ru_utime);
+    stats->child_sys_secs  += cpu_secs(child_start.ru_stime, child_end.ru_stime);
+    stats->peak_rss_kb      = std::max(stats->peak_rss_kb, (uint64) self_end.ru_maxrss);
+}
+
+
+// Finds stage by path, added if not yet seen (caller holds registry lock)
+Instrumentation::StageStats &Instrumentation::get_stage(Registry &reg, const std::string &path) {
+    for (StageStats &stage : reg.stages) {
+        if (stage.path == path) return stage;
+    }
+    reg.stages.push_back(StageStats());
+    reg.stages.back().path = path;
+    return reg.stages.back();
+}
+
+
+// Innermost timer open on the calling thread, timers on other threads are not seen
+std::string Instrumentation::current_stage() {
+    return timer_stack.empty() ? "" : timer_stack.back();
+}
+
+
+fp64 Instrumentation::cpu_secs(const struct timeval &start, const struct timeval &end) {
+    return (fp64) (end.tv_sec - start.tv_sec) + (fp64) (end.tv_usec - start.tv_usec) / 1000000.0;
+}
+
+
+std::string Instrumentation::json_escape(const std::string &str) {
+    std::string ret;
+    char        hex[8];
+
+    for (char c : str) {
+        switch (c) {
+            case '"':  ret += "\\\""; break;
+            case '\\': ret += "\\\\"; break;
+            case '\n': ret += "\\n";  break;
+            case '\t': ret += "\\t";  break;
+            case '\r': ret += "\\r";  break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    snprintf(hex, sizeof(hex), "\\u%04x", (unsigned char) c);
+                    ret += hex;
+                } else {
+                    ret += c;
+                }
+                break;
+        }
+    }
+    return ret;
+}
+
+
+/**
+ * ======================================================================
+ * Function bool Instrumentation::write_json(const std::string &path)
+ *
+ * Description          - Writes stages, external commands and counters
+ *                        recorded so far as JSON
+ *
+ * Notes                - Times in seconds, memory in KB (ru_maxrss)
+ *
+ * @param path          - Output path (timings.json)
+ *
+ * @return              - True if written
+ *
+ * =====================================================================
+ */
+bool Instrumentation::write_json(const std::string &path) {
+    Registry         &reg = registry();
+    std::ofstream     file(path, std::ios::out | std::ios::trunc);
+    struct rusage     self_usage;
+    uint64            i = 0;
+
+    if (!file.is_open()) return false;
+    getrusage(RUSAGE_SELF, &self_usage);
+
+    std::lock_guard<std::mutex> lock(reg.lock);
+    file << std::fixed << std::setprecision(3);
+    file << "{\n  \"peak_rss_kb\": " << self_usage.ru_maxrss << ",\n  \"stages\": [";
+    for (StageStats &stage : reg.stages) {
+        file << (i++ ? ",\n" : "\n") <<
+             "    {\"name\": \""          << json_escape(stage.path) << "\"" <<
+             ", \"calls\": "              << stage.calls           <<
+             ", \"wall_secs\": "          << stage.wall_secs       <<
+             ", \"cpu_user_secs\": "      << stage.user_secs       <<
+             ", \"cpu_sys_secs\": "       << stage.sys_secs        <<
+             ", \"child_cpu_user_secs\": "<< stage.child_user_secs <<
+             ", \"child_cpu_sys_secs\": " << stage.child_sys_secs  <<
+             ", \"peak_rss_kb\": "        << stage.peak_rss_kb     << "}";
+    }
+    file << "\n  ],\n  \"commands\": [";
+    i = 0;
+    for (CommandStats &command : reg.commands) {
+        file << (i++ ? ",\n" : "\n") <<
+             "    {\"program\": \""       << json_escape(command.program) << "\"" <<
+             ", \"stage\": \""            << json_escape(command.stage)   << "\"" <<
+             ", \"exit_status\": "        << command.status     <<
+             ", \"wall_secs\": "          << command.wall_secs  <<
+             ", \"cpu_user_secs\": "      << command.user_secs  <<
+             ", \"cpu_sys_secs\": "       << command.sys_secs   <<
+             ", \"max_rss_kb\": "         << command.max_rss_kb <<
+             ", \"command\": \""          << json_escape(command.command) << "\"}";
+    }
+    file << "\n  ],\n  \"counters\": {";
+    i = 0;
+    for (auto &pair : reg.counters) {
+        file << (i++ ? ",\n" : "\n") << "    \"" << json_escape(pair.first) << "\": " << pair.second->load();
+    }
+    file << "\n  }\n}\n";
+    file.close();
+    return !file.fail();
+}
+
+
+// Readable version of write_json for the log file, commands totalled per program
+std::string Instrumentation::summary() {
+    Registry         &reg = registry();
+    std::stringstream out;
+    std::map<std::string, CommandStats> programs;
+
+    std::lock_guard<std::mutex> lock(reg.lock);
+    out << std::fixed << std::setprecision(2);
+    out << "Stage timings (wall / EnTAP CPU / child CPU seconds, peak memory):";
+    for (StageStats &stage : reg.stages) {
+        out << "\n  " << stage.path << ": " << stage.wall_secs << "s / " <<
+            stage.user_secs + stage.sys_secs << "s / " << stage.child_user_secs + stage.child_sys_secs <<
+            "s, " << stage.peak_rss_kb / 1024 << " MB";
+        if (stage.calls > 1) out << " (" << stage.calls << " runs)";
+    }
+    for (CommandStats &command : reg.commands) {
+        CommandStats &total = programs[command.program];
+        total.status++;                 // Used as run count
+        total.wall_secs += command.wall_secs;
+        total.user_secs += command.user_secs + command.sys_secs;
+        total.max_rss_kb = std::max(total.max_rss_kb, command.max_rss_kb);
+    }
+    if (!programs.empty()) out << "\nExternal commands (wall / CPU seconds, peak memory):";
+    for (auto &pair : programs) {
+        out << "\n  " << pair.first << " x" << pair.second.status << ": " << pair.second.wall_secs <<
+            "s / " << pair.second.user_secs << "s, " << pair.second.max_rss_kb / 1024 << " MB";
+    }
+    if (!reg.counters.empty()) out << "\nCounters:";
+    for (auto &pair : reg.counters) {
+        out << "\n  " << pair.first << ": " << pair.second->load();
+    }
+    return out.str();
+}
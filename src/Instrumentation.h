@@ -0,0 +1,110 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_INSTRUMENTATION_H
+#define ENTAP_INSTRUMENTATION_H
+
+//*********************** Includes *****************************
+#include <atomic>
+#include <sys/resource.h>
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * Run time instrumentation. Scoped timers record wall time, CPU time of
+ * EnTAP itself and of child processes, and the peak memory of each stage.
+ * External commands are recorded by TC_execute_cmd. Named counters keep
+ * things like rows parsed and database lookups. A JSON report
+ * (timings.json) and a readable summary for the log are produced at exit.
+ *
+ * Timers nest on the thread that creates them ("similarity_search/parse")
+ * and should only be created on orchestrating threads, not per row.
+ */
+class Instrumentation {
+
+public:
+    typedef std::atomic<uint64> Counter;
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const std::string &name);
+        ~ScopedTimer();
+
+    private:
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        std::string                           _path;
+        std::chrono::steady_clock::time_point _start;
+        struct rusage                         _self_start;
+        struct rusage                         _child_start;
+    };
+
+    static Counter &counter(const std::string &name);
+    static void add_command(const std::string &command, const std::string &stage, int status, fp64 wall_secs,
+                            const struct rusage &child_start, const struct rusage &child_end);
+    static bool write_json(const std::string &path);
+    static std::string summary();
+    static std::string current_stage();
+
+private:
+    struct StageStats {
+        std::string path;
+        uint64      calls;
+        fp64        wall_secs;
+        fp64        user_secs;
+        fp64        sys_secs;
+        fp64        child_user_secs;
+        fp64        child_sys_secs;
+        uint64      peak_rss_kb;        // Process high water mark when stage ended
+    };
+
+    struct CommandStats {
+        std::string program;
+        std::string command;
+        std::string stage;
+        int         status;
+        fp64        wall_secs;
+        fp64        user_secs;
+        fp64        sys_secs;
+        uint64      max_rss_kb;         // Largest child waited for so far
+    };
+
+    struct Registry;
+
+    static Registry &registry();
+    static StageStats &get_stage(Registry &reg, const std::string &path);
+    static void add_stage(const std::string &path, fp64 wall_secs, const struct rusage &self_start,
+                          const struct rusage &self_end, const struct rusage &child_start,
+                          const struct rusage &child_end);
+    static fp64 cpu_secs(const struct timeval &start, const struct timeval &end);
+    static std::string json_escape(const std::string &str);
+};
+
+
+#endif //ENTAP_INSTRUMENTATION_H
@@ -0,0 +1,223 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "Logger.h"
+#include <chrono>
+//**************************************************************
+
+constexpr uint32 Logger::RING_SIZE;
+constexpr uint32 Logger::FLUSH_INTERVAL_MS;
+
+
+Logger::Logger(bool timestamps) {
+    _file       = nullptr;
+    _timestamps = timestamps;
+    _level      = LOG_DEBUG;
+    _open       = false;
+    _stop       = false;
+    _tail       = 0;
+    _head       = 0;
+    _drained    = 0;
+    _time_last  = 0;
+    _slots.reset(new LogSlot[RING_SIZE]);
+    for (uint32 i = 0; i < RING_SIZE; i++) _slots[i].sequence = i;
+}
+
+Logger::~Logger() {
+    close();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool Logger::open(const std::string &path)
+ *
+ * Description          - Opens log file (appending) and starts the
+ *                        background flusher
+ *
+ * Notes                - Messages logged before open are dropped
+ *
+ * @param path          - Path to log file
+ *
+ * @return              - True if opened successfully
+ *
+ * =====================================================================
+ */
+bool Logger::open(const std::string &path) {
+    close();
+    _file = fopen(path.c_str(), "a");
+    if (_file == nullptr) return false;
+    _stop    = false;
+    _flusher = std::thread(&Logger::flush_loop, this);
+    _open    = true;
+    return true;
+}
+
+
+// Writes everything queued, stops flusher and closes file
+void Logger::close() {
+    if (!_open) return;
+    _open = false;
+    {
+        std::lock_guard<std::mutex> lock(_flush_lock);
+        _stop = true;
+    }
+    _flush_cv.notify_all();
+    _flusher.join();
+    fclose(_file);
+    _file = nullptr;
+}
+
+
+// Blocks until every message queued so far has been written
+void Logger::flush() {
+    uint64 target = _tail.load();
+
+    if (!_open) return;
+    std::unique_lock<std::mutex> lock(_flush_lock);
+    _flush_cv.notify_all();
+    while (_drained.load() < target && _open) {
+        _drained_cv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void Logger::log(LOG_LEVELS level, const std::string &msg)
+ *
+ * Description          - Queues a message to be written by the flusher
+ *
+ * Notes                - Lock free unless the ring is full, in which case
+ *                        the flusher is woken and the caller waits on it
+ *
+ * @param level         - Level of message, dropped if below current level
+ * @param msg           - Message (newline is added)
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void Logger::log(LOG_LEVELS level, const std::string &msg) {
+    time_t time;
+
+    if (!is_enabled(level)) return;
+    time = _timestamps ? std::time(nullptr) : 0;
+    while (!push(time, msg)) {
+        _flush_cv.notify_all();
+        std::this_thread::yield();
+        if (!_open) return;
+    }
+}
+
+void Logger::set_level(LOG_LEVELS level) {
+    _level = level;
+}
+
+bool Logger::is_enabled(LOG_LEVELS level) const {
+    return level >= _level.load(std::memory_order_relaxed) && _open.load(std::memory_order_relaxed);
+}
+
+
+// Claims a slot in the ring (multi producer), false if ring is full
+bool Logger::push(time_t time, const std::string &msg) {
+    LogSlot *slot;
+    uint64   pos = _tail.load(std::memory_order_relaxed);
+    int64    diff;
+
+    while (true) {
+        slot = &_slots[pos & (RING_SIZE - 1)];
+        diff = (int64) slot->sequence.load(std::memory_order_acquire) - (int64) pos;
+        if (diff == 0) {
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _tail.load(std::memory_order_relaxed);
+        }
+    }
+    slot->time = time;
+    slot->msg.assign(msg);      // Slot keeps its capacity, no allocation once warm
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+
+// Writes all published slots to file (flusher thread only), false if none
+bool Logger::drain() {
+    LogSlot *slot;
+    uint64   count = 0;
+
+    while (true) {
+        slot = &_slots[_head & (RING_SIZE - 1)];
+        if (slot->sequence.load(std::memory_order_acquire) != _head + 1) break;
+        if (_timestamps) {
+            format_time(slot->time);
+            _buffer += _time_str;
+            _buffer += ": ";
+        }
+        _buffer += slot->msg;
+        _buffer += '\n';
+        slot->sequence.store(_head + RING_SIZE, std::memory_order_release);
+        _head++;
+        count++;
+    }
+    if (count == 0) return false;
+    fwrite(_buffer.data(), 1, _buffer.size(), _file);
+    fflush(_file);
+    _buffer.clear();
+    _drained += count;
+    _drained_cv.notify_all();
+    return true;
+}
+
+
+void Logger::flush_loop() {
+    while (true) {
+        drain();
+        std::unique_lock<std::mutex> lock(_flush_lock);
+        if (_stop) break;
+        _flush_cv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+    }
+    drain();
+}
+
+
+// Same format as get_cur_time, only reformatted when the second changes
+void Logger::format_time(time_t time) {
+    char buf[32];
+
+    if (time == _time_last && !_time_str.empty()) return;
+    if (ctime_r(&time, buf) == nullptr) {
+        _time_str.clear();
+        return;
+    }
+    _time_str = buf;
+    if (!_time_str.empty() && _time_str.back() == '\n') _time_str.pop_back();
+    _time_last = time;
+}
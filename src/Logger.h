@@ -0,0 +1,108 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_LOGGER_H
+#define ENTAP_LOGGER_H
+
+//*********************** Includes *****************************
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * Asynchronous line logger. Callers push messages into a fixed size lock
+ * free ring (no locks or file I/O on the calling thread) and a background
+ * thread drains it to the file, formatting timestamps and flushing every
+ * FLUSH_INTERVAL_MS. Messages below the current level are dropped before
+ * they are queued. If the ring is full callers wait for the flusher rather
+ * than drop messages. Queued messages are written on close/destruction.
+ */
+class Logger {
+
+public:
+    typedef enum {
+        LOG_TRACE=0,        // Progress inside hot loops (see FS_DPRINT_HOT)
+        LOG_DEBUG,
+        LOG_INFO,
+        LOG_WARN,
+        LOG_ERROR,
+
+        LOG_LEVEL_MAX
+    } LOG_LEVELS;
+
+    Logger(bool timestamps);
+    ~Logger();
+
+    bool open(const std::string &path);
+    void close();
+    void flush();
+    void log(LOG_LEVELS level, const std::string &msg);
+    void set_level(LOG_LEVELS level);
+    bool is_enabled(LOG_LEVELS level) const;
+
+    static constexpr uint32 RING_SIZE = 4096;           // Must be a power of 2
+    static constexpr uint32 FLUSH_INTERVAL_MS = 100;
+
+private:
+    struct LogSlot {
+        std::atomic<uint64> sequence;
+        time_t              time;
+        std::string         msg;
+    };
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    bool push(time_t time, const std::string &msg);
+    bool drain();
+    void flush_loop();
+    void format_time(time_t time);
+
+    FILE                   *_file;
+    bool                    _timestamps;
+    std::atomic<int>        _level;
+    std::atomic<bool>       _open;
+    std::atomic<bool>       _stop;
+    std::atomic<uint64>     _tail;          // Next slot to push (producers)
+    uint64                  _head;          // Next slot to drain (flusher only)
+    std::atomic<uint64>     _drained;       // Messages written so far
+    std::unique_ptr<LogSlot[]> _slots;
+    std::string             _buffer;        // Flusher output buffer
+    std::string             _time_str;      // Last formatted timestamp
+    time_t                  _time_last;
+    std::thread             _flusher;
+    std::mutex              _flush_lock;
+    std::condition_variable _flush_cv;
+    std::condition_variable _drained_cv;
+};
+
+
+#endif //ENTAP_LOGGER_H
@@ -0,0 +1,176 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "MappedFile.h"
+#include "FileSystem.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+//**************************************************************
+
+
+MappedFile::MappedFile() {
+    _fd   = -1;
+    _data = nullptr;
+    _size = 0;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool MappedFile::open(const std::string &path)
+ *
+ * Description          - Maps an entire file read-only into memory
+ *                      - Empty files are opened successfully with a null
+ *                        data pointer and size of 0
+ *
+ * Notes                - Any previous mapping is released
+ *
+ * @param path          - Path to file
+ *
+ * @return              - True if the file was mapped
+ *
+ * =====================================================================
+ */
+bool MappedFile::open(const std::string &path) {
+    struct stat file_stat;
+    void       *mapping;
+
+    close();
+
+    _fd = ::open(path.c_str(), O_RDONLY);
+    if (_fd < 0) {
+        FS_dprint("Unable to open file for mapping: " + path);
+        return false;
+    }
+
+    if (fstat(_fd, &file_stat) != 0) {
+        FS_dprint("Unable to stat file for mapping: " + path);
+        close();
+        return false;
+    }
+
+    _size = (uint64) file_stat.st_size;
+    if (_size == 0) return true;
+
+    mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (mapping == MAP_FAILED) {
+        FS_dprint("Unable to map file: " + path);
+        close();
+        return false;
+    }
+    _data = static_cast<char*>(mapping);
+
+    // We almost always read front to back
+    madvise(_data, _size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data != nullptr) {
+        munmap(_data, _size);
+        _data = nullptr;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _size = 0;
+}
+
+bool MappedFile::is_open() const {
+    return _fd >= 0;
+}
+
+const char *MappedFile::data() const {
+    return _data;
+}
+
+const char *MappedFile::end() const {
+    return _data + _size;
+}
+
+uint64 MappedFile::size() const {
+    return _size;
+}
+
+// Size and modification time of a file, used to tell when a file built from it is stale
+bool MappedFile::get_file_stamp(const std::string &path, uint64 &size, int64 &mtime) {
+    struct stat file_stat;
+
+    if (stat(path.c_str(), &file_stat) != 0) return false;
+    size  = (uint64) file_stat.st_size;
+    mtime = (int64) file_stat.st_mtime;
+    return true;
+}
+
+
+/**
+ * ======================================================================
+ * Function std::vector<const char*> MappedFile::split_lines(const char *begin,
+ *                                              const char *end, uint32 chunks)
+ *
+ * Description          - Splits a buffer into roughly equal byte ranges
+ *                        that each begin at the start of a line, so
+ *                        line based formats can be parsed independently
+ *
+ * Notes                - Ranges may be empty for very long lines
+ *
+ * @param begin         - Start of buffer
+ * @param end           - End of buffer
+ * @param chunks        - Number of ranges wanted
+ *
+ * @return              - chunks+1 boundaries, range i is [i, i+1)
+ *
+ * =====================================================================
+ */
+std::vector<const char*> MappedFile::split_lines(const char *begin, const char *end, uint32 chunks) {
+    std::vector<const char*> bounds;
+    const char              *split;
+    uint64                   size;
+
+    if (chunks == 0) chunks = 1;
+    size = (uint64) (end - begin);
+    bounds.push_back(begin);
+    for (uint32 i = 1; i < chunks; i++) {
+        split = begin + (size * i) / chunks;
+        if (split <= bounds.back()) split = bounds.back();
+        if (split > begin && split < end && split[-1] != '\n') {
+            split = static_cast<const char*>(memchr(split, '\n', end - split));
+            split = split == nullptr ? end : split + 1;
+        }
+        bounds.push_back(split);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
@@ -0,0 +1,68 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ENTAP_MAPPEDFILE_H
+#define ENTAP_MAPPEDFILE_H
+
+//*********************** Includes *****************************
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * Read-only memory mapping of a file on disk. Pages are pulled in by the
+ * kernel on demand and shared between processes mapping the same file.
+ * Mapping is released when the object is destroyed.
+ */
+class MappedFile {
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    const char *data() const;
+    const char *end() const;
+    uint64 size() const;
+
+    static std::vector<const char*> split_lines(const char *begin, const char *end, uint32 chunks);
+    static bool get_file_stamp(const std::string &path, uint64 &size, int64 &mtime);
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    int         _fd;
+    char       *_data;
+    uint64      _size;
+};
+
+
+#endif //ENTAP_MAPPEDFILE_H
@@ -33,6 +33,7 @@
 #include "ontology/ModInterpro.h"
 #include "FileSystem.h"
 #include "ontology/ModEggnogDMND.h"
+#include "Instrumentation.h"
 #include "similarity_search/ModDiamond.h"
 
 /**
@@ -117,11 +118,18 @@ void Ontology::execute() {
         for (uint16 software : _software_flags) {
             ptr = spawn_object(software);
             verify_data = ptr->verify_files();
-            if (!verify_data.files_exist) ptr->execute();
-            ptr->parse();
+            if (!verify_data.files_exist) {
+                Instrumentation::ScopedTimer timer("run");
+                ptr->execute();
+            }
+            {
+                Instrumentation::ScopedTimer timer("parse");
+                ptr->parse();
+            }
             ptr.reset();
         }
-        print_eggnog(*_pQueryData->get_sequences_ptr());
+        Instrumentation::ScopedTimer timer("output");
+        print_eggnog();
     } catch (ExceptionHandler &e) {
         ptr.reset();
         throw e;
@@ -187,26 +195,27 @@ std::unique_ptr<AbstractOntology> Ontology::spawn_object(uint16 &software) {
 
 /**
  * ======================================================================
- * Function void Ontology::print_eggnog(QUERY_MAP_T &SEQUENCES)
+ * Function void Ontology::print_eggnog()
  *
  * Description          - Handles printing of final annotation output
  *                      - Current prints tsv file for all go levels specified,
  *                        no contam + contam files
  *
- * Notes                - None
- *
- * @param SEQUENCES     - Map of sequence data
+ * Notes                - Rows are formatted in parallel and written in
+ *                        output order (QueryData::write_alignment_rows)
  *
  * @return              - None
  *
  * =====================================================================
  */
-void Ontology::print_eggnog(QUERY_MAP_T &SEQUENCES) {
+void Ontology::print_eggnog() {
     FS_dprint("Beginning to print final results...");
 
     std::string final_annotations_base;
     std::string final_annotations_contam_base;
     std::string final_annotations_no_contam_base;
+    std::vector<std::string> contam_paths;      // Files every contaminant is written to (all levels)
+    std::vector<std::string> no_contam_paths;
 
     // TODO move to QueryData
     // Create output files for go levels (contaminants, no contam, all) and write headers
@@ -220,19 +229,26 @@ void Ontology::print_eggnog(QUERY_MAP_T &SEQUENCES) {
         _pQueryData->start_alignment_files(final_annotations_contam_base, _HEADERS, (uint8)lvl, _alignment_file_types);
         _pQueryData->start_alignment_files(final_annotations_no_contam_base, _HEADERS,(uint8) lvl, _alignment_file_types);
 
-        for (auto &pair : SEQUENCES) {
-            _pQueryData->add_alignment_data(final_annotations_base, pair.second, nullptr);
+        contam_paths.push_back(final_annotations_base);
+        contam_paths.push_back(final_annotations_contam_base);
+        no_contam_paths.push_back(final_annotations_base);
+        no_contam_paths.push_back(final_annotations_no_contam_base);
+    }
 
-            if (pair.second->isContaminant()) {
-                _pQueryData->add_alignment_data(final_annotations_contam_base, pair.second, nullptr);
-            } else {
-                _pQueryData->add_alignment_data(final_annotations_no_contam_base, pair.second, nullptr);
-            }
+    // Single pass, each sequence is formatted once for every level (across threads)
+    std::vector<QuerySequence*> sequences = _pQueryData->get_output_order();
+    _pQueryData->write_alignment_rows(sequences.size(), [&](uint64 i) {
+        if (sequences[i]->isContaminant()) {
+            _pQueryData->add_alignment_data(contam_paths, sequences[i]);
+        } else {
+            _pQueryData->add_alignment_data(no_contam_paths, sequences[i]);
         }
+    });
 
-        _pQueryData->end_alignment_files(final_annotations_base);
-        _pQueryData->end_alignment_files(final_annotations_contam_base);
-        _pQueryData->end_alignment_files(final_annotations_no_contam_base);
+    for (uint64 i = 0; i < contam_paths.size(); i += 2) {
+        _pQueryData->end_alignment_files(contam_paths[i]);          // All
+        _pQueryData->end_alignment_files(contam_paths[i + 1]);      // Contaminants
+        _pQueryData->end_alignment_files(no_contam_paths[i + 1]);   // No contaminants
     }
     FS_dprint("Success!");
 }
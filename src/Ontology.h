@@ -77,7 +77,7 @@ private:
     EntapDataPtrs                   _entap_data_ptrs;
     std::vector<FileSystem::ENT_FILE_TYPES> _alignment_file_types;
 
-    void print_eggnog(QUERY_MAP_T&);
+    void print_eggnog();
     void init_headers();
     std::unique_ptr<AbstractOntology> spawn_object(uint16&);
 };
@@ -0,0 +1,135 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "OutputWriter.h"
+#include "FileSystem.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+//**************************************************************
+
+
+OutputWriter::OutputWriter() {
+    _fd   = -1;
+    _good = false;
+}
+
+OutputWriter::~OutputWriter() {
+    close();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool OutputWriter::open(const std::string &path, bool append)
+ *
+ * Description          - Opens (creates if needed) a file for writing
+ *
+ * Notes                - Any file already open is closed first
+ *
+ * @param path          - Path to file
+ * @param append        - Append to file rather than truncate it
+ *
+ * @return              - True if opened successfully
+ *
+ * =====================================================================
+ */
+bool OutputWriter::open(const std::string &path, bool append) {
+    int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+
+    close();
+    _fd = ::open(path.c_str(), flags, 0644);
+    if (_fd < 0) {
+        FS_dprint("Unable to open output file: " + path);
+        return false;
+    }
+    _good = true;
+    _buffer.reserve(BUFFER_SIZE);
+    return true;
+}
+
+bool OutputWriter::close() {
+    bool ret;
+
+    if (_fd < 0) return true;
+    ret = flush();
+    ::close(_fd);
+    _fd = -1;
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+    return ret;
+}
+
+
+bool OutputWriter::flush() {
+    if (_fd < 0) return false;
+    write_out(_buffer.data(), _buffer.size());
+    _buffer.clear();
+    return _good;
+}
+
+
+// Hands data to the kernel, retrying partial writes
+void OutputWriter::write_out(const char *data, uint64 len) {
+    ssize_t written;
+
+    while (len > 0 && _good) {
+        written = ::write(_fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            _good = false;
+            break;
+        }
+        data += written;
+        len  -= (uint64) written;
+    }
+}
+
+bool OutputWriter::is_open() const {
+    return _fd >= 0;
+}
+
+bool OutputWriter::good() const {
+    return _good;
+}
+
+void OutputWriter::write(const char *data, uint64 len) {
+    if (_buffer.size() + len > BUFFER_SIZE) {
+        flush();
+        // Larger than the whole buffer, no point copying it
+        if (len >= BUFFER_SIZE) {
+            write_out(data, len);
+            return;
+        }
+    }
+    _buffer.append(data, len);
+}
+
+void OutputWriter::write(const std::string &str) {
+    write(str.data(), str.length());
+}
@@ -0,0 +1,68 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_OUTPUTWRITER_H
+#define ENTAP_OUTPUTWRITER_H
+
+//*********************** Includes *****************************
+#include "common.h"
+//**************************************************************
+
+
+/**
+ * Write-only output file with a single large buffer. Rows are appended to
+ * the buffer and handed to the kernel in BUFFER_SIZE blocks, nothing is
+ * flushed per row. Buffer is flushed and file closed on destruction.
+ */
+class OutputWriter {
+
+public:
+    OutputWriter();
+    ~OutputWriter();
+
+    bool open(const std::string &path, bool append);
+    bool close();
+    bool flush();
+    bool is_open() const;
+    bool good() const;
+    void write(const char *data, uint64 len);
+    void write(const std::string &str);
+
+    static constexpr uint64 BUFFER_SIZE = 1 << 20;
+
+private:
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+    void write_out(const char *data, uint64 len);
+
+    int         _fd;
+    bool        _good;      // False once any write to the file has failed
+    std::string _buffer;
+};
+
+
+#endif //ENTAP_OUTPUTWRITER_H
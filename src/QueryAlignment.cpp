@@ -36,51 +36,73 @@
 
 
 QueryAlignment::QueryAlignment() {
-    _compare_overall_alignment = false;
+    _parent = nullptr;
 }
 
-void QueryAlignment::set_compare_overall_alignment(bool val) {
-    _compare_overall_alignment = val;
+std::string QueryAlignment::print_delim(std::vector<ENTAP_HEADERS> &headers, uint8 lvl, char delim)  {
+    std::string row;
+
+    print_delim(headers, lvl, delim, row);
+    return row;
 }
 
-std::string QueryAlignment::print_delim(std::vector<ENTAP_HEADERS> &headers, uint8 lvl, char delim)  {
-    std::stringstream stream;
-    std::string temp;
+// Appends a delimited row to row, field scratch string is reused per thread
+void QueryAlignment::print_delim(std::vector<ENTAP_HEADERS> &headers, uint8 lvl, char delim, std::string &row) {
+    static thread_local std::string temp;
 
     for (ENTAP_HEADERS header : headers) {
         if (ENTAP_HEADER_INFO[header].print_header) {
-            if (ALIGN_OUTPUT_MAP.find(header) != ALIGN_OUTPUT_MAP.end()) {
-                // Header applies to this alignment
-                get_header_data(header, temp, lvl);
-                stream << temp << delim;
-
-            } else {
+            if (!get_header_field(header, temp)) {
                 // Header does NOT apply to this alignment, get info from parent
                 _parent->get_header_data(temp, header, lvl);
-                stream << temp << delim;
             }
+            row += temp;
+            row += delim;
         }
     }
-    return stream.str();
 }
 
-void QueryAlignment::get_all_header_data(std::string *headers) {
-    for (auto &pair : ALIGN_OUTPUT_MAP) {
-        headers[pair.first] = *pair.second;
-    }
-}
-
-void QueryAlignment::get_header_data(ENTAP_HEADERS header, std::string &val, uint8 lvl) {
+/**
+ * ======================================================================
+ * Function bool QueryAlignment::get_header_data(ENTAP_HEADERS header,
+ *                                               std::string &val, uint8 lvl)
+ *
+ * Description          - Formats header value for output straight from
+ *                        alignment results, nothing is cached
+ *
+ * Notes                - None
+ *
+ * @param header        - Header to get
+ * @param val           - Set to header value
+ * @param lvl           - GO level to normalize GO terms to
+ *
+ * @return              - False if header does not apply to alignment
+ *
+ * =====================================================================
+ */
+bool QueryAlignment::get_header_data(ENTAP_HEADERS header, std::string &val, uint8 lvl) {
     std::vector<std::string> go_list;
 
     if (is_go_header(header, go_list)) {
         val = _parent->format_go_info(go_list, lvl);
+        return true;
     } else {
-        val = *ALIGN_OUTPUT_MAP[header];
+        return get_header_field(header, val);
     }
 }
 
 
+// Appends a GO header's terms for each level to rows, false if header is not a GO header
+bool QueryAlignment::get_header_levels(ENTAP_HEADERS header, const std::vector<uint8> &levels,
+                                       std::vector<std::string> &rows) {
+    static thread_local std::vector<std::string> go_list;
+
+    if (!is_go_header(header, go_list)) return false;
+    _parent->format_go_levels(go_list, levels, rows);
+    return true;
+}
+
+
 //**********************************************************************
 //**********************************************************************
 //                 SimSearchAlignment Nested Class
@@ -128,85 +150,20 @@ void SimSearchAlignment::set_tax_score(std::string &input_lineage) {
 SimSearchAlignment::SimSearchAlignment(QuerySequence::SimSearchResults d, std::string &lineage, QuerySequence* parent) {
     _sim_search_results = d;
     set_tax_score(lineage);
+    _rank_key = SimSearchRankKey::make(_sim_search_results.e_val_raw, _sim_search_results.coverage_raw,
+                                       _sim_search_results.tax_score, _sim_search_results.contaminant);
     _parent = parent;
-
-    ALIGN_OUTPUT_MAP = {
-            {ENTAP_HEADER_QUERY               , &_sim_search_results.qseqid},
-            {ENTAP_HEADER_SIM_SUBJECT         , &_sim_search_results.sseqid},
-            {ENTAP_HEADER_SIM_PERCENT         , &_sim_search_results.pident},
-            {ENTAP_HEADER_SIM_ALIGN_LEN       , &_sim_search_results.length},
-            {ENTAP_HEADER_SIM_MISMATCH        , &_sim_search_results.mismatch},
-            {ENTAP_HEADER_SIM_GAP_OPEN        , &_sim_search_results.gapopen},
-            {ENTAP_HEADER_SIM_QUERY_E         , &_sim_search_results.qend},
-            {ENTAP_HEADER_SIM_QUERY_S         , &_sim_search_results.qstart},
-            {ENTAP_HEADER_SIM_SUBJ_S          , &_sim_search_results.sstart},
-            {ENTAP_HEADER_SIM_SUBJ_E          , &_sim_search_results.send},
-            {ENTAP_HEADER_SIM_E_VAL           , &_sim_search_results.e_val},
-            {ENTAP_HEADER_SIM_COVERAGE        , &_sim_search_results.coverage},
-            {ENTAP_HEADER_SIM_TITLE           , &_sim_search_results.stitle},
-            {ENTAP_HEADER_SIM_SPECIES         , &_sim_search_results.species},
-            {ENTAP_HEADER_SIM_TAXONOMIC_LINEAGE, &_sim_search_results.lineage},
-            {ENTAP_HEADER_SIM_DATABASE        , &_sim_search_results.database_path},
-            {ENTAP_HEADER_SIM_CONTAM          , &_sim_search_results.yes_no_contam},
-            {ENTAP_HEADER_SIM_INFORM          , &_sim_search_results.yes_no_inform},
-            {ENTAP_HEADER_SIM_UNI_DATA_XREF   , &_sim_search_results.uniprot_info.database_x_refs},
-            {ENTAP_HEADER_SIM_UNI_COMMENTS    , &_sim_search_results.uniprot_info.comments},
-//            {ENTAP_HEADER_SIM_UNI_GO_CELL     , &_sim_search_results.uniprot_info.go_terms.at(GO_CELLULAR_FLAG)},
-//            {ENTAP_HEADER_SIM_UNI_GO_BIO      , &_sim_search_results.uniprot_info.go_terms.at(GO_BIOLOGICAL_FLAG)},
-//            {ENTAP_HEADER_SIM_UNI_GO_MOLE     , &_sim_search_results.uniprot_info.go_terms.at(GO_MOLECULAR_FLAG)}
-    };
 }
 
 QuerySequence::SimSearchResults* SimSearchAlignment::get_results() {
     return &_sim_search_results;
 }
 
-bool SimSearchAlignment::operator>(const QueryAlignment &alignment) {
-
+bool SimSearchAlignment::is_better(const QueryAlignment &alignment, bool overall) const {
     // Don't need to check typeid
-    const SimSearchAlignment alignment_cast = dynamic_cast<const SimSearchAlignment&>(alignment);
-
-    fp64 eval1 = this->_sim_search_results.e_val_raw;
-    fp64 eval2 = alignment_cast._sim_search_results.e_val_raw;
-
-    fp64 cov1 = this->_sim_search_results.coverage_raw;
-    fp64 cov2 = alignment_cast._sim_search_results.coverage_raw;
-    fp64 coverage_dif = fabs(cov1 - cov2);
-    if (!this->_compare_overall_alignment) {
-        // For hits of the same database "better hit"
-		fp64 log1 = 0.0;
-		fp64 log2 = 0.0;
-		if (eval1 != 0.0) {
-			log1 = log10(eval1);
-		}
-		if (eval2 != 0.0) {
-			log2 = log10(eval2);
-		}
-        if (fabs(log1 - log2) < E_VAL_DIF) {
-            if (coverage_dif > COV_DIF) {
-                return cov1 > cov2;
-            }
-            if (this->_sim_search_results.contaminant && !alignment_cast._sim_search_results.contaminant) return false;
-            if (!this->_sim_search_results.contaminant && alignment_cast._sim_search_results.contaminant) return true;
-            if (this->_sim_search_results.tax_score == alignment_cast._sim_search_results.tax_score)
-                return eval1 < eval2;
-            return this->_sim_search_results.tax_score > alignment_cast._sim_search_results.tax_score;
-        } else {
-            return eval1 < eval2;
-        }
-    }else {
-        // For overall best hits between databases "best hit"
-        if (coverage_dif > COV_DIF) {
-            return cov1 > cov2;
-        }
-        if (this->_sim_search_results.contaminant && !alignment_cast._sim_search_results.contaminant) return false;
-        if (!this->_sim_search_results.contaminant && alignment_cast._sim_search_results.contaminant) return true;
-        if (this->_sim_search_results.tax_score == alignment_cast._sim_search_results.tax_score) {
-			return cov1 > cov2;
-		} else {
-			return this->_sim_search_results.tax_score > alignment_cast._sim_search_results.tax_score;
-		}
-    }
+    const SimSearchAlignment &alignment_cast = static_cast<const SimSearchAlignment&>(alignment);
+
+    return SimSearchRankKey::is_better(this->_rank_key, alignment_cast._rank_key, overall);
 }
 
 bool SimSearchAlignment::is_go_header(ENTAP_HEADERS header, std::vector<std::string> &go_list) {
@@ -237,6 +194,77 @@ bool SimSearchAlignment::is_go_header(ENTAP_HEADERS header, std::vector<std::str
 
 
 
+bool SimSearchAlignment::get_header_field(ENTAP_HEADERS header, std::string &val) {
+    switch (header) {
+        case ENTAP_HEADER_QUERY:
+            val = _sim_search_results.qseqid;
+            break;
+        case ENTAP_HEADER_SIM_SUBJECT:
+            val = _sim_search_results.sseqid;
+            break;
+        case ENTAP_HEADER_SIM_PERCENT:
+            val = _sim_search_results.pident;
+            break;
+        case ENTAP_HEADER_SIM_ALIGN_LEN:
+            val = _sim_search_results.length;
+            break;
+        case ENTAP_HEADER_SIM_MISMATCH:
+            val = _sim_search_results.mismatch;
+            break;
+        case ENTAP_HEADER_SIM_GAP_OPEN:
+            val = _sim_search_results.gapopen;
+            break;
+        case ENTAP_HEADER_SIM_QUERY_E:
+            val = _sim_search_results.qend;
+            break;
+        case ENTAP_HEADER_SIM_QUERY_S:
+            val = _sim_search_results.qstart;
+            break;
+        case ENTAP_HEADER_SIM_SUBJ_S:
+            val = _sim_search_results.sstart;
+            break;
+        case ENTAP_HEADER_SIM_SUBJ_E:
+            val = _sim_search_results.send;
+            break;
+        case ENTAP_HEADER_SIM_E_VAL:
+            val = _sim_search_results.e_val;
+            break;
+        case ENTAP_HEADER_SIM_COVERAGE:
+            val = _sim_search_results.coverage;
+            break;
+        case ENTAP_HEADER_SIM_TITLE:
+            val = _sim_search_results.stitle;
+            break;
+        case ENTAP_HEADER_SIM_SPECIES:
+            val = _sim_search_results.species;
+            break;
+        case ENTAP_HEADER_SIM_TAXONOMIC_LINEAGE:
+            val = _sim_search_results.lineage;
+            break;
+        case ENTAP_HEADER_SIM_DATABASE:
+            val = _sim_search_results.database_path;
+            break;
+        case ENTAP_HEADER_SIM_CONTAM:
+            val = _sim_search_results.yes_no_contam;
+            break;
+        case ENTAP_HEADER_SIM_INFORM:
+            val = _sim_search_results.yes_no_inform;
+            break;
+        case ENTAP_HEADER_SIM_UNI_DATA_XREF:
+            val = _sim_search_results.uniprot_info.database_x_refs;
+            break;
+        case ENTAP_HEADER_SIM_UNI_COMMENTS:
+            val = _sim_search_results.uniprot_info.comments;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+
+
+
 //**********************************************************************
 //**********************************************************************
 //                 EggnogDmndAlignment Struct
@@ -247,7 +275,6 @@ EggnogDmndAlignment::EggnogDmndAlignment(QuerySequence::EggnogResults eggnogResu
                                                         QuerySequence *parent) {
     _parent = parent;
     _eggnog_results = eggnogResults;
-    refresh_headers();
 }
 
 
@@ -255,8 +282,8 @@ QuerySequence::EggnogResults *EggnogDmndAlignment::get_results() {
     return &this->_eggnog_results;
 }
 
-bool EggnogDmndAlignment::operator>(const QueryAlignment & alignment) {
-    const EggnogDmndAlignment alignment_cast = dynamic_cast<const EggnogDmndAlignment&>(alignment);
+bool EggnogDmndAlignment::is_better(const QueryAlignment & alignment, bool) const {
+    const EggnogDmndAlignment &alignment_cast = static_cast<const EggnogDmndAlignment&>(alignment);
 
     return this->_eggnog_results.seed_eval_raw < alignment_cast._eggnog_results.seed_eval_raw;
 }
@@ -285,25 +312,52 @@ bool EggnogDmndAlignment::is_go_header(ENTAP_HEADERS header, std::vector<std::st
     return out_flag;
 }
 
+// Headers are read on demand, only query flags may change with new results
 void EggnogDmndAlignment::refresh_headers() {
-
-    ALIGN_OUTPUT_MAP = {
-            {ENTAP_HEADER_ONT_EGG_SEED_ORTHO, &_eggnog_results.seed_ortholog},
-            {ENTAP_HEADER_ONT_EGG_SEED_EVAL,  &_eggnog_results.seed_evalue},
-            {ENTAP_HEADER_ONT_EGG_SEED_SCORE, &_eggnog_results.seed_score},
-            {ENTAP_HEADER_ONT_EGG_PRED_GENE,  &_eggnog_results.predicted_gene},
-            {ENTAP_HEADER_ONT_EGG_TAX_SCOPE_READABLE,  &_eggnog_results.tax_scope_readable},
-            {ENTAP_HEADER_ONT_EGG_TAX_SCOPE_MAX, &_eggnog_results.tax_scope_lvl_max},
-            {ENTAP_HEADER_ONT_EGG_MEMBER_OGS,&_eggnog_results.member_ogs},
-            {ENTAP_HEADER_ONT_EGG_DESC,       &_eggnog_results.description},
-            {ENTAP_HEADER_ONT_EGG_BIGG,       &_eggnog_results.bigg},
-            {ENTAP_HEADER_ONT_EGG_KEGG,       &_eggnog_results.kegg},
-            {ENTAP_HEADER_ONT_EGG_PROTEIN,    &_eggnog_results.protein_domains},
-    };
-    _parent->set_header_data();
     _parent->update_query_flags(GENE_ONTOLOGY, ONT_EGGNOG_DMND);
 }
 
+bool EggnogDmndAlignment::get_header_field(ENTAP_HEADERS header, std::string &val) {
+    switch (header) {
+        case ENTAP_HEADER_ONT_EGG_SEED_ORTHO:
+            val = _eggnog_results.seed_ortholog;
+            break;
+        case ENTAP_HEADER_ONT_EGG_SEED_EVAL:
+            val = _eggnog_results.seed_evalue;
+            break;
+        case ENTAP_HEADER_ONT_EGG_SEED_SCORE:
+            val = _eggnog_results.seed_score;
+            break;
+        case ENTAP_HEADER_ONT_EGG_PRED_GENE:
+            val = _eggnog_results.predicted_gene;
+            break;
+        case ENTAP_HEADER_ONT_EGG_TAX_SCOPE_READABLE:
+            val = _eggnog_results.tax_scope_readable;
+            break;
+        case ENTAP_HEADER_ONT_EGG_TAX_SCOPE_MAX:
+            val = _eggnog_results.tax_scope_lvl_max;
+            break;
+        case ENTAP_HEADER_ONT_EGG_MEMBER_OGS:
+            val = _eggnog_results.member_ogs;
+            break;
+        case ENTAP_HEADER_ONT_EGG_DESC:
+            val = _eggnog_results.description;
+            break;
+        case ENTAP_HEADER_ONT_EGG_BIGG:
+            val = _eggnog_results.bigg;
+            break;
+        case ENTAP_HEADER_ONT_EGG_KEGG:
+            val = _eggnog_results.kegg;
+            break;
+        case ENTAP_HEADER_ONT_EGG_PROTEIN:
+            val = _eggnog_results.protein_domains;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
 //**********************************************************************
 //**********************************************************************
 //                 InterproAlignment Struct
@@ -314,22 +368,14 @@ InterproAlignment::InterproAlignment(QuerySequence::InterProResults results, Que
 
     _interpro_results = results;
     _parent = parent;
-
-    ALIGN_OUTPUT_MAP = {
-            {ENTAP_HEADER_ONT_INTER_EVAL, &_interpro_results.e_value},
-            {ENTAP_HEADER_ONT_INTER_INTERPRO, &_interpro_results.interpro_desc_id},
-            {ENTAP_HEADER_ONT_INTER_DATA_TERM,&_interpro_results.database_desc_id},
-            {ENTAP_HEADER_ONT_INTER_DATA_TYPE,&_interpro_results.database_type},
-            {ENTAP_HEADER_ONT_INTER_PATHWAYS, &_interpro_results.pathways}
-    };
 }
 
 QuerySequence::InterProResults *InterproAlignment::get_results() {
     return &this->_interpro_results;
 }
 
-bool InterproAlignment::operator>(const QueryAlignment &alignment) {
-    const InterproAlignment alignment_cast = dynamic_cast<const InterproAlignment&>(alignment);
+bool InterproAlignment::is_better(const QueryAlignment &alignment, bool) const {
+    const InterproAlignment &alignment_cast = static_cast<const InterproAlignment&>(alignment);
 
     return this->_interpro_results.e_value_raw < alignment_cast._interpro_results.e_value_raw;
 }
@@ -357,3 +403,26 @@ bool InterproAlignment::is_go_header(ENTAP_HEADERS header, std::vector<std::stri
     }
     return out_flag;
 }
+
+bool InterproAlignment::get_header_field(ENTAP_HEADERS header, std::string &val) {
+    switch (header) {
+        case ENTAP_HEADER_ONT_INTER_EVAL:
+            val = _interpro_results.e_value;
+            break;
+        case ENTAP_HEADER_ONT_INTER_INTERPRO:
+            val = _interpro_results.interpro_desc_id;
+            break;
+        case ENTAP_HEADER_ONT_INTER_DATA_TERM:
+            val = _interpro_results.database_desc_id;
+            break;
+        case ENTAP_HEADER_ONT_INTER_DATA_TYPE:
+            val = _interpro_results.database_type;
+            break;
+        case ENTAP_HEADER_ONT_INTER_PATHWAYS:
+            val = _interpro_results.pathways;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
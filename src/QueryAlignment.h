@@ -29,6 +29,7 @@
 #define ENTAP_QUERYALIGNMENT_H
 
 #include "QuerySequence.h"
+#include "AlignmentRank.h"
 //**********************************************************************
 //**********************************************************************
 //                 QueryAlignment Nested Class
@@ -40,18 +41,16 @@ class QueryAlignment {
 public:
     QueryAlignment();
     std::string print_delim(std::vector<ENTAP_HEADERS> &, uint8 lvl, char delim);
-    bool operator<(const QueryAlignment&query) {return !(*this > query);};
-    void set_compare_overall_alignment(bool val);
+    void print_delim(std::vector<ENTAP_HEADERS> &, uint8 lvl, char delim, std::string &row);
     virtual ~QueryAlignment() = default;;
-    virtual bool operator>(const QueryAlignment&)=0;
-    void get_all_header_data(std::string[]);
-    void get_header_data(ENTAP_HEADERS header, std::string &val, uint8 lvl);
+    virtual bool is_better(const QueryAlignment&, bool overall) const =0;
+    bool get_header_data(ENTAP_HEADERS header, std::string &val, uint8 lvl);
+    bool get_header_levels(ENTAP_HEADERS header, const std::vector<uint8> &levels, std::vector<std::string> &rows);
 
 protected:
     virtual bool is_go_header(ENTAP_HEADERS header, std::vector<std::string>& go_list)=0;
+    virtual bool get_header_field(ENTAP_HEADERS header, std::string &val)=0;
 
-    std::unordered_map<ENTAP_HEADERS , std::string*> ALIGN_OUTPUT_MAP;
-    bool _compare_overall_alignment; // May want to compare separate parameters for overall alignment across databases
     QuerySequence* _parent;
 };
 
@@ -67,18 +66,18 @@ public:
     SimSearchAlignment(QuerySequence::SimSearchResults, std::string&, QuerySequence*);
     ~SimSearchAlignment() override = default;
     QuerySequence::SimSearchResults* get_results();
-    bool operator>(const QueryAlignment&) override;
+    bool is_better(const QueryAlignment&, bool overall) const override;
 
 private:
     void set_tax_score(std::string&);
 
     QuerySequence::SimSearchResults    _sim_search_results;
+    SimSearchRankKey                   _rank_key;
 
 protected:
     bool is_go_header(ENTAP_HEADERS header, std::vector<std::string>& go_list) override;
+    bool get_header_field(ENTAP_HEADERS header, std::string &val) override;
 
-    static constexpr uint8 E_VAL_DIF     = 8;
-    static constexpr uint8 COV_DIF       = 5;
     static constexpr uint8 INFORM_ADD    = 3;
     static constexpr fp32 INFORM_FACTOR  = 1.2;
 };
@@ -95,7 +94,7 @@ public:
     EggnogDmndAlignment(QuerySequence::EggnogResults eggnogResults, QuerySequence* parent);
     ~EggnogDmndAlignment() override = default;
     QuerySequence::EggnogResults* get_results();
-    bool operator>(const QueryAlignment&) override;
+    bool is_better(const QueryAlignment&, bool overall) const override;
     void refresh_headers();
 
 private:
@@ -103,6 +102,7 @@ private:
 
 protected:
     bool is_go_header(ENTAP_HEADERS header, std::vector<std::string>& go_list) override;
+    bool get_header_field(ENTAP_HEADERS header, std::string &val) override;
 
 };
 
@@ -118,7 +118,7 @@ public:
     InterproAlignment(QuerySequence::InterProResults results, QuerySequence *parent);
     ~InterproAlignment() override = default;
     QuerySequence::InterProResults* get_results();
-    bool operator>(const QueryAlignment&) override;
+    bool is_better(const QueryAlignment&, bool overall) const override;
 
 
 private:
@@ -126,6 +126,7 @@ private:
 
 protected:
     bool is_go_header(ENTAP_HEADERS header, std::vector<std::string>& go_list) override;
+    bool get_header_field(ENTAP_HEADERS header, std::string &val) override;
 
 };
 
@@ -30,6 +30,12 @@
 #include "ExceptionHandler.h"
 #include "FileSystem.h"
 #include "UserInput.h"
+#include "MappedFile.h"
+#include "FastaScanner.h"
+#include "OutputWriter.h"
+#include "Instrumentation.h"
+
+thread_local QueryData::OutputChunk *QueryData::_pOutputChunk = nullptr;
 
 
 /**
@@ -44,7 +50,9 @@
  *                      - This map is passed throughout EnTAP execution and
  *                        updated
  *
- * Notes                - None
+ * Notes                - Input is memory mapped and split into record
+ *                        aligned ranges parsed across threads, the
+ *                        trimmed copy is written in large blocks
  *
  * @param input_file    - Path to input transcriptome
  * @param trim          - Flag from user to trim sequence ID to first space
@@ -61,21 +69,27 @@ QueryData::QueryData(std::string &input_file, std::string &out_path, UserInput *
     std::stringstream                        out_msg;
     std::string                              out_name;
     std::string                              out_new_path;
-    std::string                              line;
-    std::string                              sequence;
-    std::string                              seq_id;
     std::string                              longest_seq;
     std::string                              shortest_seq;
     std::string                              transcript_type;
+    std::string                              out_buffer;
     uint32                                   count_seqs=0;
+    uint32                                   chunk_count;
     uint64                                   total_len=0;
     uint16                                   shortest_len=10000;
     uint16                                   longest_len=0;
     uint16                                   len;
+    int                                      threads;
     fp64                                     avg_len;
+    fp64                                     ingest_secs;
     std::vector<uint16>                      sequence_lengths;
     std::pair<uint16, uint16>                n_vals;
     bool                                     is_complete;
+    MappedFile                               in_file;
+    std::vector<const char*>                 chunk_bounds;
+    std::vector<std::unique_ptr<TranscriptomeShard>> shards;
+    std::vector<std::thread>                 workers;
+    std::chrono::steady_clock::time_point    ingest_start;
 
     _total_sequences = 0;
     _pipeline_flags  = 0;
@@ -99,48 +113,92 @@ QueryData::QueryData(std::string &input_file, std::string &out_path, UserInput *
     set_input_type(input_file);
     DATA_FLAG_GET(IS_PROTEIN) ? transcript_type = PROTEIN_FLAG : transcript_type = NUCLEO_FLAG;
 
-    std::ifstream in_file(input_file);
-    std::ofstream out_file(out_new_path,std::ios::out | std::ios::app);
-
-    while (true) {
-        std::getline(in_file, line);
-        if (line.empty() && !in_file.eof()) continue;
-        if (line.find(FileSystem::FASTA_FLAG) == 0 || in_file.eof()) {
-            if (!seq_id.empty()) {
-                if (in_file.eof()) {
-                    out_file << line << std::endl;
-                    sequence += line + "\n";
-                }
-                QuerySequence *query_seq = new QuerySequence(DATA_FLAG_GET(IS_PROTEIN),sequence, seq_id);
-                if (is_complete) query_seq->setFrame(COMPLETE_FLAG);
-                if (_pSEQUENCES->find(seq_id) != _pSEQUENCES->end()) {
-                    throw ExceptionHandler("Duplicate headers in your input transcriptome: " + seq_id,
-                        ERR_ENTAP_INPUT_PARSE);
-                }
-                _pSEQUENCES->emplace(seq_id, query_seq);
-                count_seqs++;
-                len = (uint16) query_seq->getSeq_length();
-                total_len += len;
-                if (len > longest_len) {
-                    longest_len = len;longest_seq = seq_id;
-                }
-                if (len < shortest_len) {
-                    shortest_len = len;shortest_seq = seq_id;
+    ingest_start = std::chrono::steady_clock::now();
+    if (!in_file.open(input_file)) {
+        throw ExceptionHandler("Unable to read input transcriptome at: " + input_file, ERR_ENTAP_INPUT_PARSE);
+    }
+
+    // Split into record aligned ranges, small inputs are not worth spawning threads for
+    threads = _pUserInput->get_supported_threads();
+    chunk_count = (uint32) std::min<uint64>((uint64) std::max(threads, 1), in_file.size() / PARSE_CHUNK_MIN);
+    if (chunk_count == 0) chunk_count = 1;
+    chunk_bounds = FastaScanner::split_records(in_file.data(), in_file.end(), chunk_count);
+    for (uint32 i = 0; i < chunk_count; i++) shards.emplace_back(new TranscriptomeShard());
+    FS_dprint("Parsing transcriptome with " + std::to_string(chunk_count) + " thread(s)");
+
+    if (chunk_count == 1) {
+        parse_transcriptome_range(chunk_bounds[0], chunk_bounds[1], is_complete, shards[0].get());
+    } else {
+        for (uint32 i = 0; i < chunk_count; i++) {
+            workers.emplace_back(&QueryData::parse_transcriptome_range, this, chunk_bounds[i],
+                                 chunk_bounds[i+1], is_complete, shards[i].get());
+        }
+        for (std::thread &worker : workers) worker.join();
+    }
+
+    // Merge shards in file order so statistics and output match a serial parse
+    std::ofstream out_file(out_new_path, std::ios::out | std::ios::binary);
+    out_buffer.reserve(OUT_BUFFER_SIZE);
+    for (uint32 i = 0; i < chunk_count; i++) {
+        TranscriptomeShard *shard = shards[i].get();
+        uint32 block_base = _sequence_pool.merge(shard->pool);
+        _sequence_slab.merge(shard->slab);
+
+        for (uint64 j = 0; j < shard->sequences.size(); j++) {
+            std::string   &seq_id    = shard->sequences[j].first;
+            QuerySequence *query_seq = shard->sequences[j].second;
+
+            query_seq->rebase_sequences(&_sequence_pool, block_base);
+            if (_pSEQUENCES->find(seq_id) != _pSEQUENCES->end()) {
+                // Free whatever has not been handed to the map yet
+                for (uint32 k = i; k < chunk_count; k++) {
+                    for (uint64 l = (k == i ? j : 0); l < shards[k]->sequences.size(); l++) {
+                        _sequence_slab.destroy(shards[k]->sequences[l].second);
+                    }
                 }
-                sequence_lengths.push_back(len);
+                free_sequences();
+                throw ExceptionHandler("Duplicate headers in your input transcriptome: " + seq_id,
+                    ERR_ENTAP_INPUT_PARSE);
+            }
+            _pSEQUENCES->emplace(seq_id, query_seq);
+
+            out_buffer += query_seq->get_sequence();
+            out_buffer += '\n';
+            if (out_buffer.size() >= OUT_BUFFER_SIZE) {
+                out_file.write(out_buffer.data(), out_buffer.size());
+                out_buffer.clear();
+            }
+
+            count_seqs++;
+            len = (uint16) query_seq->getSeq_length();
+            total_len += len;
+            if (len > longest_len) {
+                longest_len = len;longest_seq = seq_id;
+            }
+            if (len < shortest_len) {
+                shortest_len = len;shortest_seq = seq_id;
             }
-            if (in_file.eof()) break;
-            sequence = trim_sequence_header(seq_id, line);
-            out_file << sequence;
-        } else {
-            out_file << line << std::endl;
-            sequence += line + "\n";
         }
+        sequence_lengths.insert(sequence_lengths.end(), shard->sequence_lengths.begin(),
+                                shard->sequence_lengths.end());
+        shards[i].reset();
     }
-    in_file.close();
+    out_file.write(out_buffer.data(), out_buffer.size());
     out_file.close();
+
+    ingest_secs = std::chrono::duration<fp64>(std::chrono::steady_clock::now() - ingest_start).count();
+    FS_dprint("Transcriptome ingest: " + std::to_string(in_file.size()) + " bytes, " +
+              std::to_string(count_seqs) + " sequences in " + float_to_string(ingest_secs) + "s (" +
+              float_to_string(ingest_secs > 0 ? (in_file.size() / 1048576.0) / ingest_secs : 0) + " MB/s)");
+    in_file.close();
+
+    if (count_seqs == 0) {
+        free_sequences();
+        throw ExceptionHandler("No sequences found in input transcriptome: " + input_file, ERR_ENTAP_INPUT_PARSE);
+    }
     avg_len = total_len / count_seqs;
     _total_sequences = count_seqs;
+    Instrumentation::counter("sequences_input") += count_seqs;
     DATA_FLAG_GET(IS_PROTEIN)  ? _start_prot_len = total_len : _start_nuc_len = total_len;
     // first - n50, second - n90
     n_vals = calculate_N_vals(sequence_lengths, total_len);
@@ -163,6 +221,73 @@ QueryData::QueryData(std::string &input_file, std::string &out_path, UserInput *
 }
 
 
+/**
+ * ======================================================================
+ * Function void QueryData::parse_transcriptome_range(const char *begin, const char *end,
+ *                                                    bool is_complete,
+ *                                                    TranscriptomeShard *shard)
+ *
+ * Description          - Parses FASTA records within a byte range of the
+ *                        mapped transcriptome into a shard
+ *                      - Run on worker threads, touches nothing shared
+ *
+ * Notes                - Duplicate headers are checked during merge
+ *
+ * @param begin         - Start of range (record aligned)
+ * @param end           - End of range
+ * @param is_complete   - Flag sequences as complete genes
+ * @param shard         - Output for this range
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void QueryData::parse_transcriptome_range(const char *begin, const char *end, bool is_complete,
+                                          TranscriptomeShard *shard) {
+    std::string     line;
+    std::string     header;
+    std::string     seq_id;
+    FastaRecord     record;
+    FastaScanner    scanner(begin, end);
+    bool            is_protein;
+
+    is_protein = DATA_FLAG_GET(IS_PROTEIN);
+    while (scanner.next_record(record)) {
+        line.assign(record.header, record.header_len);
+        header = trim_sequence_header(seq_id, line);
+        if (seq_id.empty()) continue;
+
+        // Copy trimmed header and sequence lines into pool, dropping empty lines.
+        // Newlines only go between lines so the copy never outgrows the record
+        uint64 seq_len = 0;
+        uint64 written = header.length();
+        const char *seq_end = record.sequence + record.sequence_len;
+        const char *line_end;
+        const char *pos = record.sequence;
+        char *dest = shard->pool.reserve(header.length() + record.sequence_len);
+        memcpy(dest, header.data(), header.length());
+        while (pos < seq_end) {
+            const char *line_start = pos;
+            pos = FastaScanner::next_line(pos, seq_end, line_end);
+            if (line_end == line_start) continue;
+            if (seq_len > 0) dest[written++] = '\n';
+            memcpy(dest + written, line_start, line_end - line_start);
+            written += (uint64) (line_end - line_start);
+            seq_len += (uint64) (line_end - line_start);
+        }
+        if (seq_len == 0) written--;    // Header stored without trailing newline
+        SequencePool::seq_ref_t seq_ref = shard->pool.commit(written);
+        if (is_protein) seq_len *= 3;
+
+        QuerySequence *query_seq = shard->slab.create(is_protein, seq_id, &shard->pool, seq_ref,
+                                                      (uint32) written, seq_len);
+        if (is_complete) query_seq->setFrame(COMPLETE_FLAG);
+        shard->sequences.emplace_back(seq_id, query_seq);
+        shard->sequence_lengths.push_back((uint16) seq_len);
+    }
+}
+
+
 void QueryData::set_input_type(std::string &in) {
     std::string    line;
     uint8          line_count;
@@ -334,6 +459,12 @@ void QueryData::final_statistics(std::string &outpath, std::vector<uint16> &onto
     _pFileSystem->format_stat_stream(ss, "Final Annotation Statistics");
     ss <<
        "Total Sequences: "                  << count_total_sequences;
+    if (count_total_sequences > 0) {
+        ss <<
+           "\nQuery storage (records and sequence pool): " <<
+           (_sequence_slab.bytes_reserved() + _sequence_pool.bytes_used()) / count_total_sequences <<
+           " bytes per sequence";
+    }
 
     if (DATA_FLAG_GET(SUCCESS_EXPRESSION)) {
         ss <<
@@ -404,18 +535,42 @@ std::string QueryData::trim_sequence_header(std::string &header, std::string lin
     return sequence;
 }
 
+// Same trimming as trim_sequence_header over a raw range, header keeps its capacity between calls
+void QueryData::trim_sequence_id(const char *begin, const char *end, std::string &header) const {
+    const char *marker;
+
+    marker = static_cast<const char*>(memchr(begin, '>', end - begin));
+    if (marker != nullptr) begin = marker + 1;
+    header.clear();
+    if (_no_trim) {
+        for (const char *pos = begin; pos < end; pos++) {
+            if (!isspace((unsigned char) *pos)) header += *pos;
+        }
+    } else {
+        marker = static_cast<const char*>(memchr(begin, ' ', end - begin));
+        header.assign(begin, marker == nullptr ? end : marker);
+    }
+}
+
 QUERY_MAP_T* QueryData::get_sequences_ptr() {
     return this->_pSEQUENCES;
 }
 
 QueryData::~QueryData() {
     FS_dprint("Killing Object - QueryData");
+    free_sequences();
+    FS_dprint("QuerySequence data freed");
+}
+
+// Slab and pool memory itself is released with this object
+void QueryData::free_sequences() {
+    if (_pSEQUENCES == nullptr) return;
     for(QUERY_MAP_T::iterator it = _pSEQUENCES->begin(); it != _pSEQUENCES->end(); it++) {
-        delete it->second;
+        _sequence_slab.destroy(it->second);
         it->second = nullptr;
     }
-    FS_dprint("QuerySequence data freed");
     delete _pSEQUENCES;
+    _pSEQUENCES = nullptr;
 }
 
 bool QueryData::DATA_FLAG_GET(DATA_FLAGS flag) {
@@ -462,10 +617,14 @@ bool QueryData::start_alignment_files(std::string &base_path, std::vector<ENTAP_
                 // Do NOT create files for anything other than 0 for FAA or FNN
                 continue;
             } else {
-                _alignment_files.at(base_path).file_streams[type] =
-                        new std::ofstream(base_path + _pFileSystem->get_extension(type), std::ios::out | std::ios::app);
+                OutputWriter *writer = new OutputWriter();
+                std::stringstream header_stream;
+
+                writer->open(base_path + _pFileSystem->get_extension(type), true);
                 // Initialize headers or any other generic stuff
-                _pFileSystem->initialize_file(_alignment_files.at(base_path).file_streams[type], headers, type);
+                _pFileSystem->initialize_file(&header_stream, headers, type);
+                writer->write(header_stream.str());
+                _alignment_files.at(base_path).file_writers[type] = writer;
             }
         }
         ret = true;
@@ -479,7 +638,7 @@ bool QueryData::start_alignment_files(std::string &base_path, std::vector<ENTAP_
 bool QueryData::end_alignment_files(std::string &base_path) {
     // Cleanup/close files
 
-    for (std::ofstream* file_ptr : _alignment_files.at(base_path).file_streams) {
+    for (OutputWriter* file_ptr : _alignment_files.at(base_path).file_writers) {
         // some are unused such as 0
         if (file_ptr != nullptr) {
             file_ptr->close();
@@ -491,57 +650,286 @@ bool QueryData::end_alignment_files(std::string &base_path) {
 }
 
 bool QueryData::add_alignment_data(std::string &base_path, QuerySequence *querySequence, QueryAlignment *alignment) {
+    static thread_local std::string row;    // Reused for every row, keeps its capacity
+    OutputFileData &file_data = _alignment_files.at(base_path);
+    OutputWriter   *writer;
     bool ret = false;
 
     // Cycle through output file types for this path
-    for (FileSystem::ENT_FILE_TYPES type : _alignment_files.at(base_path).file_types) {
+    for (FileSystem::ENT_FILE_TYPES type : file_data.file_types) {
 
-        if (_alignment_files.at(base_path).file_streams[type] == nullptr) continue;
+        writer = file_data.file_writers[type];
+        if (writer == nullptr) continue;
+        row.clear();
 
         switch (type) {
 
             case FileSystem::ENT_FILE_DELIM_TSV:
+            case FileSystem::ENT_FILE_DELIM_CSV: {
+                char delim = type == FileSystem::ENT_FILE_DELIM_TSV ? FileSystem::DELIM_TSV : FileSystem::DELIM_CSV;
                 if (alignment == nullptr) {
-                    *_alignment_files.at(base_path).file_streams[type] <<
-                        querySequence->print_delim(_alignment_files.at(base_path).headers,
-                        _alignment_files.at(base_path).go_level, FileSystem::DELIM_TSV) << std::endl;
+                    querySequence->print_delim(file_data.headers, file_data.go_level, delim, row);
                 } else {
-                    *_alignment_files.at(base_path).file_streams[type] <<
-                        alignment->print_delim(_alignment_files.at(base_path).headers,
-                        _alignment_files.at(base_path).go_level, FileSystem::DELIM_TSV) << std::endl;
-                }
-                break;
-
-            case FileSystem::ENT_FILE_DELIM_CSV:
-                if (alignment == nullptr) {
-                    *_alignment_files.at(base_path).file_streams[type] <<
-                        querySequence->print_delim(_alignment_files.at(base_path).headers,
-                        _alignment_files.at(base_path).go_level, FileSystem::DELIM_CSV) << std::endl;
-                } else {
-                    *_alignment_files.at(base_path).file_streams[type] <<
-                        alignment->print_delim(_alignment_files.at(base_path).headers,
-                        _alignment_files.at(base_path).go_level, FileSystem::DELIM_CSV) << std::endl;
+                    alignment->print_delim(file_data.headers, file_data.go_level, delim, row);
                 }
+                row += '\n';
                 break;
+            }
 
             case FileSystem::ENT_FILE_FASTA_FAA:
-                if (!querySequence->get_sequence_p().empty())
-                    *_alignment_files.at(base_path).file_streams[type] << querySequence->get_sequence_p() << std::endl;
+                if (!querySequence->get_sequence_p().empty()) {
+                    row += querySequence->get_sequence_p();
+                    row += '\n';
+                }
                 break;
 
             case FileSystem::ENT_FILE_FASTA_FNN:
-                if (!querySequence->get_sequence_n().empty())
-                    *_alignment_files.at(base_path).file_streams[type] << querySequence->get_sequence_n() << std::endl;
+                if (!querySequence->get_sequence_n().empty()) {
+                    row += querySequence->get_sequence_n();
+                    row += '\n';
+                }
                 break;
 
             default:
                 FS_dprint("ERROR unhandled file type (add_alignment_data): " + std::to_string(type));
                 break;
         }
+        write_output(writer, row);
     }
     return ret;
 }
 
+
+/**
+ * ======================================================================
+ * Function bool QueryData::add_alignment_data(std::vector<std::string> &base_paths,
+ *                                             QuerySequence *querySequence)
+ *
+ * Description          - Writes a sequence to several output files at once
+ *                        (ie. every GO level of a final annotation file)
+ *
+ * Notes                - Delimited rows for every level are formatted in a
+ *                        single pass, shared columns only once
+ *                      - Falls back to one file at a time if the files do
+ *                        not share headers
+ *
+ * @param base_paths    - Base paths of started alignment files
+ * @param querySequence - Sequence to write
+ *
+ * @return              - False
+ *
+ * =====================================================================
+ */
+bool QueryData::add_alignment_data(std::vector<std::string> &base_paths, QuerySequence *querySequence) {
+    static thread_local std::vector<OutputFileData*> files;
+    static thread_local std::vector<uint8>           levels;
+    static thread_local std::vector<std::string>     rows;
+    const std::pair<FileSystem::ENT_FILE_TYPES, char> delim_types[] = {
+            {FileSystem::ENT_FILE_DELIM_TSV, FileSystem::DELIM_TSV},
+            {FileSystem::ENT_FILE_DELIM_CSV, FileSystem::DELIM_CSV}
+    };
+    std::vector<uint8>::iterator it_level;
+    OutputWriter *writer;
+
+    files.clear();
+    for (std::string &base_path : base_paths) {
+        files.push_back(&_alignment_files.at(base_path));
+        if (files.back()->headers != files.front()->headers) {
+            for (std::string &path : base_paths) add_alignment_data(path, querySequence, nullptr);
+            return false;
+        }
+    }
+    if (files.empty()) return false;
+
+    for (const std::pair<FileSystem::ENT_FILE_TYPES, char> &delim_type : delim_types) {
+        levels.clear();
+        for (OutputFileData *file_data : files) {
+            if (file_data->file_writers[delim_type.first] == nullptr) continue;
+            if (std::find(levels.begin(), levels.end(), file_data->go_level) == levels.end()) {
+                levels.push_back(file_data->go_level);
+            }
+        }
+        if (levels.empty()) continue;
+
+        rows.resize(levels.size());
+        for (std::string &row : rows) row.clear();
+        querySequence->print_delim(files.front()->headers, levels, delim_type.second, rows);
+        for (std::string &row : rows) row += '\n';
+
+        for (OutputFileData *file_data : files) {
+            writer = file_data->file_writers[delim_type.first];
+            if (writer == nullptr) continue;
+            it_level = std::find(levels.begin(), levels.end(), file_data->go_level);
+            write_output(writer, rows[it_level - levels.begin()]);
+        }
+    }
+
+    // Sequence files do not depend on level
+    for (OutputFileData *file_data : files) {
+        for (FileSystem::ENT_FILE_TYPES type : {FileSystem::ENT_FILE_FASTA_FAA, FileSystem::ENT_FILE_FASTA_FNN}) {
+            writer = file_data->file_writers[type];
+            if (writer == nullptr) continue;
+            std::string sequence = type == FileSystem::ENT_FILE_FASTA_FAA ?
+                                   querySequence->get_sequence_p() : querySequence->get_sequence_n();
+            if (!sequence.empty()) {
+                sequence += '\n';
+                write_output(writer, sequence);
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * ======================================================================
+ * Function std::vector<QuerySequence*> QueryData::get_output_order()
+ *
+ * Description          - Returns sequences in the order rows are written
+ *                        to output files
+ *
+ * Notes                - Map order by default, sorted by query ID if the
+ *                        user requested it
+ *
+ * @return              - Sequences to output
+ *
+ * =====================================================================
+ */
+std::vector<QuerySequence*> QueryData::get_output_order() {
+    std::vector<std::pair<const std::string*, QuerySequence*>> ordered;
+    std::vector<QuerySequence*> sequences;
+
+    ordered.reserve(_pSEQUENCES->size());
+    for (auto &pair : *_pSEQUENCES) ordered.emplace_back(&pair.first, pair.second);
+    if (_pUserInput->has_input(_pUserInput->INPUT_FLAG_SORT_OUTPUT)) {
+        std::sort(ordered.begin(), ordered.end(),
+                  [](const std::pair<const std::string*, QuerySequence*> &lhs,
+                     const std::pair<const std::string*, QuerySequence*> &rhs) {
+                      return *lhs.first < *rhs.first;
+                  });
+    }
+    sequences.reserve(ordered.size());
+    for (auto &pair : ordered) sequences.push_back(pair.second);
+    return sequences;
+}
+
+
+/**
+ * ======================================================================
+ * Function void QueryData::write_alignment_rows(uint64 count,
+ *                              const std::function<void(uint64)> &format_row)
+ *
+ * Description          - Runs format_row for rows [0, count) across threads
+ *                        and appends the output in row order
+ *
+ * Notes                - Rows are split into chunks, workers format a chunk
+ *                        into per file buffers (add_alignment_data calls
+ *                        are captured) and this thread writes finished
+ *                        chunks in order, so output matches a serial loop
+ *                      - format_row must only touch the row it is given
+ *                      - Workers stay a bounded number of chunks ahead of
+ *                        the writer to cap memory
+ *
+ * @param count         - Number of rows
+ * @param format_row    - Formats a single row (calls add_alignment_data)
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void QueryData::write_alignment_rows(uint64 count, const std::function<void(uint64)> &format_row) {
+    std::vector<std::unique_ptr<OutputChunk>> chunks;
+    std::vector<std::thread>                  workers;
+    std::mutex                                chunk_lock;
+    std::condition_variable                   chunk_cv;
+    std::exception_ptr                        error;
+    uint64                                    chunk_count;
+    uint64                                    next_chunk = 0;
+    uint64                                    written_chunks = 0;
+    uint64                                    max_ahead;
+    uint16                                    threads;
+
+    chunk_count = (count + OUTPUT_CHUNK_ROWS - 1) / OUTPUT_CHUNK_ROWS;
+    threads = (uint16) std::min<uint64>((uint64) std::max(_pUserInput->get_supported_threads(), 1), chunk_count);
+    if (threads <= 1) {
+        for (uint64 i = 0; i < count; i++) format_row(i);
+        return;
+    }
+    FS_dprint("Formatting " + std::to_string(count) + " rows with " + std::to_string(threads) + " thread(s)");
+    chunks.resize(chunk_count);
+    max_ahead = (uint64) threads * OUTPUT_CHUNKS_AHEAD;
+
+    auto format_chunks = [&]() {
+        uint64 chunk;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(chunk_lock);
+                chunk_cv.wait(lock, [&]{return next_chunk >= chunk_count || next_chunk < written_chunks + max_ahead;});
+                if (next_chunk >= chunk_count) return;
+                chunk = next_chunk++;
+            }
+            std::unique_ptr<OutputChunk> output(new OutputChunk());
+            _pOutputChunk = output.get();
+            try {
+                for (uint64 i = chunk * OUTPUT_CHUNK_ROWS; i < std::min(count, (chunk + 1) * OUTPUT_CHUNK_ROWS); i++) {
+                    format_row(i);
+                }
+            } catch (...) {
+                output->error = std::current_exception();
+            }
+            _pOutputChunk = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(chunk_lock);
+                chunks[chunk] = std::move(output);
+            }
+            chunk_cv.notify_all();
+        }
+    };
+    for (uint16 i = 0; i < threads; i++) workers.emplace_back(format_chunks);
+
+    // Single writer, chunks are appended in row order
+    for (uint64 chunk = 0; chunk < chunk_count; chunk++) {
+        std::unique_ptr<OutputChunk> output;
+        {
+            std::unique_lock<std::mutex> lock(chunk_lock);
+            chunk_cv.wait(lock, [&]{return chunks[chunk] != nullptr;});
+            output = std::move(chunks[chunk]);
+        }
+        try {
+            if (output->error) std::rethrow_exception(output->error);
+            for (std::pair<OutputWriter*, std::string> &buffer : output->buffers) {
+                buffer.first->write(buffer.second);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(chunk_lock);
+            written_chunks++;
+            if (error) next_chunk = chunk_count;    // Stop handing out chunks
+        }
+        chunk_cv.notify_all();
+        if (error) break;
+    }
+    for (std::thread &worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+}
+
+
+// Writes to file, or to the current chunk's buffer when formatting on a worker
+void QueryData::write_output(OutputWriter *writer, const std::string &data) {
+    if (_pOutputChunk == nullptr) {
+        writer->write(data);
+        return;
+    }
+    for (std::pair<OutputWriter*, std::string> &buffer : _pOutputChunk->buffers) {
+        if (buffer.first == writer) {
+            buffer.second += data;
+            return;
+        }
+    }
+    _pOutputChunk->buffers.emplace_back(writer, data);
+}
+
 bool QueryData::is_protein_data() {
     return DATA_FLAG_GET(IS_PROTEIN);
 }
@@ -30,11 +30,16 @@
 #define ENTAP_QUERYDATA_H
 
 
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "QuerySequence.h"
+#include "QueryStorage.h"
 #include "common.h"
 
 // Forward Declarations
 class QueryAlignment;
+class OutputWriter;
 
 
 class QueryData {
@@ -60,6 +65,7 @@ public:
 
     std::pair<uint16, uint16> calculate_N_vals(std::vector<uint16>&,uint64);
     std::string trim_sequence_header(std::string&, std::string);
+    void trim_sequence_id(const char *begin, const char *end, std::string &header) const;
     void final_statistics(std::string&, std::vector<uint16>&);
     void print_final_output();
 
@@ -68,6 +74,9 @@ public:
                                 std::vector<FileSystem::ENT_FILE_TYPES> &types);
     bool end_alignment_files(std::string &base_path);
     bool add_alignment_data(std::string &base_path, QuerySequence *querySequence, QueryAlignment *alignment);
+    bool add_alignment_data(std::vector<std::string> &base_paths, QuerySequence *querySequence);
+    std::vector<QuerySequence*> get_output_order();
+    void write_alignment_rows(uint64 count, const std::function<void(uint64)> &format_row);
     QuerySequence* get_sequence(std::string&);
 
     // DATA_FLAG routines
@@ -90,18 +99,37 @@ private:
         std::vector<FileSystem::ENT_FILE_TYPES> file_types;
         uint8 go_level;
         std::vector<ENTAP_HEADERS> headers;
-        std::ofstream* file_streams[FileSystem::ENT_FILE_OUTPUT_FORMAT_MAX];
+        OutputWriter* file_writers[FileSystem::ENT_FILE_OUTPUT_FORMAT_MAX];
+    };
+
+    struct OutputChunk {
+        std::vector<std::pair<OutputWriter*, std::string>> buffers;     // Per file, first write order
+        std::exception_ptr error;
+    };
+
+    struct TranscriptomeShard {
+        std::vector<std::pair<std::string, QuerySequence*>> sequences;   // File order
+        std::vector<uint16> sequence_lengths;
+        SequencePool pool;
+        SlabAllocator<QuerySequence> slab;
     };
 
     void set_input_type(std::string&);
+    void parse_transcriptome_range(const char*, const char*, bool, TranscriptomeShard*);
+    void free_sequences();
     bool DATA_FLAG_GET(DATA_FLAGS);
     void DATA_FLAG_SET(DATA_FLAGS);
     void DATA_FLAG_CLEAR(DATA_FLAGS);
     void DATA_FLAG_CHANGE(DATA_FLAGS flag, bool val);
+    void write_output(OutputWriter *writer, const std::string &data);
 
     const uint8         LINE_COUNT   = 20;
     const uint8         SEQ_DPRINT_CONUT = 10;
     const uint8         NUCLEO_DEV   = 2;
+    const uint32        OUT_BUFFER_SIZE = 4 * 1024 * 1024;  // Bytes buffered before write
+    const uint32        PARSE_CHUNK_MIN = 8 * 1024 * 1024;  // Min bytes per parse thread
+    const uint32        OUTPUT_CHUNK_ROWS = 2048;           // Rows formatted per output chunk
+    const uint16        OUTPUT_CHUNKS_AHEAD = 4;            // Chunks per thread held ahead of writer
     const fp32          N_50_PERCENT = 0.5;
     const fp32          N_90_PERCENT = 0.9;
     const std::string   NUCLEO_FLAG  = "Nucleotide";
@@ -118,6 +146,8 @@ private:
     const std::string OUT_ANNOTATED_PROT   = "final_annotated.faa";
 
     QUERY_MAP_T  *_pSEQUENCES;
+    SequencePool  _sequence_pool;           // Sequence data for every query
+    SlabAllocator<QuerySequence> _sequence_slab;
     bool         _no_trim;
     uint32       _total_sequences;          // Original sequence number
     uint32       _data_flags;
@@ -127,6 +157,7 @@ private:
     FileSystem  *_pFileSystem;
     UserInput   *_pUserInput;
     std::unordered_map<std::string, OutputFileData> _alignment_files;
+    static thread_local OutputChunk *_pOutputChunk;     // Set while formatting a chunk on a worker
 };
 
 
@@ -37,12 +37,9 @@ unsigned long QuerySequence::getSeq_length() const {
     return _seq_length;
 }
 
-QuerySequence::QuerySequence() {
-    init_sequence();
-}
-
-const std::string &QuerySequence::get_sequence_p() const {
-    return _sequence_p;
+std::string QuerySequence::get_sequence_p() const {
+    if (_sequence_p_ref == SequencePool::NULL_REF) return "";
+    return std::string(_pSequencePool->get(_sequence_p_ref), _sequence_p_len);
 }
 
 void QuerySequence::set_sequence_p(std::string &seq) {
@@ -51,30 +48,67 @@ void QuerySequence::set_sequence_p(std::string &seq) {
     if (!seq.empty() && seq[seq.length()-1] == '\n') {
         seq.pop_back();
     }
-    _sequence_p = seq;}
+    _sequence_p_ref = _pSequencePool->append(seq.data(), seq.length());
+    _sequence_p_len = (uint32) seq.length();
+}
 
-const std::string &QuerySequence::get_sequence_n() const {
-    return _sequence_n;
+std::string QuerySequence::get_sequence_n() const {
+    if (_sequence_n_ref == SequencePool::NULL_REF) return "";
+    return std::string(_pSequencePool->get(_sequence_n_ref), _sequence_n_len);
 }
 
 void QuerySequence::set_sequence_n(const std::string &_sequence_n) {
-    QuerySequence::_sequence_n = _sequence_n;
+    _sequence_n_ref = _pSequencePool->append(_sequence_n.data(), _sequence_n.length());
+    _sequence_n_len = (uint32) _sequence_n.length();
 }
 
-QuerySequence::QuerySequence(bool is_protein, std::string seq, std::string seqid){
+/**
+ * ======================================================================
+ * Function QuerySequence::QuerySequence(bool is_protein, std::string &seqid,
+ *                                       SequencePool *pool,
+ *                                       SequencePool::seq_ref_t seq_ref,
+ *                                       uint32 seq_ref_len, unsigned long seq_len)
+ *
+ * Description          - Creates query referencing FASTA record (header
+ *                        included) already stored in sequence pool
+ *
+ * Notes                - Sequence length is known at parse time, no need
+ *                        to re-scan
+ *
+ * @param is_protein    - Sequence is protein
+ * @param seqid         - Sequence ID
+ * @param pool          - Pool holding the sequence
+ * @param seq_ref       - Reference to sequence in pool
+ * @param seq_ref_len   - Bytes of sequence in pool
+ * @param seq_len       - Sequence length (nucleotide)
+ *
+ * =====================================================================
+ */
+QuerySequence::QuerySequence(bool is_protein, std::string &seqid, SequencePool *pool,
+                             SequencePool::seq_ref_t seq_ref, uint32 seq_ref_len, unsigned long seq_len){
     init_sequence();
     this->_seq_id = seqid;
+    _pSequencePool = pool;
     is_protein ? this->QUERY_FLAG_SET(QUERY_IS_PROTEIN) : this->QUERY_FLAG_CLEAR(QUERY_IS_PROTEIN);
-    _seq_length = calc_seq_length(seq,is_protein);
-    if (!seq.empty() && seq[seq.length()-1] == '\n') {
-        seq.pop_back();
+    _seq_length = seq_len;
+    if (is_protein) {
+        _sequence_p_ref = seq_ref;
+        _sequence_p_len = seq_ref_len;
+    } else {
+        _sequence_n_ref = seq_ref;
+        _sequence_n_len = seq_ref_len;
     }
-    is_protein ? _sequence_p = seq : _sequence_n = seq;
-    set_header_data();
+}
+
+// Used when a parsing thread's pool is merged into the final pool
+void QuerySequence::rebase_sequences(SequencePool *pool, uint32 block_base) {
+    _pSequencePool  = pool;
+    _sequence_p_ref = SequencePool::rebase(_sequence_p_ref, block_base);
+    _sequence_n_ref = SequencePool::rebase(_sequence_n_ref, block_base);
 }
 
 unsigned long QuerySequence::calc_seq_length(std::string &seq,bool protein) {
-    std::string sub = seq.substr(seq.find('n')+1);
+    std::string sub = seq.substr(seq.find('\n')+1);
     long line_chars = std::count(sub.begin(),sub.end(),'\n');
     unsigned long seq_len = sub.length() - line_chars;
     if (protein) seq_len *= 3;
@@ -87,7 +121,6 @@ const std::string &QuerySequence::getFrame() const {
 
 void QuerySequence::setFrame(const std::string &frame) {
     QuerySequence::_frame = frame;
-    set_header_data();
 }
 
 #ifdef EGGNOG_MAPPER
@@ -102,22 +135,23 @@ void QuerySequence::init_sequence() {
     _seq_length = 0;
     _fpkm = 0;
 
-    _alignment_data = new AlignmentData(this);
-    _eggnog_results = EggnogResults();
+    _alignment_data = nullptr;
+    _pSequencePool  = nullptr;
 
     _frame = "";
-    _sequence_p = "";
-    _sequence_n = "";
+    _sequence_p_ref = SequencePool::NULL_REF;
+    _sequence_n_ref = SequencePool::NULL_REF;
+    _sequence_p_len = 0;
+    _sequence_n_len = 0;
 
     _query_flags = 0;
     QUERY_FLAG_SET(QUERY_FRAME_KEPT);
     QUERY_FLAG_SET(QUERY_EXPRESSION_KEPT);
-    set_header_data();
 }
 
-const std::string &QuerySequence::get_sequence() const {
-    if (_sequence_n.empty()) return _sequence_p;
-    return _sequence_n;
+std::string QuerySequence::get_sequence() const {
+    if (_sequence_n_len == 0) return get_sequence_p();
+    return get_sequence_n();
 }
 
 
@@ -139,20 +173,101 @@ const std::string &QuerySequence::get_sequence() const {
  * =====================================================================
  */
 std::string QuerySequence::print_delim(std::vector<ENTAP_HEADERS> &headers, short lvl, char delim) {
-//    init_header();
-    std::stringstream stream;
-    go_format_t go_terms;
-    std::string val;
+    std::string row;
+
+    print_delim(headers, lvl, delim, row);
+    return row;
+}
+
+
+/**
+ * ======================================================================
+ * Function void QuerySequence::print_delim(std::vector<ENTAP_HEADERS> &headers,
+ *                                          short lvl, char delim, std::string &row)
+ *
+ * Description          - Appends a delimited row of header values to row
+ *
+ * Notes                - Field values go through one scratch string per
+ *                        thread so its capacity is reused across rows
+ *
+ * @param headers       - Headers to print
+ * @param lvl           - Go level that would be normalized to
+ * @param delim         - Field delimiter
+ * @param row           - Output, appended to
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void QuerySequence::print_delim(std::vector<ENTAP_HEADERS> &headers, short lvl, char delim, std::string &row) {
+    static thread_local std::string val;
 
     for (ENTAP_HEADERS &header : headers) {
         if (ENTAP_HEADER_INFO[header].print_header) {
             get_header_data(val, header, lvl);
-            stream << val << delim;
+            row += val;
+            row += delim;
+        }
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void QuerySequence::print_delim(std::vector<ENTAP_HEADERS> &headers,
+ *                                          const std::vector<uint8> &levels,
+ *                                          char delim, std::vector<std::string> &rows)
+ *
+ * Description          - Appends one delimited row per GO level in a single
+ *                        pass over the headers
+ *
+ * Notes                - Only GO columns differ between levels, every other
+ *                        column is formatted once and copied to each row
+ *
+ * @param headers       - Headers to print
+ * @param levels        - Go levels to normalize to, one row each
+ * @param delim         - Field delimiter
+ * @param rows          - Output, rows[i] is appended for levels[i]
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void QuerySequence::print_delim(std::vector<ENTAP_HEADERS> &headers, const std::vector<uint8> &levels, char delim,
+                                std::vector<std::string> &rows) {
+    static thread_local std::string val;
+    QueryAlignment *align_ptr;
+
+    for (ENTAP_HEADERS &header : headers) {
+        if (!ENTAP_HEADER_INFO[header].print_header) continue;
+        align_ptr = get_header_alignment(header);
+        if (align_ptr == nullptr || !align_ptr->get_header_levels(header, levels, rows)) {
+            get_header_data(val, header, 0);
+            for (std::string &row : rows) row += val;
         }
+        for (std::string &row : rows) row += delim;
     }
-    return stream.str();
 }
 
+/**
+ * ======================================================================
+ * Function void QuerySequence::get_header_data(std::string &data,
+ *                                              ENTAP_HEADERS header, uint8 lvl)
+ *
+ * Description          - Formats header value for output, computed on
+ *                        demand from query fields or the best alignment
+ *                        of the software that owns the header
+ *
+ * Notes                - None
+ *
+ * @param data          - Set to header value (empty if no data)
+ * @param header        - Header to get
+ * @param lvl           - GO level to normalize GO terms to
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
 void QuerySequence::get_header_data(std::string &data, ENTAP_HEADERS header, uint8 lvl) {
     QueryAlignment *align_ptr = nullptr;
 
@@ -160,68 +275,43 @@ void QuerySequence::get_header_data(std::string &data, ENTAP_HEADERS header, uin
 
     switch (header) {
 
-        case ENTAP_HEADER_SIM_UNI_GO_BIO:
-        case ENTAP_HEADER_SIM_UNI_GO_MOLE:
-        case ENTAP_HEADER_SIM_UNI_GO_CELL:
-            align_ptr = get_best_hit_alignment<SimSearchAlignment>(SIMILARITY_SEARCH, SIM_DIAMOND, "");
-            break;
+        case ENTAP_HEADER_QUERY:
+            data = _seq_id;
+            return;
 
-        case ENTAP_HEADER_ONT_EGG_GO_MOLE:
-        case ENTAP_HEADER_ONT_EGG_GO_CELL:
-        case ENTAP_HEADER_ONT_EGG_GO_BIO:
-            align_ptr = get_best_hit_alignment<EggnogDmndAlignment>(GENE_ONTOLOGY, ONT_EGGNOG_DMND, "");
-            break;
+        case ENTAP_HEADER_FRAME:
+            data = _frame;
+            return;
 
-        case ENTAP_HEADER_ONT_INTER_GO_BIO:
-        case ENTAP_HEADER_ONT_INTER_GO_CELL:
-        case ENTAP_HEADER_ONT_INTER_GO_MOLE:
-            align_ptr = get_best_hit_alignment<InterproAlignment>(GENE_ONTOLOGY, ONT_INTERPRO_SCAN, "");
-            break;
+        case ENTAP_HEADER_EXP_FPKM:
+            data = float_to_string(_fpkm);
+            return;
 
         default:
-            data = _header_info[header];
             break;
     }
 
+    align_ptr = get_header_alignment(header);
     if (align_ptr != nullptr) {
         align_ptr->get_header_data(header, data, lvl);
     }
 }
 
-void QuerySequence::set_header_data() {
-    QueryAlignment *align_ptr = nullptr;
-
-    // General data
-    _header_info[ENTAP_HEADER_QUERY] = this->_seq_id;
-
-    // Frame Selection data
-    _header_info[ENTAP_HEADER_FRAME] = this->_frame;
-
-    // Expression Filtering data
-    _header_info[ENTAP_HEADER_EXP_FPKM] = float_to_string(this->_fpkm);
-
-    // Similarity Search data
-    align_ptr = this->_alignment_data->get_best_align_ptr(SIMILARITY_SEARCH, SIM_DIAMOND, "");
-    if (align_ptr != nullptr) {
-        align_ptr->get_all_header_data(_header_info);
-    }
-
-    // Ontology EggNOG data
-    align_ptr = this->_alignment_data->get_best_align_ptr(GENE_ONTOLOGY, ONT_EGGNOG_DMND, "");
-    if (align_ptr != nullptr) {
-        align_ptr->get_all_header_data(_header_info);
-    }
 
-    // Ontology InterProScan data
-    align_ptr = this->_alignment_data->get_best_align_ptr(GENE_ONTOLOGY, ONT_INTERPRO_SCAN, "");
-    if (align_ptr != nullptr) {
-        align_ptr->get_all_header_data(_header_info);
+// Returns best alignment of the software that owns a header, nullptr if none
+QueryAlignment *QuerySequence::get_header_alignment(ENTAP_HEADERS header) {
+    if (header >= ENTAP_HEADER_SIM_SUBJECT && header <= ENTAP_HEADER_SIM_UNI_GO_MOLE) {
+        return get_best_hit_alignment<SimSearchAlignment>(SIMILARITY_SEARCH, SIM_DIAMOND, "");
+    } else if (header >= ENTAP_HEADER_ONT_EGG_SEED_ORTHO && header <= ENTAP_HEADER_ONT_EGG_PROTEIN) {
+        return get_best_hit_alignment<EggnogDmndAlignment>(GENE_ONTOLOGY, ONT_EGGNOG_DMND, "");
+    } else if (header >= ENTAP_HEADER_ONT_INTER_GO_BIO && header <= ENTAP_HEADER_ONT_INTER_EVAL) {
+        return get_best_hit_alignment<InterproAlignment>(GENE_ONTOLOGY, ONT_INTERPRO_SCAN, "");
     }
+    return nullptr;
 }
 
 void QuerySequence::set_fpkm(float _fpkm) {
     QuerySequence::_fpkm = _fpkm;
-    set_header_data();
 }
 
 bool QuerySequence::isContaminant() {
@@ -258,23 +348,28 @@ QuerySequence::~QuerySequence() {
     delete _alignment_data;
 }
 
+QuerySequence::AlignmentData *QuerySequence::get_alignment_data() {
+    if (_alignment_data == nullptr) _alignment_data = new AlignmentData(this);
+    return _alignment_data;
+}
+
 void QuerySequence::add_alignment(ExecuteStates state, uint16 software, EggnogResults &results, std::string& database) {
     QUERY_FLAG_SET(QUERY_EGGNOG_HIT);
     QUERY_FLAG_SET(QUERY_FAMILY_ASSIGNED);
-    _alignment_data->update_best_hit(state, software, database, new EggnogDmndAlignment(results,this));
+    get_alignment_data()->update_best_hit(state, software, database, new EggnogDmndAlignment(results,this));
 }
 
 void QuerySequence::add_alignment(ExecuteStates state, uint16 software, SimSearchResults &results, std::string& database,std::string lineage) {
     QUERY_FLAG_SET(QUERY_BLAST_HIT);
     QueryAlignment *new_alignment = new SimSearchAlignment(results, lineage, this);
-    _alignment_data->update_best_hit(state, software, database, new_alignment);
+    get_alignment_data()->update_best_hit(state, software, database, new_alignment);
 }
 
 void QuerySequence::add_alignment(ExecuteStates state, uint16 software, QuerySequence::InterProResults &results,
                                   std::string &database) {
     QUERY_FLAG_SET(QUERY_INTERPRO);
     QueryAlignment *new_alignmet = new InterproAlignment(results, this);
-    _alignment_data->update_best_hit(state, software, database, new_alignmet);
+    get_alignment_data()->update_best_hit(state, software, database, new_alignmet);
 }
 
 //**********************************************************************
@@ -315,35 +410,28 @@ QuerySequence::AlignmentData::~AlignmentData() {
 void QuerySequence::AlignmentData::update_best_hit(ExecuteStates state, uint16 software, std::string &database, QueryAlignment* new_alignment) {
     ALIGNMENT_DATA_T* alignment_arr = get_software_ptr(state, software);
 
-
     // Did we hit against this database yet
     if (!hit_database(state, software, database)) {
         // No, create new vector for that database and add as best hit for database
         align_database_hits_t vect = {new_alignment};
         alignment_arr->emplace(database, vect);
     } else {
-        // Yes, add alignment to list then update
-        alignment_arr->at(database).push_back(new_alignment);
+        // Yes, add alignment to list. Only the best hit for the database is kept
+        //  at index 0, remaining hits are left in the order they were parsed and
+        //  ranked when written out (ModDiamond::calculate_best_stats)
+        align_database_hits_t *database_data = &alignment_arr->at(database);
+        database_data->push_back(new_alignment);
+        if (new_alignment->is_better(*database_data->front(), false)) {
+            std::swap(database_data->front(), database_data->back());
+        }
     }
 
-    // Always will have hit this database, get alignments
-    align_database_hits_t *database_data = &alignment_arr->at(database);
-
-    // Sort alignments for that database (0 index is best hit)
-    std::sort(database_data->begin(), database_data->end(), sort_descending_database());
-
     // See if this alignment is better than the overall alignment
-    new_alignment->set_compare_overall_alignment(true);
     QueryAlignment* best_alignment = get_best_align_ptr(state, software, "");
 
-    if (best_alignment == nullptr) {
+    if (best_alignment == nullptr || new_alignment->is_better(*best_alignment, true)) {
         // Replace if so
         set_best_alignment(state, software, new_alignment);
-    } else {
-        best_alignment->set_compare_overall_alignment(true);
-        if (*new_alignment > *best_alignment) {
-            set_best_alignment(state, software, new_alignment);
-        }
     }
 
     // Update any overall flags that may have changed with best hit changes
@@ -364,6 +452,7 @@ void QuerySequence::update_query_flags(ExecuteStates state, uint16 software) {
     switch (state) {
         case SIMILARITY_SEARCH: {
             SimSearchAlignment *best_align = get_best_hit_alignment<SimSearchAlignment>(state, software, "");
+            if (best_align == nullptr) break;
             SimSearchResults *results = best_align->get_results();
             QUERY_FLAG_CHANGE(QUERY_INFORMATIVE, results->is_informative);
             QUERY_FLAG_CHANGE(QUERY_CONTAMINANT, results->contaminant);
@@ -374,10 +463,10 @@ void QuerySequence::update_query_flags(ExecuteStates state, uint16 software) {
             switch (software) {
                 case ONT_EGGNOG_DMND: {
                     EggnogDmndAlignment *best_align = get_best_hit_alignment<EggnogDmndAlignment>(state, software,"");
-                    EggnogResults *results = best_align->get_results();
 
                     // in case results were 'refreshed'
                     if (best_align != nullptr) {
+                        EggnogResults *results = best_align->get_results();
                         QUERY_FLAG_CHANGE(QUERY_FAMILY_ONE_GO, !results->parsed_go.empty());
                         QUERY_FLAG_CHANGE(QUERY_FAMILY_ONE_KEGG, !results->kegg.empty());
 
@@ -390,6 +479,7 @@ void QuerySequence::update_query_flags(ExecuteStates state, uint16 software) {
                 }
                 case ONT_INTERPRO_SCAN: {
                     InterproAlignment *best_align = get_best_hit_alignment<InterproAlignment>(state, software, "");
+                    if (best_align == nullptr) break;
                     InterProResults *results = best_align->get_results();
 
                     QUERY_FLAG_CHANGE(QUERY_ONT_INTERPRO_GO, !results->parsed_go.empty());
@@ -409,11 +499,11 @@ void QuerySequence::update_query_flags(ExecuteStates state, uint16 software) {
         default:
             break;
     }
-    set_header_data();
 }
 
 QuerySequence::align_database_hits_t *
 QuerySequence::get_database_hits(std::string &database, ExecuteStates state, uint16 software) {
+    if (_alignment_data == nullptr) return nullptr;
     return this->_alignment_data->get_database_ptr(state, software, database);
 }
 
@@ -428,7 +518,51 @@ std::string QuerySequence::format_go_info(std::vector<std::string> &go_list, uin
     return out.str();
 }
 
+
+/**
+ * ======================================================================
+ * Function void QuerySequence::format_go_levels(std::vector<std::string> &go_list,
+ *                                               const std::vector<uint8> &levels,
+ *                                               std::vector<std::string> &rows)
+ *
+ * Description          - Multi level version of format_go_info, appends the
+ *                        terms of levels[i] to rows[i]
+ *
+ * Notes                - Level of each term ("(L=3)") is located once and
+ *                        matched against every output level
+ *
+ * @param go_list       - Formatted GO terms
+ * @param levels        - Go levels (0 for all terms)
+ * @param rows          - Output, one per level
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void QuerySequence::format_go_levels(std::vector<std::string> &go_list, const std::vector<uint8> &levels,
+                                     std::vector<std::string> &rows) {
+    static thread_local vect_str_t level_tags;
+    const std::string level_start = "(L=";
+    uint64 level_pos;
+
+    level_tags.resize(levels.size());
+    for (uint64 i = 0; i < levels.size(); i++) level_tags[i] = std::to_string(levels[i]);
+
+    for (std::string &val : go_list) {
+        level_pos = val.find(level_start);
+        if (level_pos != std::string::npos) level_pos += level_start.length();
+        for (uint64 i = 0; i < levels.size(); i++) {
+            if (levels[i] == 0 ||
+                (level_pos != std::string::npos && val.compare(level_pos, level_tags[i].length(), level_tags[i]) == 0)) {
+                rows[i] += val;
+                rows[i] += ',';
+            }
+        }
+    }
+}
+
 bool QuerySequence::hit_database(ExecuteStates state, uint16 software, std::string database) {
+    if (_alignment_data == nullptr) return false;
     return _alignment_data->hit_database(state, software, database);
 }
 
@@ -476,10 +610,3 @@ void
 QuerySequence::AlignmentData::set_best_alignment(ExecuteStates state, uint16 software, QueryAlignment *alignment) {
     overall_alignment[state][software] = alignment;
 }
-
-bool QuerySequence::AlignmentData::sort_descending_database::operator()(QueryAlignment *first,
-                                                                        QueryAlignment *second) {
-        first->set_compare_overall_alignment(false);
-        second->set_compare_overall_alignment(false);
-        return *first > *second;
-}
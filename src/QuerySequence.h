@@ -32,6 +32,7 @@
 #include "common.h"
 #include "EntapExecute.h"
 #include "database/EntapDatabase.h"
+#include "QueryStorage.h"
 
 class QueryAlignment;
 
@@ -134,10 +135,6 @@ public:
 
         QueryAlignment* overall_alignment[EXECUTION_MAX][ONT_SOFTWARE_COUNT]{};
 
-        struct sort_descending_database {
-            bool operator () (QueryAlignment* first, QueryAlignment* second);
-        };
-
         AlignmentData(QuerySequence* sequence);
         ~AlignmentData();
 
@@ -153,18 +150,21 @@ public:
 
 
     /* Public Functions */
-    QuerySequence();
-    QuerySequence(bool, std::string, std::string);
+    QuerySequence(bool, std::string&, SequencePool*, SequencePool::seq_ref_t, uint32, unsigned long);
     ~QuerySequence();
     std::string print_delim(std::vector<ENTAP_HEADERS> &, short lvl ,char delim);
+    void print_delim(std::vector<ENTAP_HEADERS> &, short lvl, char delim, std::string &row);
+    void print_delim(std::vector<ENTAP_HEADERS> &, const std::vector<uint8> &levels, char delim,
+                     std::vector<std::string> &rows);
     void setFrame(const std::string &frame);
     unsigned long getSeq_length() const;
     const std::string &getFrame() const;
-    const std::string &get_sequence_p() const;
+    std::string get_sequence_p() const;
     void set_sequence_p(std::string &seq);
-    const std::string &get_sequence_n() const;
+    std::string get_sequence_n() const;
     void set_sequence_n(const std::string &_sequence_n);
-    const std::string &get_sequence() const;
+    std::string get_sequence() const;
+    void rebase_sequences(SequencePool *pool, uint32 block_base);
     void set_fpkm(float _fpkm);
     bool is_kept();
     bool QUERY_FLAG_GET(QUERY_FLAGS flag);
@@ -182,10 +182,13 @@ public:
     QuerySequence::align_database_hits_t* get_database_hits(std::string& database,ExecuteStates state, uint16 software);
 
     std::string format_go_info(std::vector<std::string> &go_list, uint8 lvl);
+    void format_go_levels(std::vector<std::string> &go_list, const std::vector<uint8> &levels,
+                          std::vector<std::string> &rows);
 
     // Returns recast alignment pointer
     template<class T>
     T *get_best_hit_alignment(ExecuteStates state, uint16 software, std::string database) {
+        if (_alignment_data == nullptr) return nullptr;
         return static_cast<T*>(_alignment_data->get_best_align_ptr(state, software, database));
     }
 
@@ -193,22 +196,27 @@ public:
     bool hit_database(ExecuteStates state, uint16 software, std::string database);
     void update_query_flags(ExecuteStates state, uint16 software);
     void get_header_data(std::string& data, ENTAP_HEADERS header, uint8 lvl);
-    void set_header_data();
+    QueryAlignment *get_header_alignment(ENTAP_HEADERS header);
 
 private:
     fp32                              _fpkm;
     uint32                            _query_flags;
+    uint32                            _sequence_p_len;
+    uint32                            _sequence_n_len;
+    SequencePool::seq_ref_t           _sequence_p_ref;
+    SequencePool::seq_ref_t           _sequence_n_ref;
+    SequencePool                      *_pSequencePool;   // Owned by QueryData
     std::string                       _seq_id;
     unsigned long                     _seq_length;
-    std::string                       _sequence_p;
-    std::string                       _sequence_n;
     std::string                       _frame;
+#ifdef EGGNOG_MAPPER
     EggnogResults                     _eggnog_results;
-    AlignmentData                     *_alignment_data;  // contains all alignment data
-    std::string                       _header_info[ENTAP_HEADER_COUNT];
+#endif
+    AlignmentData                     *_alignment_data;  // contains all alignment data, allocated on first hit
 
     /* Private Functions */
     void init_sequence();
+    AlignmentData *get_alignment_data();
     unsigned long calc_seq_length(std::string &,bool);
 
 };
@@ -0,0 +1,131 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "QueryStorage.h"
+//**************************************************************
+
+const SequencePool::seq_ref_t SequencePool::NULL_REF;
+const uint64 SequencePool::BLOCK_SIZE;
+
+
+SequencePool::SequencePool() {
+    _bytes_used = 0;
+}
+
+SequencePool::~SequencePool() {
+    for (PoolBlock &block : _blocks) {
+        delete[] block.data;
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function char *SequencePool::reserve(uint64 max_len)
+ *
+ * Description          - Returns a write pointer with room for at least
+ *                        max_len contiguous bytes
+ *                      - Record must be finished with commit()
+ *
+ * Notes                - Sequences larger than a block get a block of
+ *                        their own
+ *
+ * @param max_len       - Upper bound of bytes that will be written
+ *
+ * @return              - Pointer to write sequence data to
+ *
+ * =====================================================================
+ */
+char *SequencePool::reserve(uint64 max_len) {
+    if (_blocks.empty() || _blocks.back().size - _blocks.back().used < max_len) {
+        PoolBlock block;
+        block.size = std::max(BLOCK_SIZE, max_len);
+        block.data = new char[block.size];
+        block.used = 0;
+        _blocks.push_back(block);
+    }
+    return _blocks.back().data + _blocks.back().used;
+}
+
+SequencePool::seq_ref_t SequencePool::commit(uint64 len) {
+    seq_ref_t ref;
+
+    ref = ((uint64) (_blocks.size() - 1) << 32) | _blocks.back().used;
+    _blocks.back().used += len;
+    _bytes_used += len;
+    return ref;
+}
+
+SequencePool::seq_ref_t SequencePool::append(const char *data, uint64 len) {
+    char *dest = reserve(len);
+    memcpy(dest, data, len);
+    return commit(len);
+}
+
+const char *SequencePool::get(seq_ref_t ref) const {
+    return _blocks[ref >> 32].data + (ref & 0xFFFFFFFFULL);
+}
+
+
+/**
+ * ======================================================================
+ * Function uint32 SequencePool::merge(SequencePool &other)
+ *
+ * Description          - Moves all blocks from another pool to the end of
+ *                        this one, no sequence data is copied
+ *
+ * Notes                - References from the other pool must be adjusted
+ *                        with rebase()
+ *                      - Unused tail of a block is left behind, it was
+ *                        never touched so costs no resident memory
+ *
+ * @param other         - Pool to take blocks from, left empty
+ *
+ * @return              - Block base to rebase references with
+ *
+ * =====================================================================
+ */
+uint32 SequencePool::merge(SequencePool &other) {
+    uint32 block_base;
+
+    block_base = (uint32) _blocks.size();
+    _blocks.insert(_blocks.end(), other._blocks.begin(), other._blocks.end());
+    _bytes_used += other._bytes_used;
+    other._blocks.clear();
+    other._bytes_used = 0;
+    return block_base;
+}
+
+uint64 SequencePool::bytes_used() const {
+    return _bytes_used;
+}
+
+SequencePool::seq_ref_t SequencePool::rebase(seq_ref_t ref, uint32 block_base) {
+    if (ref == NULL_REF) return ref;
+    return ref + ((uint64) block_base << 32);
+}
@@ -0,0 +1,145 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ENTAP_QUERYSTORAGE_H
+#define ENTAP_QUERYSTORAGE_H
+
+//*********************** Includes *****************************
+#include "common.h"
+#include <memory>
+//**************************************************************
+
+
+/**
+ * Contiguous storage for query sequences. Data is appended into large blocks
+ * that are never reallocated, each sequence is addressed by a reference
+ * packing (block index << 32 | offset within block).
+ *
+ * Not thread safe, each parsing thread fills its own pool which is then
+ * merged into the final pool.
+ */
+class SequencePool {
+
+public:
+    typedef uint64 seq_ref_t;
+
+    static const seq_ref_t NULL_REF = ~0ULL;
+
+    SequencePool();
+    ~SequencePool();
+
+    char *reserve(uint64 max_len);
+    seq_ref_t commit(uint64 len);
+    seq_ref_t append(const char *data, uint64 len);
+    const char *get(seq_ref_t ref) const;
+    uint32 merge(SequencePool &other);
+    uint64 bytes_used() const;
+
+    static seq_ref_t rebase(seq_ref_t ref, uint32 block_base);
+
+private:
+    struct PoolBlock {
+        char   *data;
+        uint64  size;
+        uint64  used;
+    };
+
+    SequencePool(const SequencePool&) = delete;
+    SequencePool& operator=(const SequencePool&) = delete;
+
+    static const uint64 BLOCK_SIZE = 16 * 1024 * 1024;
+
+    std::vector<PoolBlock> _blocks;
+    uint64                 _bytes_used;
+};
+
+
+/**
+ * Slab allocator for fixed size records (QuerySequence). Records are
+ * constructed in place inside large slabs rather than one heap allocation
+ * each. Memory is only returned to the system when the allocator is
+ * destroyed, records must be destroyed by the owner beforehand.
+ */
+template<class T>
+class SlabAllocator {
+
+public:
+    explicit SlabAllocator(uint32 per_slab = 4096) {
+        _per_slab = per_slab;
+        _used     = per_slab;   // Force slab on first create
+    }
+
+    ~SlabAllocator() {
+        for (char *slab : _slabs) {
+            delete[] slab;
+        }
+    }
+
+    template<class... Args>
+    T *create(Args&&... args) {
+        if (_used == _per_slab) {
+            _slabs.push_back(new char[sizeof(T) * _per_slab]);
+            _used = 0;
+        }
+        void *mem = _slabs.back() + sizeof(T) * _used++;
+        return new (mem) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *record) {
+        if (record != nullptr) record->~T();
+    }
+
+    // Take ownership of another allocator's slabs
+    void merge(SlabAllocator &other) {
+        if (other._slabs.empty()) return;
+        // Keep our partially used slab last so create() continues in it
+        if (_slabs.empty()) {
+            _used = other._used;
+            _slabs.swap(other._slabs);
+        } else {
+            _slabs.insert(_slabs.end() - 1, other._slabs.begin(), other._slabs.end());
+            other._slabs.clear();
+        }
+        other._used = other._per_slab;
+    }
+
+    uint64 bytes_reserved() const {
+        return (uint64) _slabs.size() * _per_slab * sizeof(T);
+    }
+
+private:
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    std::vector<char*> _slabs;
+    uint32             _per_slab;
+    uint32             _used;       // Records used in the last slab
+};
+
+
+#endif //ENTAP_QUERYSTORAGE_H
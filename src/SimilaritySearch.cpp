@@ -28,6 +28,7 @@
 //*********************** Includes *****************************
 #include "SimilaritySearch.h"
 #include "similarity_search/ModDiamond.h"
+#include "Instrumentation.h"
 //**************************************************************
 
 /**
@@ -84,9 +85,13 @@ void SimilaritySearch::execute() {
         ptr = spawn_object();
         verifyData = ptr->verify_files();
         if (!verifyData.files_exist) {
+            Instrumentation::ScopedTimer timer("run");
             ptr->execute();
         }
-        ptr->parse();
+        {
+            Instrumentation::ScopedTimer timer("parse");
+            ptr->parse();
+        }
         ptr.reset();
     } catch (const ExceptionHandler &e) {
         ptr.reset();
@@ -25,25 +25,85 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <pstream.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cerrno>
 #include "TerminalCommands.h"
 #include "common.h"
 #include "FileSystem.h"
+#include "Instrumentation.h"
+
+static const uint32 POLL_INTERVAL_MS = 200;    // Timeout/cancel checks while child is quiet
+static const uint32 KILL_GRACE_MS    = 5000;   // SIGTERM to SIGKILL
+
+
+// Appends data to a stream tail, keeping at most TC_STREAM_TAIL_MAX bytes (amortized)
+static void append_tail(std::string &tail, const char *data, uint64 len) {
+    tail.append(data, len);
+    if (tail.size() > 2 * TC_STREAM_TAIL_MAX) tail.erase(0, tail.size() - TC_STREAM_TAIL_MAX);
+}
+
+
+// Writes all of data to fd (retries short writes), false on error
+static bool write_all(int fd, const char *data, uint64 len) {
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        len  -= (uint64) written;
+    }
+    return true;
+}
+
+
+// Kills the child's process group, SIGKILL if it ignores SIGTERM. Returns wait status
+static int kill_child(pid_t pid) {
+    int    status = 0;
+    uint32 waited = 0;
+
+    kill(-pid, SIGTERM);
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (waited >= KILL_GRACE_MS) {
+            kill(-pid, SIGKILL);
+            while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        waited += 50;
+    }
+    return status;
+}
 
 
 /**
  * ======================================================================
  * Function int execute_cmd(std::string cmd, std::stringstream err_stream, std::stringstream out_stream)
  *
- * Description          - Terminal stream based on pstreams implementation
- *                      - Executes commands and prints to err/out stream
+ * Description          - Runs a command through /bin/sh with std out/err
+ *                        piped back, streamed to files as it arrives
+ *                      - Blocks in poll() while the child is running, no
+ *                        busy waiting
  *
- * Notes                - None
+ * Notes                - Only the last TC_STREAM_TAIL_MAX bytes of each
+ *                        stream are kept in terminalData, full output is
+ *                        in the .out/.err files if print_files is set
+ *                      - If timeout_secs passes or *cancel is set the
+ *                        child's process group is terminated
+ *                      - Wall/CPU time and memory of the command are
+ *                        recorded for the timings report
  *
  * @param cmd           - Command for child process
  * @param out_path      - Path to std out/err files to be printed
  *
- * @return              - int error code
+ * @return              - Wait status of child (0 success) or TC_ERR_*
  *
  * =====================================================================
  */
@@ -51,59 +111,155 @@ int TC_execute_cmd(TerminalData &terminalData) {
 
     FS_dprint("Executing command: \n" + terminalData.command);
 
-    std::stringstream err_stream;
-    std::stringstream out_stream;
-
-    const redi::pstreams::pmode mode = redi::pstreams::pstdout|redi::pstreams::pstderr;
-    redi::ipstream child(terminalData.command, mode);
-    char buf[1024];
-    std::streamsize n;
-    bool finished[2] = { false, false };
-    while (!finished[0] || !finished[1]) {
-        if (!finished[0]) {
-            while ((n = child.err().readsome(buf, sizeof(buf))) > 0)
-                err_stream.write(buf, n);
-            if (child.eof()) {
-                finished[0] = true;
-                if (!finished[1])
-                    child.clear();
-            }
-        }
-        if (!finished[1]) {
-            while ((n = child.out().readsome(buf, sizeof(buf))) > 0) {
-                out_stream.write(buf, n).flush();
-            }
-            if (child.eof()) {
-                finished[1] = true;
-                if (!finished[0])
-                    child.clear();
-            }
-        }
-    }
-    child.close();
-
-    terminalData.err_stream = err_stream.str();
-    terminalData.out_stream = out_stream.str();
+    struct rusage     child_start;
+    struct rusage     child_end;
+    struct pollfd     fds[2];
+    int               out_pipe[2];
+    int               err_pipe[2];
+    int               file_fds[2] = {-1, -1};
+    int               status = 0;
+    int               ret;
+    int               wait_ms;
+    bool              reaped = false;
+    char              buf[64 * 1024];
+    ssize_t           n;
+    pid_t             pid;
+    std::string      *tails[2] = {&terminalData.out_stream, &terminalData.err_stream};
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point deadline;
 
-    // Print error to debug file
-    FS_dprint("\nStd Err:\n" + terminalData.err_stream);
+    terminalData.out_stream.clear();
+    terminalData.err_stream.clear();
+    getrusage(RUSAGE_CHILDREN, &child_start);
+    start_time = std::chrono::steady_clock::now();
+    deadline   = start_time + std::chrono::seconds(terminalData.timeout_secs);
 
     if (terminalData.print_files) {
         std::string out_path = terminalData.base_std_path + FileSystem::EXT_OUT;
         std::string err_path = terminalData.base_std_path + FileSystem::EXT_ERR;
 
-        std::ofstream out_file(out_path, std::ios::out | std::ios::app);
-        std::ofstream err_file(err_path, std::ios::out | std::ios::app);
         FS_dprint("\nPrinting to files:\nStd Out: " + out_path + "\nStd Err: " + err_path);
+        file_fds[0] = open(out_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        file_fds[1] = open(err_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
 
-        out_file << terminalData.out_stream;
-        err_file << terminalData.err_stream;
+    // Pipes are close-on-exec so commands started from other threads do not inherit them
+    if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+        terminalData.err_stream = "Unable to create pipe for command";
+        pid = -1;
+    } else if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+        close(out_pipe[0]); close(out_pipe[1]);
+        terminalData.err_stream = "Unable to create pipe for command";
+        pid = -1;
+    } else {
+        const char *command = terminalData.command.c_str();
+        pid = fork();
+        if (pid == 0) {
+            // Child, own process group so the whole pipeline can be killed
+            setpgid(0, 0);
+            dup2(out_pipe[1], STDOUT_FILENO);
+            dup2(err_pipe[1], STDERR_FILENO);
+            execl("/bin/sh", "sh", "-c", command, (char*) nullptr);
+            _exit(127);
+        }
+        close(out_pipe[1]);
+        close(err_pipe[1]);
+        if (pid < 0) {
+            close(out_pipe[0]);
+            close(err_pipe[0]);
+            terminalData.err_stream = "Unable to start command";
+        } else {
+            setpgid(pid, pid);
+        }
+    }
+    if (pid < 0) {
+        FS_dprint("ERROR: " + terminalData.err_stream);
+        for (int fd : file_fds) if (fd >= 0) close(fd);
+        return TC_ERR_START;
+    }
+
+    fds[0].fd = out_pipe[0];
+    fds[1].fd = err_pipe[0];
+    for (struct pollfd &fd : fds) fd.events = POLLIN;
 
-        out_file.close();
-        err_file.close();
+    // Stream output until both pipes close, stopping early on timeout/cancel
+    while (fds[0].fd >= 0 || fds[1].fd >= 0 || !reaped) {
+        if (terminalData.timeout_secs > 0 && std::chrono::steady_clock::now() >= deadline) {
+            status = TC_ERR_TIMEOUT;
+        } else if (terminalData.cancel != nullptr && terminalData.cancel->load()) {
+            status = TC_ERR_CANCELLED;
+        }
+        if (status != 0) {
+            if (!reaped) kill_child(pid);
+            reaped = true;
+            break;
+        }
+
+        if (fds[0].fd < 0 && fds[1].fd < 0) {
+            // Pipes closed, wait for exit (blocking unless we still need to check timeout/cancel)
+            if (terminalData.timeout_secs == 0 && terminalData.cancel == nullptr) {
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+                reaped = true;
+            } else if (waitpid(pid, &status, WNOHANG) != 0) {
+                reaped = true;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            continue;
+        }
+
+        wait_ms = -1;
+        if (terminalData.cancel != nullptr) wait_ms = POLL_INTERVAL_MS;
+        if (terminalData.timeout_secs > 0) {
+            int64 remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+            remaining = std::max<int64>(remaining, 0);
+            wait_ms = wait_ms < 0 ? (int) std::min<int64>(remaining, INT32_MAX) :
+                      (int) std::min<int64>(remaining, wait_ms);
+        }
+        ret = poll(fds, 2, wait_ms);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (uint16 i = 0; i < 2; i++) {
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+            n = read(fds[i].fd, buf, sizeof(buf));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            if (n <= 0) {
+                close(fds[i].fd);
+                fds[i].fd = -1;     // poll ignores negative descriptors
+                continue;
+            }
+            if (file_fds[i] >= 0 && !write_all(file_fds[i], buf, (uint64) n)) {
+                FS_dprint("ERROR: unable to write command output to file");
+                close(file_fds[i]);
+                file_fds[i] = -1;
+            }
+            append_tail(*tails[i], buf, (uint64) n);
+        }
+    }
+    for (struct pollfd &fd : fds) if (fd.fd >= 0) close(fd.fd);
+    for (int fd : file_fds) if (fd >= 0) close(fd);
+    if (!reaped) {
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+    }
+
+    for (std::string *tail : tails) {
+        if (tail->size() > TC_STREAM_TAIL_MAX) tail->erase(0, tail->size() - TC_STREAM_TAIL_MAX);
+    }
+    if (status == TC_ERR_TIMEOUT) {
+        terminalData.err_stream += "\nCommand timed out after " + std::to_string(terminalData.timeout_secs) + " seconds";
+    } else if (status == TC_ERR_CANCELLED) {
+        terminalData.err_stream += "\nCommand was cancelled";
     }
 
-    if (child.rdbuf()->exited())
-        return child.rdbuf()->status();
-    return 1;
+    getrusage(RUSAGE_CHILDREN, &child_end);
+    Instrumentation::add_command(terminalData.command, terminalData.stage, status,
+        std::chrono::duration<fp64>(std::chrono::steady_clock::now() - start_time).count(), child_start, child_end);
+
+    // Print error to debug file
+    FS_dprint("\nStd Err:\n" + terminalData.err_stream);
+
+    return status;
 }
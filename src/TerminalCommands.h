@@ -28,14 +28,25 @@
 #ifndef ENTAP_TERMINALCOMMANDS_H
 #define ENTAP_TERMINALCOMMANDS_H
 
+#include <atomic>
 #include "common.h"
 
+// TC_execute_cmd return values when the command did not run to completion
+const int TC_ERR_START     = -1;        // Unable to start command
+const int TC_ERR_TIMEOUT   = -2;        // Killed after timeout_secs
+const int TC_ERR_CANCELLED = -3;        // Killed after *cancel was set
+
+const uint64 TC_STREAM_TAIL_MAX = 64 * 1024;    // Bytes of std out/err kept in TerminalData
+
 struct TerminalData{
     std::string command;
-    std::string out_stream;
-    std::string err_stream;
+    std::string out_stream;             // Last TC_STREAM_TAIL_MAX bytes of std out
+    std::string err_stream;             // Last TC_STREAM_TAIL_MAX bytes of std err
     bool print_files;
     std::string base_std_path;
+    uint64 timeout_secs = 0;                        // 0 to never time out
+    const std::atomic<bool> *cancel = nullptr;      // Command is killed once set
+    std::string stage;                              // Timing stage, calling thread's stage if empty
 
 };
 
@@ -36,6 +36,7 @@
 #include "ontology/ModInterpro.h"
 #include "version.h"
 #include "database/EntapDatabase.h"
+#include "database/EggnogDatabase.h"
 #include "ontology/ModEggnogDMND.h"
 #include "config.h"
 #include "similarity_search/ModDiamond.h"
@@ -185,6 +186,19 @@
                             "    2. CSV Format\n"                                       \
                             "    3. FASTA Amino Acid (default)\n"                       \
                             "    4. FASTA Nucleotide (default)"
+#define DESC_SORT_OUTPUT    "Sort rows of the processed alignment and final annotation files by "  \
+                            "query ID. By default rows follow EnTAP's internal order."
+#define DESC_FRAME_SOFTWARE "Specify the frame selection software you would like to use\n"   \
+                            "    0. GeneMarkS-T (default)\n"                             \
+                            "    1. EnTAP ORF Finder (built in, multi-threaded)"
+#define DESC_EXP_SOFTWARE   "Specify the expression analysis software you would like to use\n" \
+                            "    0. RSEM (default)\n"                                    \
+                            "    1. EnTAP EM (built in, multi-threaded, no RSEM reference,\n" \
+                            "       requires building with -DENTAP_EM_QUANT=ON)"
+#define DESC_SEARCH_JOBS    "Number of DIAMOND database searches to run at the same time.\n"  \
+                            "Threads (-t) are split evenly between the searches, no more "    \
+                            "searches than threads run at once. Default of 1 runs the "        \
+                            "searches one after another with all threads."
 //**************************************************************
 // Externs
 std::string RSEM_EXE_DIR;
@@ -248,6 +262,12 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
                 (UserInput::INPUT_FLAG_SINGLE_END.c_str(), DESC_SINGLE_END)
                 ((INPUT_FLAG_THREADS + ",t").c_str(),
                  boostPO::value<int>()->default_value(1),DESC_THREADS)
+                (INPUT_FLAG_FRAME_SOFTWARE.c_str(),
+                 boostPO::value<uint16>()->default_value(FRAME_GENEMARK_ST),DESC_FRAME_SOFTWARE)
+                (INPUT_FLAG_EXP_SOFTWARE.c_str(),
+                 boostPO::value<uint16>()->default_value(EXP_RSEM),DESC_EXP_SOFTWARE)
+                (INPUT_FLAG_SEARCH_JOBS.c_str(),
+                 boostPO::value<int>()->default_value(DEFAULT_SEARCH_JOBS),DESC_SEARCH_JOBS)
                 ((INPUT_FLAG_ALIGN + ",a").c_str(), boostPO::value<std::string>(),DESC_ALIGN_FILE)
                 ((INPUT_FLAG_CONTAM + ",c").c_str(),
                  boostPO::value<std::vector<std::string>>()->multitoken(),DESC_CONTAMINANT)
@@ -270,6 +290,7 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
                 (INPUT_FLAG_OUTPUT_FORMAT.c_str(),
                  boostPO::value<std::vector<uint16>>()->multitoken()
                         ->default_value(std::vector<uint16>{FileSystem::ENT_FILE_DELIM_TSV, FileSystem::ENT_FILE_FASTA_FAA, FileSystem::ENT_FILE_FASTA_FNN},""),DESC_OUTPUT_FORMAT)
+                (INPUT_FLAG_SORT_OUTPUT.c_str(), DESC_SORT_OUTPUT)
                 (INPUT_FLAG_OVERWRITE.c_str(), DESC_OVERWRITE);
         boostPO::variables_map vm;
         try {
@@ -327,6 +348,7 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
         TCLAP::SwitchArg argNoCheck("", INPUT_FLAG_NOCHECK, DESC_NOCHECK, cmd, false);
         TCLAP::SwitchArg argOverwrite("", INPUT_FLAG_OVERWRITE, DESC_OVERWRITE, cmd, false);
         TCLAP::SwitchArg argSingleEnd("", INPUT_FLAG_SINGLE_END, DESC_SINGLE_END, cmd, false);
+        TCLAP::SwitchArg argSortOutput("", INPUT_FLAG_SORT_OUTPUT, DESC_SORT_OUTPUT, cmd, false);
 
         // Value Args
         TCLAP::ValueArg<std::string> argUninform("", INPUT_FLAG_UNINFORM, DESC_UNINFORMATIVE, false, "", "string", cmd);
@@ -334,6 +356,9 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
         TCLAP::ValueArg<fp32> argFPKM("", INPUT_FLAG_FPKM, DESC_FPKM, false, RSEM_FPKM_DEFAULT, "decimal", cmd);
         TCLAP::ValueArg<fp64> argEval("", INPUT_FLAG_E_VAL, DESC_EVAL, false, E_VALUE, "decimal", cmd);
         TCLAP::ValueArg<int> argThreads("t", INPUT_FLAG_THREADS, DESC_THREADS, false, DEFAULT_THREADS, "integer", cmd);
+        TCLAP::ValueArg<uint16> argFrameSoftware("", INPUT_FLAG_FRAME_SOFTWARE, DESC_FRAME_SOFTWARE, false, FRAME_GENEMARK_ST, "integer", cmd);
+        TCLAP::ValueArg<uint16> argExpSoftware("", INPUT_FLAG_EXP_SOFTWARE, DESC_EXP_SOFTWARE, false, EXP_RSEM, "integer", cmd);
+        TCLAP::ValueArg<int> argSearchJobs("", INPUT_FLAG_SEARCH_JOBS, DESC_SEARCH_JOBS, false, DEFAULT_SEARCH_JOBS, "integer", cmd);
         TCLAP::ValueArg<std::string> argAlign("a", INPUT_FLAG_ALIGN, DESC_ALIGN_FILE, false, "","string",cmd);
         TCLAP::ValueArg<fp32> argQueryCov("", INPUT_FLAG_QCOVERAGE, DESC_QCOVERAGE, false, DEFAULT_QCOVERAGE, "decimal", cmd);
         TCLAP::ValueArg<std::string> argExePath("", INPUT_FLAG_EXE_PATH, DESC_EXE_PATHS, false, "", "string", cmd);
@@ -373,6 +398,7 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
         if (argNoCheck.isSet()) _user_inputs.emplace(INPUT_FLAG_NOCHECK, true);
         if (argOverwrite.isSet()) _user_inputs.emplace(INPUT_FLAG_OVERWRITE, true);
         if (argSingleEnd.isSet()) _user_inputs.emplace(INPUT_FLAG_SINGLE_END, true);
+        if (argSortOutput.isSet()) _user_inputs.emplace(INPUT_FLAG_SORT_OUTPUT, true);
 
         // Add ValueArgs
         if (argUninform.isSet())_user_inputs.emplace(INPUT_FLAG_UNINFORM, argUninform.getValue());
@@ -380,6 +406,9 @@ void UserInput::parse_arguments_boost(int argc, const char** argv) {
         _user_inputs.emplace(INPUT_FLAG_FPKM, argFPKM.getValue());
         _user_inputs.emplace(INPUT_FLAG_E_VAL, argEval.getValue());
         _user_inputs.emplace(INPUT_FLAG_THREADS, argThreads.getValue());
+        _user_inputs.emplace(INPUT_FLAG_SEARCH_JOBS, argSearchJobs.getValue());
+        _user_inputs.emplace(INPUT_FLAG_FRAME_SOFTWARE, argFrameSoftware.getValue());
+        _user_inputs.emplace(INPUT_FLAG_EXP_SOFTWARE, argExpSoftware.getValue());
         if (argAlign.isSet()) _user_inputs.emplace(INPUT_FLAG_ALIGN, argAlign.getValue());
         _user_inputs.emplace(INPUT_FLAG_QCOVERAGE, argQueryCov.getValue());
         if (argExePath.isSet()) _user_inputs.emplace(INPUT_FLAG_EXE_PATH, argExePath.getValue());
@@ -613,6 +642,32 @@ bool UserInput::verify_user_input() {
                 }
             }
 
+            // Verify concurrent DIAMOND searches
+            if (has_input(INPUT_FLAG_SEARCH_JOBS) && get_user_input<int>(INPUT_FLAG_SEARCH_JOBS) < 1) {
+                throw ExceptionHandler("Search jobs must be at least 1", ERR_ENTAP_INPUT_PARSE);
+            }
+
+            // Verify Frame Selection software
+            if (has_input(INPUT_FLAG_FRAME_SOFTWARE) &&
+                get_user_input<uint16>(INPUT_FLAG_FRAME_SOFTWARE) >= FRAME_SOFTWARE_COUNT) {
+                throw ExceptionHandler("Invalid frame selection software flag being used",
+                                       ERR_ENTAP_INPUT_PARSE);
+            }
+
+            // Verify Expression software
+            if (has_input(INPUT_FLAG_EXP_SOFTWARE) &&
+                get_user_input<uint16>(INPUT_FLAG_EXP_SOFTWARE) >= EXP_COUNT) {
+                throw ExceptionHandler("Invalid expression software flag being used",
+                                       ERR_ENTAP_INPUT_PARSE);
+            }
+#ifndef ENTAP_EM_QUANT
+            if (has_input(INPUT_FLAG_EXP_SOFTWARE) &&
+                get_user_input<uint16>(INPUT_FLAG_EXP_SOFTWARE) == EXP_EM_QUANT) {
+                throw ExceptionHandler("EnTAP EM expression was not built, rebuild EnTAP with "
+                                       "-DENTAP_EM_QUANT=ON to use it", ERR_ENTAP_INPUT_PARSE);
+            }
+#endif
+
             // Verify Ontology Flags
             is_interpro = false;
             if (has_input(INPUT_FLAG_ONTOLOGY)) {
@@ -1170,7 +1225,8 @@ std::pair<bool,std::string> UserInput::verify_software(uint8 &states,std::vector
                     break;
 
                 case ONT_EGGNOG_DMND:
-                    if (!_pFileSystem->file_exists(EGG_SQL_DB_PATH))
+                    if (!_pFileSystem->file_exists(EGG_SQL_DB_PATH) &&
+                        !_pFileSystem->file_exists(EggnogDatabase::get_index_path(EGG_SQL_DB_PATH)))
                         return std::make_pair(false, "Could not find EggNOG SQL database at: " + EGG_SQL_DB_PATH);
                     else if (!_pFileSystem->file_exists(EGG_DMND_PATH))
                         return std::make_pair(false, "Could not find EggNOG Diamond Database at: " + EGG_DMND_PATH);
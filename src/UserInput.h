@@ -137,6 +137,10 @@ public:
     const std::string INPUT_FLAG_GENERATE      = "data-generate";
     const std::string INPUT_FLAG_DATABASE_TYPE = "data-type";
     const std::string INPUT_FLAG_OUTPUT_FORMAT = "output-format";
+    const std::string INPUT_FLAG_SORT_OUTPUT   = "sort-output";
+    const std::string INPUT_FLAG_SEARCH_JOBS   = "search-jobs";
+    const std::string INPUT_FLAG_FRAME_SOFTWARE= "frame-selection";
+    const std::string INPUT_FLAG_EXP_SOFTWARE  = "expression";
 
 private:
     enum SPECIES_FLAGS {
@@ -173,6 +177,7 @@ private:
     const fp32 COVERAGE_MAX                    = 100.0;
     const fp64 E_VALUE                         = 1e-5;
     const uint32 DEFAULT_THREADS               = 1;
+    const int    DEFAULT_SEARCH_JOBS           = 1;
     const fp32 RSEM_FPKM_DEFAULT               = 0.5;
     const fp32 FPKM_MIN                        = 0.0;
     const fp32 FPKM_MAX                        = 100.0;
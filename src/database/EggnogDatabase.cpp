@@ -25,7 +25,9 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <unordered_set>
 #include "EggnogDatabase.h"
+#include "../ExceptionHandler.h"
 
 
 const std::unordered_map<std::string,std::string> EggnogDatabase::EGGNOG_LEVELS = {
@@ -237,6 +239,7 @@ const vect_str_t EggnogDatabase::TAXONOMIC_RESOLUTION = {"apiNOG", "virNOG", "ne
 EggnogDatabase::EggnogDatabase(FileSystem* filesystem, EntapDatabase* entap_data, QueryData* queryData) {
     _pFilesystem = filesystem;
     _pSQLDatabase = nullptr;
+    _pEggnogIndex = nullptr;
     _pEntapDatabase = entap_data;
     _pQueryData = queryData;
     _err_msg = "";
@@ -250,6 +253,7 @@ EggnogDatabase::EggnogDatabase(FileSystem* filesystem, EntapDatabase* entap_data
 EggnogDatabase::~EggnogDatabase() {
     FS_dprint("Killing object - EggNOG Database");
     delete _pSQLDatabase;   // closes on SQLDatabaseHelper destructor
+    delete _pEggnogIndex;
 }
 
 EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::download(EggnogDatabase::EGGNOG_DB_TYPES type, std::string out_path) {
@@ -337,6 +341,7 @@ EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::open_sql(std::string& sql_path) {
         return ERR_EGG_OK;
     }
 
+    _sql_path = sql_path;
     _pSQLDatabase = new SQLDatabaseHelper();
     if (!_pSQLDatabase->open(sql_path)) {
         FS_dprint("Unable to open SQL database");
@@ -347,26 +352,592 @@ EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::open_sql(std::string& sql_path) {
     return ERR_EGG_OK;
 }
 
+/**
+ * ======================================================================
+ * Function EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::open_index(std::string &index_path,
+ *                                                              std::string &sql_path)
+ *
+ * Description          - Maps a precompiled EggNOG index, used in place of
+ *                        the SQL database for all lookups
+ *
+ * Notes                - Compiled during configuration (compile_index)
+ *                      - Index is not used if the SQL database has changed
+ *                        since it was compiled
+ *
+ * @param index_path    - Path to EggNOG index
+ * @param sql_path      - Path to EggNOG SQL database the index was compiled from
+ *
+ * @return              - ERR_EGG_OK if opened
+ * ======================================================================
+ */
+EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::open_index(std::string &index_path, std::string &sql_path) {
+    FS_dprint("Opening EggNOG index...");
+    if (!_pFilesystem->file_exists(index_path)) {
+        FS_dprint("File does not exist at: " + index_path);
+        return ERR_EGG_INDEX_OPEN;
+    }
+
+    if (_pEggnogIndex == nullptr) _pEggnogIndex = new EggnogIndex();
+    if (!_pEggnogIndex->open(index_path) || _pEggnogIndex->get_sql_version() >= EGGNOG_VERSION_MAX) {
+        FS_dprint("Unable to open EggNOG index at: " + index_path);
+        SAFE_DELETE(_pEggnogIndex);
+        return ERR_EGG_INDEX_OPEN;
+    }
+    if (_pFilesystem->file_exists(sql_path) && !_pEggnogIndex->is_built_from(sql_path)) {
+        FS_dprint("WARNING: EggNOG index at " + index_path + " is out of date with " + sql_path + ", ignoring it");
+        SAFE_DELETE(_pEggnogIndex);
+        return ERR_EGG_INDEX_OPEN;
+    }
+    _index_path  = index_path;
+    _sql_version = (EGGNOG_SQL_VERSION) _pEggnogIndex->get_sql_version();
+    FS_dprint("Success! EggNOG index opened at: " + index_path);
+    return ERR_EGG_OK;
+}
+
+
+// Returns path of the compiled index of an EggNOG SQL database (eggnog.db -> eggnog.eidx)
+std::string EggnogDatabase::get_index_path(const std::string &sql_path) {
+    const std::string sql_ext = ".db";
+
+    if (sql_path.length() > sql_ext.length() &&
+        sql_path.compare(sql_path.length() - sql_ext.length(), sql_ext.length(), sql_ext) == 0) {
+        return sql_path.substr(0, sql_path.length() - sql_ext.length()) + ".eidx";
+    }
+    return sql_path + ".eidx";
+}
+
+
+/**
+ * ======================================================================
+ * Function EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::compile_index(std::string &index_path)
+ *
+ * Description          - Compiles the relations used at run time from the
+ *                        open SQL database into an EggNOG index
+ *                          - member names interned to IDs
+ *                          - member groups, orthoindex, annotation rows
+ *                          - event rows with side members as IDs
+ *
+ * Notes                - Tables are streamed in key order so only member
+ *                        names are held in memory
+ *
+ * @param index_path    - Path to write index to
+ *
+ * @return              - ERR_EGG_OK if written
+ * ======================================================================
+ */
+EggnogDatabase::ERR_EGGNOG_DB EggnogDatabase::compile_index(std::string &index_path) {
+    EggnogIndexWriter               writer;
+    std::unordered_set<std::string> name_set;
+    vect_str_t                      names;
+    vect_str_t                      row;
+    vect_str_t                      group_row;
+    vect_str_t                      index_row;
+    vect_str_t                      annot_row;
+    std::vector<uint64>             member_events;
+    std::vector<vect_str_t>         annotations;
+    std::vector<vect_str_t>         event_rows;
+    std::string                     group_table;
+    std::string                     annot_sql;
+    std::string                     annot_key;
+    std::string                     groups;
+    uint64                          event_index=0;
+    bool                            has_group;
+    bool                            has_index;
+    bool                            has_annot;
+    bool                            has_event;
+    char                           *end;
+
+    if (_pSQLDatabase == nullptr) {
+        set_error("SQL database must be opened before compiling an index", ERR_EGG_INDEX_WRITE);
+        return _err_code;
+    }
+    FS_dprint("Compiling EggNOG index to: " + index_path);
+
+    group_table = _sql_version == EGGNOG_VERSION_4_5_1 ? SQL_EGGNOG_TABLE : _SQL_MEMBER_TABLE;
+    if (_sql_version == EGGNOG_VERSION_4_5_1) {
+        annot_key = SQL_EGGNOG_NAME;
+        annot_sql = "SELECT " + SQL_EGGNOG_NAME + ", " + SQL_EGGNOG_PNAME + ", " + SQL_EGGNOG_GOS + ", " +
+                    SQL_EGGNOG_KEGG + ", " + SQL_EGGNOG_BIGG + " FROM " + SQL_EGGNOG_TABLE +
+                    " LEFT JOIN seq on " + SQL_EGGNOG_SEQ_NAME + " = " + SQL_EGGNOG_NAME +
+                    " LEFT JOIN gene_ontology on " + SQL_EGGNOG_GO_NAME + " = " + SQL_EGGNOG_NAME +
+                    " LEFT JOIN kegg on " + SQL_EGGNOG_KEGG_NAME + " = " + SQL_EGGNOG_NAME +
+                    " LEFT JOIN bigg on " + SQL_EGGNOG_BIGG_NAME + " = " + SQL_EGGNOG_NAME;
+    } else {
+        annot_key = SQL_MEMBER_NAME;
+        annot_sql = "SELECT " + SQL_MEMBER_NAME + ", " + SQL_MEMBER_PNAME + ", " + SQL_MEMBER_GO + ", " +
+                    SQL_MEMBER_KEGG + ", '' FROM " + _SQL_MEMBER_TABLE;
+    }
+
+    try {
+        if (!writer.open(index_path, (uint32) _sql_version, _sql_path)) {
+            set_error("Unable to open EggNOG index for writing at: " + index_path, ERR_EGG_INDEX_WRITE);
+            return _err_code;
+        }
+
+        // Every member name, including ones only referenced by events
+        FS_dprint("Collecting EggNOG member names...");
+        {
+            SQLDatabaseHelper::Cursor members(*_pSQLDatabase, "SELECT " + SQL_MEMBER_NAME + " FROM " + group_table);
+            while (members.next(row)) name_set.insert(row[0]);
+        }
+        if (group_table != _SQL_MEMBER_TABLE) {
+            SQLDatabaseHelper::Cursor members(*_pSQLDatabase, "SELECT " + SQL_MEMBER_NAME + " FROM " + _SQL_MEMBER_TABLE);
+            while (members.next(row)) name_set.insert(row[0]);
+        }
+        {
+            SQLDatabaseHelper::Cursor sides(*_pSQLDatabase, "SELECT " + SQL_EVENT_SIDE1 + ", " + SQL_EVENT_SIDE2 +
+                                                            " FROM " + SQL_EVENT_TABLE);
+            while (sides.next(row)) {
+                for (std::string &member : split_string(row[0], ',')) name_set.insert(member);
+                for (std::string &member : split_string(row[1], ',')) name_set.insert(member);
+            }
+        }
+        names.assign(name_set.begin(), name_set.end());
+        name_set.clear();
+        if (!writer.set_names(names)) {
+            set_error("Unable to write EggNOG index names", ERR_EGG_INDEX_WRITE);
+            return _err_code;
+        }
+        FS_dprint("Success! Members indexed: " + std::to_string(names.size()));
+
+        // Members, walk each table in name order alongside the sorted names
+        FS_dprint("Writing EggNOG index members...");
+        {
+            SQLDatabaseHelper::Cursor group_rows(*_pSQLDatabase, "SELECT " + SQL_MEMBER_NAME + ", " +
+                                 SQL_MEMBER_GROUP + " FROM " + group_table + " ORDER BY " + SQL_MEMBER_NAME);
+            SQLDatabaseHelper::Cursor index_rows(*_pSQLDatabase, "SELECT " + SQL_MEMBER_NAME + ", " +
+                                 SQL_MEMBER_ORTHOINDEX + " FROM " + _SQL_MEMBER_TABLE + " ORDER BY " + SQL_MEMBER_NAME);
+            SQLDatabaseHelper::Cursor annot_rows(*_pSQLDatabase, annot_sql + " ORDER BY " + annot_key);
+
+            has_group = group_rows.next(group_row);
+            has_index = index_rows.next(index_row);
+            has_annot = annot_rows.next(annot_row);
+            for (const std::string &name : names) {
+                groups.clear();
+                member_events.clear();
+                annotations.clear();
+
+                // First row of a name is used, same as the SQL lookups
+                while (has_group && group_row[0] < name) has_group = group_rows.next(group_row);
+                if (has_group && group_row[0] == name) groups = group_row[1];
+                while (has_group && group_row[0] == name) has_group = group_rows.next(group_row);
+
+                while (has_index && index_row[0] < name) has_index = index_rows.next(index_row);
+                if (has_index && index_row[0] == name) {
+                    for (std::string &index : split_string(index_row[1], ',')) {
+                        if (index.empty()) continue;
+                        event_index = strtoull(index.c_str(), &end, 10);
+                        if (*end == '\0') member_events.push_back(event_index);
+                    }
+                    std::sort(member_events.begin(), member_events.end());
+                    member_events.erase(std::unique(member_events.begin(), member_events.end()), member_events.end());
+                }
+                while (has_index && index_row[0] == name) has_index = index_rows.next(index_row);
+
+                while (has_annot && annot_row[0] < name) has_annot = annot_rows.next(annot_row);
+                while (has_annot && annot_row[0] == name) {
+                    annotations.push_back(vect_str_t(annot_row.begin() + 1, annot_row.end()));
+                    has_annot = annot_rows.next(annot_row);
+                }
+
+                if (!writer.add_member(groups, member_events, annotations)) {
+                    set_error("Unable to write EggNOG index member: " + name, ERR_EGG_INDEX_WRITE);
+                    return _err_code;
+                }
+            }
+        }
+
+        // Events, rows of an index are grouped together
+        FS_dprint("Writing EggNOG index events...");
+        {
+            SQLDatabaseHelper::Cursor event_cursor(*_pSQLDatabase, "SELECT " + SQL_EVENT_I + ", " +
+                                 SQL_EVENT_LEVEL + ", " + SQL_EVENT_SIDE1 + ", " + SQL_EVENT_SIDE2 +
+                                 " FROM " + SQL_EVENT_TABLE + " ORDER BY " + SQL_EVENT_I);
+            while (true) {
+                has_event = event_cursor.next(row);
+                if (!event_rows.empty() && (!has_event || strtoull(row[0].c_str(), nullptr, 10) != event_index)) {
+                    if (!writer.add_event(event_index, event_rows)) {
+                        set_error("Unable to write EggNOG index event: " + std::to_string(event_index),
+                                  ERR_EGG_INDEX_WRITE);
+                        return _err_code;
+                    }
+                    event_rows.clear();
+                }
+                if (!has_event) break;
+                event_index = strtoull(row[0].c_str(), nullptr, 10);
+                event_rows.push_back(vect_str_t(row.begin() + 1, row.end()));
+            }
+        }
+
+        if (!writer.close()) {
+            set_error("Unable to finalize EggNOG index at: " + index_path, ERR_EGG_INDEX_WRITE);
+            return _err_code;
+        }
+    } catch (ExceptionHandler &e) {
+        set_error(e.what(), ERR_EGG_INDEX_WRITE);
+        return _err_code;
+    }
+    FS_dprint("Success! EggNOG index written to: " + index_path);
+    return ERR_EGG_OK;
+}
+
+
 std::string EggnogDatabase::print_err() {
     return "\nEggNOG Database Error: " + _err_msg;
 }
 
 void EggnogDatabase::get_eggnog_entry(QuerySequence::EggnogResults *eggnog_data) {
-    std::set<std::string> unique_groups;    // Unique member orthologous groups
-    std::string           temp;
-    member_orthologs_t    member_orthologs;
-    std::set<std::string> level_set;
-    set_str_t             orthologs;        // Selected from member orthologs
+    std::vector<QuerySequence::EggnogResults*> eggnog_batch {eggnog_data};
+
+    get_eggnog_entries(eggnog_batch, 1);
+}
+
+
+/**
+ * ======================================================================
+ * Function void EggnogDatabase::get_eggnog_entries(std::vector<QuerySequence::EggnogResults*> &eggnog_data,
+ *                                                  uint16 threads)
+ *
+ * Description          - Resolves member groups, orthologs, and annotations
+ *                        for many seed orthologs at once
+ *                      - Queries are split into contiguous shards, each
+ *                        resolved by a worker with its own read only
+ *                        SQLite connection
+ *
+ * Notes                - Each query is only touched by one worker so
+ *                        results do not depend on the thread count
+ *                      - GO terms are formatted afterwards on the calling
+ *                        thread in query order (EntapDatabase is shared)
+ *
+ * @param eggnog_data   - EggNOG results of each query (seed_ortholog set)
+ * @param threads       - Max worker threads
+ *
+ * @return              - None
+ * ======================================================================
+ */
+void EggnogDatabase::get_eggnog_entries(std::vector<QuerySequence::EggnogResults*> &eggnog_data, uint16 threads) {
+    uint64                                     shard_count;
+    uint64                                     shard_size;
+    uint64                                     end;
+    std::vector<std::unique_ptr<EggnogShard>>  shards;
+    std::vector<std::thread>                   workers;
+
+    if (eggnog_data.empty()) return;
+
+    // Small inputs are not worth a connection per thread
+    shard_count = std::min<uint64>((uint64) std::max<uint16>(threads, 1), eggnog_data.size() / SHARD_QUERIES_MIN);
+    if (shard_count == 0) shard_count = 1;
+    shard_size = (eggnog_data.size() + shard_count - 1) / shard_count;
+    for (uint64 start = 0; start < eggnog_data.size(); start += shard_size) {
+        end = std::min<uint64>(start + shard_size, eggnog_data.size());
+        shards.emplace_back(new EggnogShard());
+        shards.back()->entries.assign(eggnog_data.begin() + start, eggnog_data.begin() + end);
+    }
+    FS_dprint("Resolving EggNOG entries with " + std::to_string(shards.size()) + " thread(s)");
+
+    if (shards.size() == 1) {
+        resolve_shard(shards[0].get(), false);
+    } else {
+        for (std::unique_ptr<EggnogShard> &shard : shards) {
+            workers.emplace_back(&EggnogDatabase::resolve_shard, this, shard.get(), true);
+        }
+        for (std::thread &worker : workers) worker.join();
+    }
 
-    // Get member orthologous groups (0A01R@biNOG,0V8CP@meNOG) from best hit query
-    get_member_ogs(eggnog_data);
+    // Report the first error in query order, same as a serial run would
+    for (std::unique_ptr<EggnogShard> &shard : shards) {
+        if (shard->error) std::rethrow_exception(shard->error);
+    }
+
+    for (std::unique_ptr<EggnogShard> &shard : shards) {
+        for (uint64 i = 0; i < shard->entries.size(); i++) {
+            if (shard->go_lists[i].empty()) continue;
+            shard->entries[i]->parsed_go = _pEntapDatabase->format_go_delim(shard->go_lists[i], ',');
+        }
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void EggnogDatabase::resolve_shard(EggnogShard *shard, bool own_connection)
+ *
+ * Description          - Resolves every query of a shard, ENTRY_BATCH_MAX
+ *                        at a time to bound the event/annotation rows
+ *                        held in memory
+ *
+ * Notes                - Run on worker threads, errors are stored in the
+ *                        shard and rethrown by the calling thread
+ *
+ * @param shard         - Queries to resolve, raw GO terms are output here
+ * @param own_connection- Open a read only connection for this shard rather
+ *                        than using the shared one
+ *
+ * @return              - None
+ * ======================================================================
+ */
+void EggnogDatabase::resolve_shard(EggnogShard *shard, bool own_connection) {
+    SQLDatabaseHelper                          connection;
+    SQLDatabaseHelper                         *database = _pSQLDatabase;
+    std::vector<QuerySequence::EggnogResults*> eggnog_batch;
+    vect_str_t                                 go_batch;
+    uint64                                     end;
+
+    try {
+        if (_pEggnogIndex != nullptr) {
+            // Index is read only memory, shared by every worker
+            shard->go_lists.resize(shard->entries.size());
+            for (uint64 i = 0; i < shard->entries.size(); i++) {
+                get_index_entry(shard->entries[i], shard->go_lists[i]);
+            }
+            return;
+        }
+
+        if (own_connection) {
+            if (!connection.open_read_only(_sql_path)) {
+                throw ExceptionHandler("Unable to open EggNOG SQL database at: " + _sql_path,
+                                       ERR_ENTAP_PARSE_EGGNOG_DMND);
+            }
+            database = &connection;
+        }
+
+        shard->go_lists.resize(shard->entries.size());
+        for (uint64 start = 0; start < shard->entries.size(); start += ENTRY_BATCH_MAX) {
+            end = std::min<uint64>(start + ENTRY_BATCH_MAX, shard->entries.size());
+            eggnog_batch.assign(shard->entries.begin() + start, shard->entries.begin() + end);
+            go_batch.assign(eggnog_batch.size(), "");
+            get_entry_batch(database, eggnog_batch, go_batch);
+            std::move(go_batch.begin(), go_batch.end(), shard->go_lists.begin() + start);
+        }
+    } catch (...) {
+        shard->error = std::current_exception();
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void EggnogDatabase::get_entry_batch(SQLDatabaseHelper *database,
+ *                                      std::vector<QuerySequence::EggnogResults*> &eggnog_batch,
+ *                                      vect_str_t &go_lists)
+ *
+ * Description          - Set-based equivalent of the per query lookups:
+ *                        one bulk statement each for member groups,
+ *                        orthoindexes, events, and annotations
+ *
+ * Notes                - Rows are keyed by seed ortholog / event index /
+ *                        member name and fanned back out to each query
+ *
+ * @param database      - Connection to query through
+ * @param eggnog_batch  - EggNOG results to resolve
+ * @param go_lists      - Raw GO terms (',' delim) of each query, output
+ *
+ * @return              - None
+ * ======================================================================
+ */
+void EggnogDatabase::get_entry_batch(SQLDatabaseHelper *database,
+                                     std::vector<QuerySequence::EggnogResults*> &eggnog_batch,
+                                     vect_str_t &go_lists) {
+    typedef std::unordered_map<std::string, std::vector<vect_str_t>> row_map_t;
+
+    std::unordered_map<std::string, vect_str_t> orthoindex_map;     // Seed ortholog to its event indexes
+    row_map_t                       event_map;                      // Event index to (i, level, side1, side2)
+    row_map_t                       annotation_map;                 // Member name to its annotation rows
+    std::vector<set_str_t>          level_sets(eggnog_batch.size());
+    std::vector<set_str_t>          orthologs(eggnog_batch.size()); // Selected from member orthologs
+    std::vector<const vect_str_t*>  rows;
+    std::vector<OrthologEvent>      events;
+    set_str_t                       unique_seeds;
+    set_str_t                       unique_events;
+    set_str_t                       unique_orthologs;
+    std::string                     sql;
+    SQLDatabaseHelper::query_struct sql_results;
+
+    // Get member orthologous groups (0A01R@biNOG,0V8CP@meNOG) from best hit queries
+    get_member_ogs(database, eggnog_batch);
+
+    for (uint64 i = 0; i < eggnog_batch.size(); i++) {
+        if (eggnog_batch[i]->member_ogs.empty()) continue;
+        get_tax_levels(eggnog_batch[i], level_sets[i]);
+        unique_seeds.insert(eggnog_batch[i]->seed_ortholog);
+    }
+    if (unique_seeds.empty()) return;
+
+    // Event indexes of every seed ortholog
+    sql = "SELECT " + SQL_MEMBER_NAME + ", " + SQL_MEMBER_ORTHOINDEX + " FROM " + _SQL_MEMBER_TABLE;
+    sql_results = database->query_batch(sql, SQL_MEMBER_NAME,
+                                             vect_str_t(unique_seeds.begin(), unique_seeds.end()));
+    for (vect_str_t &row : sql_results) {
+        if (orthoindex_map.find(row[0]) != orthoindex_map.end()) continue;
+        vect_str_t &indexes = orthoindex_map[row[0]];
+        indexes = split_string(row[1], ',');
+        unique_events.insert(indexes.begin(), indexes.end());
+    }
+
+    // Events of every index, levels are filtered per query below
+    if (!unique_events.empty()) {
+        sql = "SELECT " + SQL_EVENT_I + ", " + SQL_EVENT_LEVEL + ", " + SQL_EVENT_SIDE1 + ", " +
+              SQL_EVENT_SIDE2 + " FROM " + SQL_EVENT_TABLE;
+        sql_results = database->query_batch(sql, SQL_EVENT_I,
+                                                 vect_str_t(unique_events.begin(), unique_events.end()));
+        for (vect_str_t &row : sql_results) {
+            event_map[row[0]].push_back(std::move(row));
+        }
+    }
+
+    // Get all member orthologs of each query
+    for (uint64 i = 0; i < eggnog_batch.size(); i++) {
+        QuerySequence::EggnogResults *eggnog_data = eggnog_batch[i];
+        std::unordered_map<std::string, vect_str_t>::iterator it_index;
+        set_str_t indexes;
+
+        if (eggnog_data->member_ogs.empty()) continue;
+        it_index = orthoindex_map.find(eggnog_data->seed_ortholog);
+        if (it_index == orthoindex_map.end()) continue;
+
+        events.clear();
+        indexes.insert(it_index->second.begin(), it_index->second.end());
+        for (const std::string &index : indexes) {
+            row_map_t::iterator it_event = event_map.find(index);
+            if (it_event == event_map.end()) continue;
+            for (const vect_str_t &event : it_event->second) {
+                if (level_sets[i].find(event[1]) == level_sets[i].end()) continue;
+                events.push_back({split_string(event[2], ','), split_string(event[3], ',')});
+            }
+        }
+        orthologs[i] = get_member_orthologs(eggnog_data->seed_ortholog, events)["all"];   // default, can change
+        unique_orthologs.insert(orthologs[i].begin(), orthologs[i].end());
+    }
+    if (unique_orthologs.empty()) return;
+
+    // Annotations of every selected ortholog
+    // This is different depending on version on eggnog using
+    if (_sql_version == EGGNOG_VERSION_4_5_1) {
+        sql = "SELECT " + SQL_EGGNOG_NAME + ", " + SQL_EGGNOG_PNAME + ", " + SQL_EGGNOG_GOS + ", " +
+              SQL_EGGNOG_KEGG + ", " + SQL_EGGNOG_BIGG + " FROM " + SQL_EGGNOG_TABLE +
+              " LEFT JOIN seq on " + SQL_EGGNOG_SEQ_NAME + " = " + SQL_EGGNOG_NAME +
+              " LEFT JOIN gene_ontology on " + SQL_EGGNOG_GO_NAME + " = " + SQL_EGGNOG_NAME +
+              " LEFT JOIN kegg on " + SQL_EGGNOG_KEGG_NAME + " = " + SQL_EGGNOG_NAME +
+              " LEFT JOIN bigg on " + SQL_EGGNOG_BIGG_NAME + " = " + SQL_EGGNOG_NAME;
+        sql_results = database->query_batch(sql, SQL_EGGNOG_NAME,
+                                                 vect_str_t(unique_orthologs.begin(), unique_orthologs.end()));
+    } else {
+        // Older versions
+        sql = "SELECT " + SQL_MEMBER_NAME + ", " + SQL_MEMBER_PNAME + ", " + SQL_MEMBER_GO + ", " +
+              SQL_MEMBER_KEGG + " FROM " + _SQL_MEMBER_TABLE;
+        sql_results = database->query_batch(sql, SQL_MEMBER_NAME,
+                                                 vect_str_t(unique_orthologs.begin(), unique_orthologs.end()));
+    }
+    for (vect_str_t &row : sql_results) {
+        annotation_map[row[0]].push_back(std::move(row));
+    }
+
+    for (uint64 i = 0; i < eggnog_batch.size(); i++) {
+        if (orthologs[i].empty()) continue;
+        rows.clear();
+        for (const std::string &ortholog : orthologs[i]) {
+            row_map_t::iterator it_annot = annotation_map.find(ortholog);
+            if (it_annot == annotation_map.end()) continue;
+            for (const vect_str_t &annotation : it_annot->second) rows.push_back(&annotation);
+        }
+        get_annotations(rows, eggnog_batch[i], go_lists[i]);
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void EggnogDatabase::get_index_entry(QuerySequence::EggnogResults *eggnog_data,
+ *                                               std::string &go_list)
+ *
+ * Description          - Resolves a query through the EggNOG index, same
+ *                        steps as get_entry_batch without any SQL
+ *
+ * Notes                - Only reads the mapping, safe across threads
+ *
+ * @param eggnog_data   - EggNOG results to resolve
+ * @param go_list       - Raw GO terms (',' delim), output
+ *
+ * @return              - None
+ * ======================================================================
+ */
+void EggnogDatabase::get_index_entry(QuerySequence::EggnogResults *eggnog_data, std::string &go_list) {
+    EggnogIndex::Member             member;
+    EggnogIndex::FieldView          name;
+    std::vector<EggnogIndex::Event> index_events;
+    std::vector<OrthologEvent>      events;
+    std::vector<vect_str_t>         annotations;
+    std::vector<const vect_str_t*>  rows;
+    set_str_t                       level_set;
+    set_str_t                       orthologs;
+    uint32                          id;
+
+    if (eggnog_data->seed_ortholog.empty()) return;
+    id = _pEggnogIndex->find_member(eggnog_data->seed_ortholog);
+    if (id == EggnogIndex::MEMBER_NOT_FOUND) return;
+
+    if (!_pEggnogIndex->get_member(id, member)) throw_index_corrupt();
+    eggnog_data->member_ogs = member.groups.str();
     if (eggnog_data->member_ogs.empty()) return;
+    get_tax_levels(eggnog_data, level_set);
 
-    // get SQL data and query info
-//    get_og_query(eggnog_data);      // populated og_key to be used as index into SQL
-//    get_sql_data(eggnog_data);
+    for (uint64 index : member.events) {
+        if (!_pEggnogIndex->get_events(index, index_events)) throw_index_corrupt();
+    }
+    for (EggnogIndex::Event &event : index_events) {
+        if (level_set.find(event.level.str()) == level_set.end()) continue;
+        events.emplace_back();
+        for (uint32 side_id : event.side1) {
+            if (!_pEggnogIndex->get_name(side_id, name)) throw_index_corrupt();
+            events.back().side1.push_back(name.str());
+        }
+        for (uint32 side_id : event.side2) {
+            if (!_pEggnogIndex->get_name(side_id, name)) throw_index_corrupt();
+            events.back().side2.push_back(name.str());
+        }
+    }
+    if (events.empty()) return;
+
+    orthologs = get_member_orthologs(eggnog_data->seed_ortholog, events)["all"];   // default, can change
+    if (orthologs.empty()) return;
+
+    for (const std::string &ortholog : orthologs) {
+        id = _pEggnogIndex->find_member(ortholog);
+        if (id == EggnogIndex::MEMBER_NOT_FOUND) continue;
+        if (!_pEggnogIndex->get_member(id, member)) throw_index_corrupt();
+        for (uint64 i = 0; i < member.annotations.size(); i += EggnogIndex::ANNOTATION_FIELDS) {
+            annotations.push_back({ortholog});
+            for (uint32 j = 0; j < EggnogIndex::ANNOTATION_FIELDS; j++) {
+                annotations.back().push_back(member.annotations[i + j].str());
+            }
+        }
+    }
+    for (const vect_str_t &annotation : annotations) rows.push_back(&annotation);
+    get_annotations(rows, eggnog_data, go_list);
+}
 
 
+/**
+ * ======================================================================
+ * Function void EggnogDatabase::get_tax_levels(QuerySequence::EggnogResults *eggnog_data,
+ *                                              set_str_t &level_set)
+ *
+ * Description          - Finds the max taxonomic level of the member groups
+ *                        and every level contained within it
+ *
+ * Notes                - Sets the tax scope of the query as well
+ *
+ * @param eggnog_data   - EggNOG results with member_ogs populated
+ * @param level_set     - Levels to select events from
+ *
+ * @return              - None
+ * ======================================================================
+ */
+void EggnogDatabase::get_tax_levels(QuerySequence::EggnogResults *eggnog_data, set_str_t &level_set) {
+    std::set<std::string> unique_groups;    // Unique member orthologous groups
+    std::string           temp;
+    std::unordered_map<std::string, vect_str_t>::const_iterator it_content;
+
     // Get unique tax groups (split "0V8CP@meNOG" to meNOG) and max level
     std::istringstream iss(eggnog_data->member_ogs);
     while(std::getline(iss, temp, ',')) {
@@ -375,10 +946,10 @@ void EggnogDatabase::get_eggnog_entry(QuerySequence::EggnogResults *eggnog_data)
     // For default taxonomic scope (may want to allow user to change later)
     for (const std::string &level : EggnogDatabase::TAXONOMIC_RESOLUTION) {
         if (unique_groups.find(level) != unique_groups.end()) {
-            _it_vect_str = LEVEL_CONTENT.find(level);
-            if (_it_vect_str != LEVEL_CONTENT.end()) {
-                std::copy(_it_vect_str->second.begin(),
-                      _it_vect_str->second.end(),
+            it_content = LEVEL_CONTENT.find(level);
+            if (it_content != LEVEL_CONTENT.end()) {
+                std::copy(it_content->second.begin(),
+                      it_content->second.end(),
                       std::inserter(level_set,level_set.end()));
             }
             level_set.insert(level);
@@ -388,14 +959,6 @@ void EggnogDatabase::get_eggnog_entry(QuerySequence::EggnogResults *eggnog_data)
             break;
         }
     }
-
-    // Get all member orthologs
-    member_orthologs = get_member_orthologs(member_orthologs, eggnog_data->seed_ortholog, level_set);
-    orthologs = member_orthologs["all"];        // default, can change
-
-    if (!orthologs.empty()) {
-        get_annotations(orthologs, eggnog_data);
-    }
 }
 
 
@@ -570,89 +1133,55 @@ std::string EggnogDatabase::format_sql_data(std::string &input) {
     return output;
 }
 
-void EggnogDatabase::get_member_ogs(QuerySequence::EggnogResults *eggnog_results) {
+void EggnogDatabase::get_member_ogs(SQLDatabaseHelper *database,
+                                    std::vector<QuerySequence::EggnogResults*> &eggnog_results) {
     std::vector<std::vector<std::string>>results;
-    char *query;
+    std::unordered_map<std::string, std::string> member_ogs;
+    set_str_t   seeds;
+    std::string sql;
 
-    if (eggnog_results->seed_ortholog.empty()) return;
+    for (QuerySequence::EggnogResults *eggnog_result : eggnog_results) {
+        if (!eggnog_result->seed_ortholog.empty()) seeds.insert(eggnog_result->seed_ortholog);
+    }
+    if (seeds.empty()) return;
 
     if (_sql_version == EGGNOG_VERSION_4_5_1) {
         // emapper.db-4.5.1
-        query = sqlite3_mprintf(
-                "SELECT %q FROM %q WHERE %q=%Q",
-                SQL_MEMBER_GROUP.c_str(),
-                SQL_EGGNOG_TABLE.c_str(),
-                SQL_MEMBER_NAME.c_str(),
-                eggnog_results->seed_ortholog.c_str()
-        );
+        sql = "SELECT " + SQL_MEMBER_NAME + ", " + SQL_MEMBER_GROUP + " FROM " + SQL_EGGNOG_TABLE;
     } else {
         // Older versions
-        query = sqlite3_mprintf(
-                "SELECT %q FROM %q WHERE %q=%Q",
-                SQL_MEMBER_GROUP.c_str(),
-                _SQL_MEMBER_TABLE.c_str(),
-                SQL_MEMBER_NAME.c_str(),
-                eggnog_results->seed_ortholog.c_str());
+        sql = "SELECT " + SQL_MEMBER_NAME + ", " + SQL_MEMBER_GROUP + " FROM " + _SQL_MEMBER_TABLE;
     }
 
-    results = _pSQLDatabase->query(query);
-    if (!results.empty()) {
-        eggnog_results->member_ogs = results[0][0];
+    results = database->query_batch(sql, SQL_MEMBER_NAME, vect_str_t(seeds.begin(), seeds.end()));
+    for (vect_str_t &row : results) {
+        member_ogs.emplace(row[0], row[1]);
+    }
+    for (QuerySequence::EggnogResults *eggnog_result : eggnog_results) {
+        std::unordered_map<std::string, std::string>::iterator it = member_ogs.find(eggnog_result->seed_ortholog);
+        if (it != member_ogs.end()) eggnog_result->member_ogs = it->second;
     }
 }
 
-EggnogDatabase::member_orthologs_t EggnogDatabase::get_member_orthologs(EggnogDatabase::member_orthologs_t &member_orthologs,
-                                          std::string &best_hit,
-                                          std::set<std::string> &target_lvls) {
+EggnogDatabase::member_orthologs_t EggnogDatabase::get_member_orthologs(const std::string &best_hit,
+                                          const std::vector<OrthologEvent> &events) {
     std::string                     query_taxon;  // Tax number from match
-    std::string                     event_indexes;
     std::set<std::string>           target_members;
-    char*                           sql_query;
-    SQLDatabaseHelper::query_struct sql_results;
 
     query_taxon = best_hit.substr(0, best_hit.find_first_of('.'));    // "34740"
     target_members.insert(best_hit);                                  // 34740.HMEL017225-PA
 
-    sql_query = sqlite3_mprintf(
-            "SELECT %q FROM %q WHERE %q=%Q",
-            SQL_MEMBER_ORTHOINDEX.c_str(),
-            _SQL_MEMBER_TABLE.c_str(),
-            SQL_MEMBER_NAME.c_str(),
-            best_hit.c_str());
-    sql_results = _pSQLDatabase->query(sql_query);
-    if (!sql_results.empty()) {
-        event_indexes = sql_results[0][0];
-    } else return member_orthologs_t();
-
-    if (event_indexes.empty()) return member_orthologs_t();
-    // Can specify levels as well here
-    sql_query = sqlite3_mprintf(
-            "SELECT %q, %q, %q FROM %q WHERE %q IN %s AND %q IN %s",
-            SQL_EVENT_LEVEL.c_str(),
-            SQL_EVENT_SIDE1.c_str(),
-            SQL_EVENT_SIDE2.c_str(),
-            SQL_EVENT_TABLE.c_str(),
-            SQL_EVENT_I.c_str(),
-            _pSQLDatabase->format_string(event_indexes,',').c_str(),
-            SQL_EVENT_LEVEL.c_str(),
-            _pSQLDatabase->format_container(target_lvls).c_str()
-    );
-    sql_results = _pSQLDatabase->query(sql_query);
-
     std::map<std::pair<std::string,set_str_t>,
             std::set<std::pair<std::string,set_str_t>>> ortholog_map;
 
-    for (std::vector<std::string> &hit : sql_results) {
-//        std::string* level = &hit[0];
-        std::string* side1 = &hit[1];
-        std::string* side2 = &hit[2];
+    for (const OrthologEvent &hit : events) {
 
         // Vector of tax, id pairs
         std::vector<pair_str_t> side1_pairs;     // '6238' , 'CBG18195']
         std::vector<pair_str_t> side2_pairs;
 
         // Convert string of hits to tax, id pair for side1
-        for (std::string &temp : split_string(*side1, ',')) {
+        for (const std::string &temp : hit.side1) {
             uint16 index = (uint16)temp.find_first_of('.');
             side1_pairs.push_back(std::make_pair(
                     temp.substr(0, index),
@@ -660,7 +1189,7 @@ EggnogDatabase::member_orthologs_t EggnogDatabase::get_member_orthologs(EggnogDa
             ));
         }
         // Convert string of hits to tax, id pair for side2
-        for (std::string &temp : split_string(*side2, ',')) {
+        for (const std::string &temp : hit.side2) {
             uint16 index = (uint16)temp.find_first_of('.');
             side1_pairs.push_back(std::make_pair(
                     temp.substr(0, index),
@@ -788,60 +1317,24 @@ EggnogDatabase::member_orthologs_t EggnogDatabase::get_member_orthologs(EggnogDa
     return all_orthologs;
 }
 
-void EggnogDatabase::get_annotations(set_str_t& orthologs, QuerySequence::EggnogResults* eggnog_results) {
+void EggnogDatabase::get_annotations(const std::vector<const vect_str_t*> &annotations,
+                                     QuerySequence::EggnogResults* eggnog_results,
+                                     std::string &go_list) {
 
-    char*               sql_query;
     set_str_t           all_gos;
     set_str_t           all_kegg;
     set_str_t           all_pnames;
     Compair<std::string>             pname_counter;
     set_str_t           all_bigg;
-    std::string         delim_list;
-    SQLDatabaseHelper::query_struct sql_results;
 
-    // This is different depending on version on eggnog using
-    if (_sql_version == EGGNOG_VERSION_4_5_1) {
-        sql_query = sqlite3_mprintf(
-                "SELECT %q, %q, %q, %q, %q FROM %q "\
-                "LEFT JOIN seq on %q = %q "\
-                "LEFT JOIN gene_ontology on %q = %q "\
-                "LEFT JOIN kegg on %q = %q "\
-                "LEFT JOIN bigg on %q = %q "\
-                "WHERE %q in %s",
-                SQL_EGGNOG_NAME.c_str(),
-                SQL_EGGNOG_PNAME.c_str(),
-                SQL_EGGNOG_GOS.c_str(),
-                SQL_EGGNOG_KEGG.c_str(),
-                SQL_EGGNOG_BIGG.c_str(),
-                SQL_EGGNOG_TABLE.c_str(),
-                SQL_EGGNOG_SEQ_NAME.c_str(), SQL_EGGNOG_NAME.c_str(),
-                SQL_EGGNOG_GO_NAME.c_str(), SQL_EGGNOG_NAME.c_str(),
-                SQL_EGGNOG_KEGG_NAME.c_str(), SQL_EGGNOG_NAME.c_str(),
-                SQL_EGGNOG_BIGG_NAME.c_str(), SQL_EGGNOG_NAME.c_str(),
-                SQL_EGGNOG_NAME.c_str(), _pSQLDatabase->format_container(orthologs).c_str()
-        );
-    } else {
-        // Older versions
-        sql_query = sqlite3_mprintf(
-                "SELECT %q, %q, %q, %q FROM %q WHERE %q IN %s",
-                SQL_MEMBER_NAME.c_str(),
-                SQL_MEMBER_PNAME.c_str(),
-                SQL_MEMBER_GO.c_str(),
-                SQL_MEMBER_KEGG.c_str(),
-                _SQL_MEMBER_TABLE.c_str(),
-                SQL_MEMBER_NAME.c_str(), _pSQLDatabase->format_container(orthologs).c_str()
-        );
-    }
-
-    sql_results = _pSQLDatabase->query(sql_query);
-    if (!sql_results.empty()) {
-        for (vect_str_t &data : sql_results) {
-            update_dataset(all_pnames, EGGNOG_DATA_PNAME, data[1]);
-            pname_counter.add_value(data[1]);
-            update_dataset(all_gos, EGGNOG_DATA_GO, data[2]);
-            update_dataset(all_kegg, EGGNOG_DATA_KEGG, data[3]);
+    if (!annotations.empty()) {
+        for (const vect_str_t *data : annotations) {
+            update_dataset(all_pnames, EGGNOG_DATA_PNAME, (*data)[1]);
+            pname_counter.add_value((*data)[1]);
+            update_dataset(all_gos, EGGNOG_DATA_GO, (*data)[2]);
+            update_dataset(all_kegg, EGGNOG_DATA_KEGG, (*data)[3]);
             if (_sql_version == EGGNOG_VERSION_4_5_1)
-                update_dataset(all_bigg, EGGNOG_DATA_BIGG, data[4]);
+                update_dataset(all_bigg, EGGNOG_DATA_BIGG, (*data)[4]);
         }
         eggnog_results->pname  = container_to_string<std::string>(all_pnames,",");
         if (!pname_counter.empty()) {
@@ -851,8 +1344,9 @@ void EggnogDatabase::get_annotations(set_str_t& orthologs, QuerySequence::Eggnog
             }
         }
 
-        delim_list = container_to_string<std::string>(all_gos, ",");
-        eggnog_results->parsed_go = _pEntapDatabase->format_go_delim(delim_list,',');
+        // Formatted by the calling thread, see get_eggnog_entries
+        go_list = container_to_string<std::string>(all_gos, ",");
+        eggnog_results->parsed_go = go_format_t();
         eggnog_results->kegg = container_to_string<std::string>(all_kegg, ",");
         if (_sql_version == EGGNOG_VERSION_4_5_1)
             eggnog_results->bigg = container_to_string<std::string>(all_bigg, ",");
@@ -864,6 +1358,12 @@ void EggnogDatabase::get_annotations(set_str_t& orthologs, QuerySequence::Eggnog
     }
 }
 
+// Index records are only checked when read, a bad one fails the run rather than giving partial results
+void EggnogDatabase::throw_index_corrupt() {
+    throw ExceptionHandler("EggNOG index is corrupt, remove it to use the SQL database instead: " + _index_path,
+                           ERR_ENTAP_PARSE_EGGNOG_DMND);
+}
+
 void EggnogDatabase::set_error(std::string msg, ERR_EGGNOG_DB code) {
     FS_dprint(msg);
     _err_msg = msg;
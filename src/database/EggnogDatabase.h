@@ -28,8 +28,12 @@
 #ifndef ENTAP_EGGNOGDATABASE_H
 #define ENTAP_EGGNOGDATABASE_H
 
+#include <exception>
+#include <memory>
+#include <thread>
 #include "../common.h"
 #include "SQLDatabaseHelper.h"
+#include "EggnogIndex.h"
 #include "../FileSystem.h"
 #include "../EntapGlobals.h"
 #include "../QuerySequence.h"
@@ -58,6 +62,8 @@ public:
         ERR_EGG_DMND_DECOMP,
         ERR_EGG_FASTA_FTP,
         ERR_EGG_FASTA_DECOMP,
+        ERR_EGG_INDEX_OPEN,
+        ERR_EGG_INDEX_WRITE,
 
     } ERR_EGGNOG_DB;
 
@@ -80,8 +86,12 @@ public:
 
     ERR_EGGNOG_DB download(EGGNOG_DB_TYPES type, std::string out_path);
     ERR_EGGNOG_DB open_sql(std::string& sql_path);
+    ERR_EGGNOG_DB open_index(std::string& index_path, std::string& sql_path);
+    ERR_EGGNOG_DB compile_index(std::string& index_path);
+    static std::string get_index_path(const std::string &sql_path);
     std::string print_err();
     void get_eggnog_entry(QuerySequence::EggnogResults *eg);
+    void get_eggnog_entries(std::vector<QuerySequence::EggnogResults*> &eggnog_data, uint16 threads);
 
 
 private:
@@ -97,6 +107,21 @@ private:
     const std::string FTP_EGGNOG_DMND = "http://eggnog5.embl.de/download/eggnog_4.1/eggnog-mapper-data/eggnog_proteins.dmnd.gz";
     const std::string FTP_EGGNOG_FASTA= "http://eggnog5.embl.de/download/eggnog_4.1/eggnog-mapper-data/eggnog4.clustered_proteins.fa.gz";
 
+    static constexpr uint32 ENTRY_BATCH_MAX = 2000;     // Queries resolved per set of bulk statements
+    static constexpr uint32 SHARD_QUERIES_MIN = 500;    // Fewest queries worth a worker thread
+
+    // Members on each side of an orthology event
+    struct OrthologEvent {
+        vect_str_t side1;
+        vect_str_t side2;
+    };
+
+    struct EggnogShard {
+        std::vector<QuerySequence::EggnogResults*> entries;
+        vect_str_t          go_lists;   // Raw GO terms of each entry, formatted on the calling thread
+        std::exception_ptr  error;      // First error hit by the worker
+    };
+
     const std::string TEMP_SQL_GZ = "temp_egg_sql.gz";
     const std::string TEMP_DMND_GZ = "temp_egg_dmnd.gz";
     const std::string TEMP_FAST_GZ = "temp_egg_fasta.gz";
@@ -172,11 +197,13 @@ private:
     const std::string SQL_EVENT_SIDE2       = "side2";
     const std::string SQL_EVENT_I           = "i";
 
-    typename std::unordered_map<std::string, vect_str_t>::const_iterator _it_vect_str;
     SQLDatabaseHelper *_pSQLDatabase;
+    EggnogIndex       *_pEggnogIndex;       // Used in place of SQL when opened
     FileSystem        *_pFilesystem;
     EntapDatabase     *_pEntapDatabase;
     QueryData         *_pQueryData;         // Used to control header information
+    std::string        _sql_path;
+    std::string        _index_path;
     std::string        _err_msg;
     ERR_EGGNOG_DB      _err_code;
     std::string        _SQL_MEMBER_TABLE;
@@ -193,11 +220,20 @@ private:
     void get_sql_data(QuerySequence::EggnogResults* eggnogResults);
     std::string format_sql_data(std::string&);
     void get_og_query(QuerySequence::EggnogResults* eggnogResults);
-    void get_member_ogs(QuerySequence::EggnogResults* eggnog_results);
-    member_orthologs_t get_member_orthologs(member_orthologs_t &member_orthologs,
-                              std::string &best_hit,
-                              std::set<std::string> &target_lvls);
-    void get_annotations(set_str_t& orthologs, QuerySequence::EggnogResults* eggnog_results);
+    void resolve_shard(EggnogShard *shard, bool own_connection);
+    void get_entry_batch(SQLDatabaseHelper *database,
+                         std::vector<QuerySequence::EggnogResults*> &eggnog_batch,
+                         vect_str_t &go_lists);
+    void get_index_entry(QuerySequence::EggnogResults* eggnog_data, std::string &go_list);
+    void get_tax_levels(QuerySequence::EggnogResults* eggnog_data, set_str_t &level_set);
+    void get_member_ogs(SQLDatabaseHelper *database,
+                        std::vector<QuerySequence::EggnogResults*> &eggnog_results);
+    member_orthologs_t get_member_orthologs(const std::string &best_hit,
+                              const std::vector<OrthologEvent> &events);
+    void get_annotations(const std::vector<const vect_str_t*> &annotations,
+                         QuerySequence::EggnogResults* eggnog_results,
+                         std::string &go_list);
+    void throw_index_corrupt();
     void set_error(std::string msg, ERR_EGGNOG_DB code);
     void set_database_version();
     void update_dataset(set_str_t &set, EGGNOG_DATA_TYPES datatype, std::string data);
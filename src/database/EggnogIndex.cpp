@@ -0,0 +1,495 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "EggnogIndex.h"
+#include "../EntapGlobals.h"
+//**************************************************************
+
+constexpr char EggnogIndex::MAGIC[9];
+
+namespace {
+    const uint64 HEADER_SIZE                = 80;
+    const uint64 HEADER_VERSION_POS         = 8;
+    const uint64 HEADER_SQL_VERSION_POS     = 12;
+    const uint64 HEADER_MEMBER_COUNT_POS    = 16;
+    const uint64 HEADER_EVENT_COUNT_POS     = 24;
+    const uint64 HEADER_NAME_OFFSETS_POS    = 32;
+    const uint64 HEADER_MEMBER_OFFSETS_POS  = 40;
+    const uint64 HEADER_EVENT_KEYS_POS      = 48;
+    const uint64 HEADER_EVENT_OFFSETS_POS   = 56;
+    const uint64 HEADER_SOURCE_POS          = 64;   // source size, source mtime
+
+    template<typename T>
+    T read_value(const char *pos) {
+        T val;
+        memcpy(&val, pos, sizeof(T));
+        return val;
+    }
+
+    template<typename T>
+    void write_value(std::ofstream &file, T val) {
+        file.write(reinterpret_cast<const char*>(&val), sizeof(T));
+    }
+
+    // Reads a count/length prefix and moves pos past it, false if it would pass end
+    bool read_count(const char *&pos, const char *end, uint32 &count) {
+        if ((uint64) (end - pos) < sizeof(uint32)) return false;
+        count = read_value<uint32>(pos);
+        pos += sizeof(uint32);
+        return true;
+    }
+
+    // Reads a length prefixed string and moves pos past it, false if it would pass end
+    bool read_string(const char *&pos, const char *end, MappedDatabase::FieldView &view) {
+        if (!read_count(pos, end, view.length) || view.length > (uint64) (end - pos)) return false;
+        view.data = pos;
+        pos += view.length;
+        return true;
+    }
+
+    // Reads a count prefixed list and moves pos past it, false if it would pass end
+    template<typename T>
+    bool read_list(const char *&pos, const char *end, std::vector<T> &values) {
+        uint32 count;
+
+        if (!read_count(pos, end, count) || count > (uint64) (end - pos) / sizeof(T)) return false;
+        values.resize(count);
+        if (count > 0) memcpy(&values[0], pos, count * sizeof(T));
+        pos += count * sizeof(T);
+        return true;
+    }
+
+    int compare_key(const MappedDatabase::FieldView &view, const std::string &key) {
+        int cmp = memcmp(view.data, key.data(), std::min<uint64>(view.length, key.length()));
+        if (cmp == 0) cmp = view.length < key.length() ? -1 : (view.length > key.length() ? 1 : 0);
+        return cmp;
+    }
+}
+
+
+EggnogIndex::EggnogIndex() {
+    close();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool EggnogIndex::open(const std::string &path)
+ *
+ * Description          - Maps an index file and validates its header and
+ *                        section bounds
+ *
+ * Notes                - No records are read, cost is independent of
+ *                        index size
+ *
+ * @param path          - Path to EggNOG index
+ *
+ * @return              - True if file is a valid EggNOG index
+ *
+ * =====================================================================
+ */
+bool EggnogIndex::open(const std::string &path) {
+    const char *data;
+    uint64      size;
+    uint64      name_offsets_pos;
+    uint64      member_offsets_pos;
+    uint64      event_keys_pos;
+    uint64      event_offsets_pos;
+
+    close();
+    if (!_file.open(path)) return false;
+    data = _file.data();
+    size = _file.size();
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC) - 1) != 0 ||
+        read_value<uint32>(data + HEADER_VERSION_POS) != FORMAT_VERSION) {
+        close();
+        return false;
+    }
+    _sql_version        = read_value<uint32>(data + HEADER_SQL_VERSION_POS);
+    _source_size        = read_value<uint64>(data + HEADER_SOURCE_POS);
+    _source_mtime       = read_value<int64>(data + HEADER_SOURCE_POS + sizeof(uint64));
+    _member_count       = read_value<uint64>(data + HEADER_MEMBER_COUNT_POS);
+    _event_count        = read_value<uint64>(data + HEADER_EVENT_COUNT_POS);
+    name_offsets_pos    = read_value<uint64>(data + HEADER_NAME_OFFSETS_POS);
+    member_offsets_pos  = read_value<uint64>(data + HEADER_MEMBER_OFFSETS_POS);
+    event_keys_pos      = read_value<uint64>(data + HEADER_EVENT_KEYS_POS);
+    event_offsets_pos   = read_value<uint64>(data + HEADER_EVENT_OFFSETS_POS);
+
+    // Offset arrays hold count+1 entries so record ends are known
+    if (_member_count >= size || _event_count >= size ||
+        name_offsets_pos > size || (_member_count + 1) > (size - name_offsets_pos) / sizeof(uint64) ||
+        member_offsets_pos > size || (_member_count + 1) > (size - member_offsets_pos) / sizeof(uint64) ||
+        event_keys_pos > size || _event_count > (size - event_keys_pos) / sizeof(uint64) ||
+        event_offsets_pos > size || (_event_count + 1) > (size - event_offsets_pos) / sizeof(uint64)) {
+        close();
+        return false;
+    }
+    _name_offsets   = data + name_offsets_pos;
+    _member_offsets = data + member_offsets_pos;
+    _event_keys     = data + event_keys_pos;
+    _event_offsets  = data + event_offsets_pos;
+    return true;
+}
+
+void EggnogIndex::close() {
+    _file.close();
+    _sql_version    = 0;
+    _source_size    = 0;
+    _source_mtime   = 0;
+    _member_count   = 0;
+    _event_count    = 0;
+    _name_offsets   = nullptr;
+    _member_offsets = nullptr;
+    _event_keys     = nullptr;
+    _event_offsets  = nullptr;
+}
+
+bool EggnogIndex::is_open() const {
+    return _file.is_open();
+}
+
+uint32 EggnogIndex::get_sql_version() const {
+    return _sql_version;
+}
+
+// True if source file still has the size and modification time recorded when this index was compiled
+bool EggnogIndex::is_built_from(const std::string &source_path) const {
+    uint64 size;
+    int64  mtime;
+
+    if (!MappedFile::get_file_stamp(source_path, size, mtime)) return false;
+    return size == _source_size && mtime == _source_mtime;
+}
+
+
+/**
+ * ======================================================================
+ * Function uint32 EggnogIndex::find_member(const std::string &name)
+ *
+ * Description          - Binary searches member names for a name
+ *
+ * Notes                - Names compare bytewise, same as std::string
+ *                      - A corrupt name ends the search as not found
+ *
+ * @param name          - Member name (ie. 34740.HMEL017225-PA)
+ *
+ * @return              - Member ID, MEMBER_NOT_FOUND if not indexed
+ *
+ * =====================================================================
+ */
+uint32 EggnogIndex::find_member(const std::string &name) const {
+    FieldView member_name;
+    uint64    low  = 0;
+    uint64    high = _member_count;
+    uint64    mid;
+    int       cmp;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (!get_name((uint32) mid, member_name)) return MEMBER_NOT_FOUND;
+        cmp = compare_key(member_name, name);
+        if (cmp == 0) return (uint32) mid;
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return MEMBER_NOT_FOUND;
+}
+
+// Bounds of record index within an offset array of (count+1) entries, false if outside the file
+bool EggnogIndex::get_record(const char *offsets, uint64 index, const char *&begin, const char *&end) const {
+    uint64 start = read_value<uint64>(offsets + index * sizeof(uint64));
+    uint64 stop  = read_value<uint64>(offsets + (index + 1) * sizeof(uint64));
+
+    if (start > stop || stop > _file.size()) return false;
+    begin = _file.data() + start;
+    end   = _file.data() + stop;
+    return true;
+}
+
+bool EggnogIndex::get_name(uint32 id, EggnogIndex::FieldView &name) const {
+    const char *begin;
+    const char *end;
+
+    if (id >= _member_count || !get_record(_name_offsets, id, begin, end)) return false;
+    name.data   = begin;
+    name.length = (uint32) (end - begin);
+    return true;
+}
+
+// Decodes the record of a member, fields are empty if the member only appears within events
+bool EggnogIndex::get_member(uint32 id, EggnogIndex::Member &member) const {
+    const char *pos;
+    const char *end;
+    uint32      rows;
+
+    member.annotations.clear();
+    if (id >= _member_count || !get_record(_member_offsets, id, pos, end)) return false;
+    if (!read_string(pos, end, member.groups) || !read_list<uint64>(pos, end, member.events) ||
+        !read_count(pos, end, rows)) {
+        return false;
+    }
+    // Each field holds at least its length
+    if (rows > (uint64) (end - pos) / (ANNOTATION_FIELDS * sizeof(uint32))) return false;
+    member.annotations.resize(rows * ANNOTATION_FIELDS);
+    for (FieldView &field : member.annotations) {
+        if (!read_string(pos, end, field)) return false;
+    }
+    return true;
+}
+
+
+/**
+ * ======================================================================
+ * Function void EggnogIndex::get_events(uint64 index, std::vector<Event> &events)
+ *
+ * Description          - Binary searches event indexes and decodes the
+ *                        rows of a match
+ *
+ * Notes                - Rows are appended, nothing added if not found
+ *
+ * @param index         - Event index (from orthoindex)
+ * @param events        - Output rows
+ *
+ * @return              - False if the event record is corrupt
+ *
+ * =====================================================================
+ */
+bool EggnogIndex::get_events(uint64 index, std::vector<EggnogIndex::Event> &events) const {
+    uint64      low  = 0;
+    uint64      high = _event_count;
+    uint64      mid;
+    uint64      key;
+    uint32      rows;
+    const char *pos;
+    const char *end;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        key = read_value<uint64>(_event_keys + mid * sizeof(uint64));
+        if (key == index) {
+            if (!get_record(_event_offsets, mid, pos, end) || !read_count(pos, end, rows)) return false;
+            for (uint32 i = 0; i < rows; i++) {
+                events.emplace_back();
+                if (!read_string(pos, end, events.back().level) ||
+                    !read_list<uint32>(pos, end, events.back().side1) ||
+                    !read_list<uint32>(pos, end, events.back().side2)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (key < index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return true;
+}
+
+
+EggnogIndexWriter::EggnogIndexWriter() {
+    _sql_version      = 0;
+    _source_size      = 0;
+    _source_mtime     = 0;
+    _name_offsets_pos = 0;
+}
+
+bool EggnogIndexWriter::open(const std::string &path, uint32 sql_version, const std::string &source_path) {
+    _file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_file.is_open()) return false;
+    _sql_version = sql_version;
+    if (!MappedFile::get_file_stamp(source_path, _source_size, _source_mtime)) {
+        _source_size  = 0;
+        _source_mtime = 0;
+    }
+    // Reserve header, written on close once section offsets are known
+    std::string header(HEADER_SIZE, '\0');
+    _file.write(header.data(), header.size());
+    return _file.good();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool EggnogIndexWriter::set_names(vect_str_t &names)
+ *
+ * Description          - Sorts member names, assigns IDs, and writes the
+ *                        name section
+ *
+ * Notes                - Names are sorted and made unique in place. Every
+ *                        name referenced by members or events must be here
+ *
+ * @param names         - All member names
+ *
+ * @return              - True if written successfully
+ *
+ * =====================================================================
+ */
+bool EggnogIndexWriter::set_names(vect_str_t &names) {
+    std::vector<uint64> offsets;
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    _names.swap(names);
+
+    offsets.reserve(_names.size() + 1);
+    for (std::string &name : _names) {
+        offsets.push_back((uint64) _file.tellp());
+        _file.write(name.data(), name.length());
+    }
+    offsets.push_back((uint64) _file.tellp());
+    _name_offsets_pos = (uint64) _file.tellp();
+    write_offsets(offsets);
+    _member_offsets.reserve(_names.size() + 1);
+    return _file.good();
+}
+
+uint32 EggnogIndexWriter::find_member(const std::string &name) const {
+    vect_str_t::const_iterator it = std::lower_bound(_names.begin(), _names.end(), name);
+
+    if (it == _names.end() || *it != name) return EggnogIndex::MEMBER_NOT_FOUND;
+    return (uint32) (it - _names.begin());
+}
+
+// Writes the record of the next member (in name order)
+bool EggnogIndexWriter::add_member(const std::string &groups, const std::vector<uint64> &events,
+                                   const std::vector<vect_str_t> &annotations) {
+    if (_member_offsets.size() >= _names.size()) return false;
+
+    _member_offsets.push_back((uint64) _file.tellp());
+    write_string(groups);
+    write_value<uint32>(_file, (uint32) events.size());
+    for (uint64 event : events) write_value<uint64>(_file, event);
+    write_value<uint32>(_file, (uint32) annotations.size());
+    for (const vect_str_t &row : annotations) {
+        if (row.size() != EggnogIndex::ANNOTATION_FIELDS) return false;
+        for (const std::string &field : row) write_string(field);
+    }
+    return _file.good();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool EggnogIndexWriter::add_event(uint64 index, const std::vector<vect_str_t> &rows)
+ *
+ * Description          - Writes every row of an event index, member names
+ *                        of each side are replaced by their IDs
+ *
+ * Notes                - Called in increasing index order, after all
+ *                        members have been added
+ *
+ * @param index         - Event index
+ * @param rows          - Rows of level, side1, side2 (',' delim members)
+ *
+ * @return              - True if written successfully
+ *
+ * =====================================================================
+ */
+bool EggnogIndexWriter::add_event(uint64 index, const std::vector<vect_str_t> &rows) {
+    std::vector<uint32> ids;
+    uint32              id;
+
+    if (_member_offsets.size() != _names.size()) return false;
+    if (!_event_keys.empty() && index <= _event_keys.back()) return false;
+
+    _event_keys.push_back(index);
+    _event_offsets.push_back((uint64) _file.tellp());
+    write_value<uint32>(_file, (uint32) rows.size());
+    for (const vect_str_t &row : rows) {
+        write_string(row[0]);
+        for (uint32 side = 1; side <= 2; side++) {
+            ids.clear();
+            for (std::string &member : split_string(row[side], ',')) {
+                id = find_member(member);
+                if (id != EggnogIndex::MEMBER_NOT_FOUND) ids.push_back(id);
+            }
+            write_value<uint32>(_file, (uint32) ids.size());
+            for (uint32 val : ids) write_value<uint32>(_file, val);
+        }
+    }
+    return _file.good();
+}
+
+bool EggnogIndexWriter::close() {
+    std::string         header(HEADER_SIZE, '\0');
+    std::vector<uint64> member_offsets;
+    uint64              member_offsets_pos;
+    uint64              event_keys_pos;
+    uint64              event_offsets_pos;
+    uint64              member_count = _names.size();
+    uint64              event_count  = _event_keys.size();
+    uint32              version      = EggnogIndex::FORMAT_VERSION;
+
+    if (_member_offsets.size() != _names.size()) {
+        _file.close();
+        return false;
+    }
+
+    // Member records end where event records begin
+    _event_offsets.push_back((uint64) _file.tellp());
+    _member_offsets.push_back(_event_offsets.front());
+    member_offsets_pos = (uint64) _file.tellp();
+    write_offsets(_member_offsets);
+    event_keys_pos = (uint64) _file.tellp();
+    write_offsets(_event_keys);
+    event_offsets_pos = (uint64) _file.tellp();
+    write_offsets(_event_offsets);
+
+    memcpy(&header[0], EggnogIndex::MAGIC, sizeof(EggnogIndex::MAGIC) - 1);
+    memcpy(&header[HEADER_VERSION_POS], &version, sizeof(version));
+    memcpy(&header[HEADER_SQL_VERSION_POS], &_sql_version, sizeof(_sql_version));
+    memcpy(&header[HEADER_MEMBER_COUNT_POS], &member_count, sizeof(member_count));
+    memcpy(&header[HEADER_EVENT_COUNT_POS], &event_count, sizeof(event_count));
+    memcpy(&header[HEADER_NAME_OFFSETS_POS], &_name_offsets_pos, sizeof(_name_offsets_pos));
+    memcpy(&header[HEADER_MEMBER_OFFSETS_POS], &member_offsets_pos, sizeof(member_offsets_pos));
+    memcpy(&header[HEADER_EVENT_KEYS_POS], &event_keys_pos, sizeof(event_keys_pos));
+    memcpy(&header[HEADER_EVENT_OFFSETS_POS], &event_offsets_pos, sizeof(event_offsets_pos));
+    memcpy(&header[HEADER_SOURCE_POS], &_source_size, sizeof(_source_size));
+    memcpy(&header[HEADER_SOURCE_POS + sizeof(uint64)], &_source_mtime, sizeof(_source_mtime));
+
+    _file.seekp(0);
+    _file.write(header.data(), header.size());
+    _file.close();
+    return !_file.fail();
+}
+
+void EggnogIndexWriter::write_offsets(std::vector<uint64> &offsets) {
+    if (!offsets.empty()) {
+        _file.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(uint64));
+    }
+}
+
+void EggnogIndexWriter::write_string(const std::string &str) {
+    write_value<uint32>(_file, (uint32) str.length());
+    _file.write(str.data(), str.length());
+}
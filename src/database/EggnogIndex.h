@@ -0,0 +1,144 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ENTAP_EGGNOGINDEX_H
+#define ENTAP_EGGNOGINDEX_H
+
+//*********************** Includes *****************************
+#include "../common.h"
+#include "../MappedFile.h"
+#include "MappedDatabase.h"
+//**************************************************************
+
+
+/**
+ * Read-only, memory mapped index of the EggNOG relations used at run time,
+ * compiled from the EggNOG SQL database during configuration.
+ *
+ * File layout (native byte order):
+ *
+ *      Header      magic "ENTAPEGG", format version, version of the SQL
+ *                  database it was compiled from, member/event counts,
+ *                  section offsets, size and modification time of the SQL
+ *                  database file
+ *      Names       member names sorted bytewise with (count+1) offsets into
+ *                  the name bytes. A member's ID is its index here
+ *      Members     (count+1) offsets into member records: groups, event
+ *                  indexes (orthoindex), annotation rows
+ *      Events      sorted event indexes with (count+1) offsets into event
+ *                  records: rows of level, side1 and side2 member IDs
+ *
+ * Strings are stored as length + bytes, lists as count + values. Lookups
+ * binary search the names/event indexes and decode records straight from
+ * the mapping. Every read is checked against the bounds of its record, a
+ * corrupt record is reported rather than read past.
+ */
+class EggnogIndex {
+
+public:
+    typedef MappedDatabase::FieldView FieldView;
+
+    // Member record, views are valid while the index is open
+    struct Member {
+        FieldView              groups;          // 0A01R@biNOG,0V8CP@meNOG
+        std::vector<uint64>    events;          // Event indexes (orthoindex)
+        std::vector<FieldView> annotations;     // ANNOTATION_FIELDS per row: pname, GO, KEGG, BiGG
+    };
+
+    // Single row of an event
+    struct Event {
+        FieldView              level;
+        std::vector<uint32>    side1;           // Member IDs
+        std::vector<uint32>    side2;
+    };
+
+    EggnogIndex();
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    uint32 get_sql_version() const;
+    bool is_built_from(const std::string &source_path) const;
+    uint32 find_member(const std::string &name) const;
+    bool get_name(uint32 id, FieldView &name) const;
+    bool get_member(uint32 id, Member &member) const;
+    bool get_events(uint64 index, std::vector<Event> &events) const;
+
+    static constexpr uint32 FORMAT_VERSION    = 2;
+    static constexpr uint32 ANNOTATION_FIELDS = 4;
+    static constexpr uint32 MEMBER_NOT_FOUND  = UINT32_MAX;
+    static constexpr char   MAGIC[9]          = "ENTAPEGG";
+
+private:
+    bool get_record(const char *offsets, uint64 index, const char *&begin, const char *&end) const;
+
+    MappedFile  _file;
+    uint32      _sql_version;
+    uint64      _source_size;
+    int64       _source_mtime;
+    uint64      _member_count;
+    uint64      _event_count;
+    const char *_name_offsets;
+    const char *_member_offsets;
+    const char *_event_keys;
+    const char *_event_offsets;
+};
+
+
+/**
+ * Writes an EggnogIndex file. Names are set first, then one member per
+ * name in name order, then events in increasing index order.
+ */
+class EggnogIndexWriter {
+
+public:
+    EggnogIndexWriter();
+    bool open(const std::string &path, uint32 sql_version, const std::string &source_path);
+    bool set_names(vect_str_t &names);
+    uint32 find_member(const std::string &name) const;
+    bool add_member(const std::string &groups, const std::vector<uint64> &events,
+                    const std::vector<vect_str_t> &annotations);
+    bool add_event(uint64 index, const std::vector<vect_str_t> &rows);
+    bool close();
+
+private:
+    void write_offsets(std::vector<uint64> &offsets);
+    void write_string(const std::string &str);
+
+    std::ofstream       _file;
+    uint32              _sql_version;
+    uint64              _source_size;
+    int64               _source_mtime;
+    vect_str_t          _names;
+    std::vector<uint64> _member_offsets;
+    std::vector<uint64> _event_keys;
+    std::vector<uint64> _event_offsets;
+    uint64              _name_offsets_pos;
+};
+
+
+#endif //ENTAP_EGGNOGINDEX_H
@@ -26,6 +26,7 @@
 
 #include <csv.h>
 #include "EntapDatabase.h"
+#include "../Instrumentation.h"
 
 /**
  * ======================================================================
@@ -49,6 +50,7 @@ EntapDatabase::EntapDatabase(FileSystem* filesystem) {
     _pFilesystem     = filesystem;
     _temp_directory  = filesystem->get_temp_outdir();    // created previously
     _pSerializedDatabase = nullptr;
+    _pMappedDatabase     = nullptr;
     _pDatabaseHelper     = nullptr;
     _use_serial          = true;                         // default
     _err_msg             = "";
@@ -72,10 +74,25 @@ EntapDatabase::EntapDatabase(FileSystem* filesystem) {
 bool EntapDatabase::set_database(DATABASE_TYPE type) {
 
     switch (type) {
-        case ENTAP_SERIALIZED:
+        case ENTAP_SERIALIZED: {
             // Filepath checked in routine
             _use_serial = true;
+            // Prefer memory mapped copy of database, no deserialization needed
+            std::string mapped_path = get_mapped_path(ENTAP_DATABASE_BIN_PATH);
+            if (MappedDatabase::is_mapped_database(ENTAP_DATABASE_BIN_PATH)) {
+                return mapped_database_read(ENTAP_DATABASE_BIN_PATH) == ERR_DATA_OK;
+            } else if (_pFilesystem->file_exists(mapped_path) && mapped_database_read(mapped_path) == ERR_DATA_OK) {
+                // Mapped copy is only used while it matches the serialized database it was built from
+                if (!_pFilesystem->file_exists(ENTAP_DATABASE_BIN_PATH) ||
+                    _pMappedDatabase->is_built_from(ENTAP_DATABASE_BIN_PATH)) {
+                    return true;
+                }
+                FS_dprint("WARNING: " + mapped_path + " is out of date with " + ENTAP_DATABASE_BIN_PATH +
+                          ", ignoring it");
+                SAFE_DELETE(_pMappedDatabase);
+            }
             return serialize_database_read(SERIALIZE_DEFAULT, ENTAP_DATABASE_BIN_PATH) == ERR_DATA_OK;
+        }
         case ENTAP_SQL:
             _use_serial = false;
             if (!_pFilesystem->file_exists(ENTAP_DATABASE_SQL_PATH)) {
@@ -243,6 +260,14 @@ EntapDatabase::DATABASE_ERR EntapDatabase::generate_entap_database(DATABASE_TYPE
                 FS_dprint("Unable to serialize database!");
                 return err_code;
             }
+            {
+                std::string mapped_path = get_mapped_path(outpath);
+                err_code = mapped_database_save(mapped_path, outpath);
+                if (err_code != ERR_DATA_OK) {
+                    FS_dprint("Unable to write memory mapped database!");
+                    return err_code;
+                }
+            }
             break;
 
         default:
@@ -259,6 +284,7 @@ EntapDatabase::~EntapDatabase() {
         delete(_pDatabaseHelper);
     }
     delete _pSerializedDatabase;
+    delete _pMappedDatabase;
 }
 
 EntapDatabase::DATABASE_ERR EntapDatabase::generate_entap_tax(EntapDatabase::DATABASE_TYPE type) {
@@ -394,7 +420,7 @@ EntapDatabase::DATABASE_ERR EntapDatabase::generate_entap_tax(EntapDatabase::DAT
             // ********************* logging **************************** //
             percent_complete = (uint16) round((fp32)current_entries / total_entries * 100);
             if (percent_complete % STATUS_UPDATES == 0 && percent_complete != percent_prev) {
-                FS_dprint("Percent complete: "+ std::to_string(percent_complete) + "%");
+                FS_DPRINT_HOT("Percent complete: "+ std::to_string(percent_complete) + "%");
                 percent_prev = percent_complete;
             }
             // ********************************************************** //
@@ -889,11 +915,23 @@ EntapDatabase::DATABASE_ERR EntapDatabase::download_entap_sql(std::string &path)
 }
 
 GoEntry EntapDatabase::get_go_entry(std::string &go_id) {
+    static Instrumentation::Counter &lookups = Instrumentation::counter("db_lookups.go");
     GoEntry goEntry;
 
     if (go_id.empty()) return GoEntry();
-
-    if (_use_serial) {
+    lookups++;
+
+    if (_use_serial && _pMappedDatabase != nullptr) {
+        // Using memory mapped database
+        MappedDatabase::Record record = _pMappedDatabase->find(MappedDatabase::TABLE_GO, go_id);
+        if (!record.is_valid()) return GoEntry();
+        goEntry.go_id    = record.field(1).str();
+        goEntry.term     = record.field(2).str();
+        goEntry.category = record.field(3).str();
+        goEntry.level    = record.field(4).str();
+        return goEntry;
+
+    } else if (_use_serial) {
         // Using serialized database
         go_serial_map_t::iterator it = _pSerializedDatabase->gene_ontology_data.find(go_id);
         if (it == _pSerializedDatabase->gene_ontology_data.end()) {
@@ -907,20 +945,12 @@ GoEntry EntapDatabase::get_go_entry(std::string &go_id) {
         // Check temp if previously found (increase speeds)
         go_serial_map_t::iterator it = _sql_go_helper.find(go_id);
         if (it != _sql_go_helper.end()) return it->second;
-        // Generate SQL query
-        char *query = sqlite3_mprintf(
-                "SELECT %q, %q, %q, %q FROM %q WHERE %q=%Q",
-                SQL_TABLE_GO_COL_ID.c_str(),
-                SQL_TABLE_GO_COL_DESC.c_str(),
-                SQL_TABLE_GO_COL_CATEGORY.c_str(),
-                SQL_TABLE_GO_COL_LEVEL.c_str(),
-                SQL_TABLE_GO_TITLE.c_str(),
-                SQL_TABLE_GO_COL_ID.c_str(),
-                go_id.c_str()
-        );
         try {
+            results = _pDatabaseHelper->query(
+                    "SELECT " + SQL_TABLE_GO_COL_ID + ", " + SQL_TABLE_GO_COL_DESC + ", " +
+                    SQL_TABLE_GO_COL_CATEGORY + ", " + SQL_TABLE_GO_COL_LEVEL + " FROM " + SQL_TABLE_GO_TITLE +
+                    " WHERE " + SQL_TABLE_GO_COL_ID + "=?", {go_id});
             if (results.empty()) return GoEntry();
-            results = _pDatabaseHelper->query(query);
             goEntry.go_id    = results[0][0];
             goEntry.term     = results[0][1];
             goEntry.category = results[0][2];
@@ -935,16 +965,75 @@ GoEntry EntapDatabase::get_go_entry(std::string &go_id) {
     }
 }
 
+
+/**
+ * ======================================================================
+ * Function std::vector<GoEntry> EntapDatabase::get_go_entries(vect_str_t &go_ids)
+ *
+ * Description          - Looks up several GO terms at once
+ *
+ * Notes                - In SQL mode terms not seen before are pulled back
+ *                        with batched queries instead of one per term
+ *
+ * @param go_ids        - GO IDs to look up (GO:0000123)
+ *
+ * @return              - Entries in same order as go_ids, empty if not found
+ *
+ * =====================================================================
+ */
+std::vector<GoEntry> EntapDatabase::get_go_entries(vect_str_t &go_ids) {
+    std::vector<GoEntry> ret;
+    vect_str_t           missing;
+
+    if (!_use_serial && _pDatabaseHelper != nullptr) {
+        for (std::string &go_id : go_ids) {
+            if (!go_id.empty() && _sql_go_helper.find(go_id) == _sql_go_helper.end()) missing.push_back(go_id);
+        }
+        if (!missing.empty()) {
+            try {
+                SQLDatabaseHelper::query_struct results = _pDatabaseHelper->query_batch(
+                        "SELECT " + SQL_TABLE_GO_COL_ID + ", " + SQL_TABLE_GO_COL_DESC + ", " +
+                        SQL_TABLE_GO_COL_CATEGORY + ", " + SQL_TABLE_GO_COL_LEVEL + " FROM " + SQL_TABLE_GO_TITLE,
+                        SQL_TABLE_GO_COL_ID, missing);
+                for (vect_str_t &row : results) {
+                    GoEntry &goEntry = _sql_go_helper[row[0]];
+                    goEntry.go_id    = row[0];
+                    goEntry.term     = row[1];
+                    goEntry.category = row[2];
+                    goEntry.level    = row[3];
+                }
+                // Remember terms that do not exist so they are not queried again
+                for (std::string &go_id : missing) _sql_go_helper.emplace(go_id, GoEntry());
+            } catch (std::exception &e) {
+                // Do not fatal error, fall back to single lookups
+                FS_dprint(e.what());
+            }
+        }
+    }
+
+    ret.reserve(go_ids.size());
+    for (std::string &go_id : go_ids) {
+        ret.push_back(get_go_entry(go_id));
+    }
+    return ret;
+}
+
 TaxEntry EntapDatabase::get_tax_entry(std::string &species) {
     TaxEntry taxEntry;
     std::string temp_species;
     uint64 index;
+    static Instrumentation::Counter &lookups = Instrumentation::counter("db_lookups.taxonomy");
 
     if (species.empty()) return TaxEntry();
+    lookups++;
 
     LOWERCASE(species); // ensure lowercase (database is based on this for direct matching)
 
-    if (_use_serial) {
+    if (_use_serial && _pMappedDatabase != nullptr) {
+        // Using memory mapped database
+        return get_mapped_tax_entry(species);
+
+    } else if (_use_serial) {
         // Using serialized database
         tax_serial_map_t::iterator it = _pSerializedDatabase->taxonomic_data.find(species);
         if (it == _pSerializedDatabase->taxonomic_data.end()) {
@@ -965,20 +1054,13 @@ TaxEntry EntapDatabase::get_tax_entry(std::string &species) {
     } else {
         // Using SQL database
         std::vector<std::vector<std::string>> results;
+        std::string sql = "SELECT " + SQL_COL_NCBI_TAX_TAXID + ", " + SQL_COL_NCBI_TAX_LINEAGE + " FROM " +
+                          SQL_TABLE_NCBI_TAX_TITLE + " WHERE " + SQL_COL_NCBI_TAX_NAME + "=?";
         temp_species = species;
         try {
             // If we can't find species, keep trying by making it more broad
             while (true) {
-                // Generate SQL query
-                char *query = sqlite3_mprintf(
-                        "SELECT %q, %q FROM %q WHERE %q=%Q",
-                        SQL_COL_NCBI_TAX_TAXID.c_str(),
-                        SQL_COL_NCBI_TAX_LINEAGE.c_str(),
-                        SQL_TABLE_NCBI_TAX_TITLE.c_str(),
-                        SQL_COL_NCBI_TAX_NAME.c_str(),
-                        temp_species.c_str()
-                );
-                results = _pDatabaseHelper->query(query);
+                results = _pDatabaseHelper->query(sql, {temp_species});
                 if (results.empty()) {
                     index = temp_species.find_last_of(' ');
                     if (index == std::string::npos) return TaxEntry(); // couldn't find
@@ -1001,11 +1083,23 @@ TaxEntry EntapDatabase::get_tax_entry(std::string &species) {
 
 UniprotEntry EntapDatabase::get_uniprot_entry(std::string& accession) {
     UniprotEntry uniprotEntry;
+    static Instrumentation::Counter &lookups = Instrumentation::counter("db_lookups.uniprot");
 
     if (accession.empty()) return UniprotEntry();
+    lookups++;
 
     try {
-        if (_use_serial) {
+        if (_use_serial && _pMappedDatabase != nullptr) {
+            // Using memory mapped database
+            MappedDatabase::Record record = _pMappedDatabase->find(MappedDatabase::TABLE_UNIPROT, accession);
+            if (!record.is_valid()) return UniprotEntry();
+            uniprotEntry.uniprot_id      = record.field(1).str();
+            uniprotEntry.database_x_refs = record.field(2).str();
+            uniprotEntry.comments        = record.field(3).str();
+            uniprotEntry.kegg_terms      = record.field(4).str();
+            uniprotEntry.go_terms        = MappedDatabase::decode_go_terms(record.field(5));
+            return uniprotEntry;
+        } else if (_use_serial) {
             // Using serialized database
             uniprot_serial_map_t::iterator it =
                     _pSerializedDatabase->uniprot_data.find(accession);
@@ -1016,17 +1110,11 @@ UniprotEntry EntapDatabase::get_uniprot_entry(std::string& accession) {
         } else {
             // Using SQL database
             std::vector<std::vector<std::string>> results;
-            char *query = sqlite3_mprintf(
-                    "SELECT %q, %q, %q FROM %q WHERE %q=%Q",
-                    SQL_TABLE_UNIPROT_COL_ID.c_str(),
-                    SQL_TABLE_UNIPROT_COL_XREF.c_str(),
-                    SQL_TABLE_UNIPROT_COL_COMM.c_str(),
-                    SQL_TABLE_UNIPROT_TITLE.c_str(),
-                    SQL_TABLE_UNIPROT_COL_ID.c_str(),
-                    accession.c_str()
-            );
+            results = _pDatabaseHelper->query(
+                    "SELECT " + SQL_TABLE_UNIPROT_COL_ID + ", " + SQL_TABLE_UNIPROT_COL_XREF + ", " +
+                    SQL_TABLE_UNIPROT_COL_COMM + " FROM " + SQL_TABLE_UNIPROT_TITLE +
+                    " WHERE " + SQL_TABLE_UNIPROT_COL_ID + "=?", {accession});
             if (results.empty()) return UniprotEntry();
-            results = _pDatabaseHelper->query(query);
             uniprotEntry.uniprot_id      = results[0][0];
             uniprotEntry.database_x_refs = results[0][1];
             uniprotEntry.comments        = results[0][2];
@@ -1172,15 +1260,14 @@ EntapDatabase::TaxonomyNode::TaxonomyNode(std::string id) {
 // terms = "GO:4321431,GO:807890"
 go_format_t EntapDatabase::format_go_delim(std::string terms, char delim) {
     go_format_t output;
-    std::string temp;
-    std::vector<std::vector<std::string>>results;
 
     if (terms.empty()) return output;
-    std::istringstream ss(terms);
-    while (std::getline(ss,temp,delim)) {
-        GoEntry term_info = get_go_entry(temp);
+    vect_str_t go_ids = split_string(terms, delim);
+    std::vector<GoEntry> entries = get_go_entries(go_ids);
+    for (uint64 i = 0; i < go_ids.size(); i++) {
+        GoEntry &term_info = entries[i];
         if (!term_info.is_empty()) {
-            output[term_info.category].push_back(temp + "-" + term_info.term +
+            output[term_info.category].push_back(go_ids[i] + "-" + term_info.term +
                                                  "(L=" + term_info.level + ")");
         }
     }
@@ -1196,7 +1283,10 @@ std::string EntapDatabase::get_current_version_str() {
 
     if (_use_serial) {
         // Using serialized database
-        if (_pSerializedDatabase != nullptr) {
+        if (_pMappedDatabase != nullptr) {
+            version_str = std::to_string(_pMappedDatabase->get_major_version()) + "." +
+                          std::to_string(_pMappedDatabase->get_minor_version());
+        } else if (_pSerializedDatabase != nullptr) {
             version_str = std::to_string(_pSerializedDatabase->MAJOR_VERSION) + "." +
                           std::to_string(_pSerializedDatabase->MINOR_VERSION);
         } else {
@@ -1239,6 +1329,177 @@ std::string EntapDatabase::get_required_version_str() {
     }
 }
 
+/**
+ * ======================================================================
+ * Function EntapDatabase::DATABASE_ERR EntapDatabase::mapped_database_save(std::string &out_path,
+ *                                                                std::string &source_path)
+ *
+ * Description          - Writes the loaded serialized database in the
+ *                        memory mapped format
+ *
+ * Notes                - Tables are written one at a time to limit the
+ *                        extra memory needed
+ *                      - Size and modification time of source_path are
+ *                        recorded so a stale copy can be detected
+ *
+ * @param out_path      - Path to write mapped database to
+ * @param source_path   - Serialized database the loaded data came from
+ *
+ * @return              - DATABASE_ERR type
+ *
+ * =====================================================================
+ */
+EntapDatabase::DATABASE_ERR EntapDatabase::mapped_database_save(std::string &out_path, std::string &source_path) {
+    MappedDatabaseWriter     writer;
+    std::vector<vect_str_t>  records;
+    bool                     success;
+
+    FS_dprint("Writing memory mapped EnTAP database to: " + out_path);
+    if (_pSerializedDatabase == nullptr) {
+        set_err_msg("No serialized database loaded to convert", ERR_DATA_SERIALIZE_SAVE);
+        return ERR_DATA_SERIALIZE_SAVE;
+    }
+    if (!writer.open(out_path, _pSerializedDatabase->MAJOR_VERSION, _pSerializedDatabase->MINOR_VERSION,
+                     source_path)) {
+        set_err_msg("Unable to open memory mapped database for writing: " + out_path, ERR_DATA_SERIALIZE_SAVE);
+        return ERR_DATA_SERIALIZE_SAVE;
+    }
+
+    records.reserve(_pSerializedDatabase->taxonomic_data.size());
+    for (auto &pair : _pSerializedDatabase->taxonomic_data) {
+        records.push_back({pair.first, pair.second.tax_id, pair.second.lineage, pair.second.tax_name});
+    }
+    success = writer.add_table(MappedDatabase::TABLE_TAXONOMY, 4, records);
+    records.clear();
+
+    records.reserve(_pSerializedDatabase->gene_ontology_data.size());
+    for (auto &pair : _pSerializedDatabase->gene_ontology_data) {
+        records.push_back({pair.first, pair.second.go_id, pair.second.term, pair.second.category,
+                           pair.second.level});
+    }
+    success &= writer.add_table(MappedDatabase::TABLE_GO, 5, records);
+    records.clear();
+
+    records.reserve(_pSerializedDatabase->uniprot_data.size());
+    for (auto &pair : _pSerializedDatabase->uniprot_data) {
+        records.push_back({pair.first, pair.second.uniprot_id, pair.second.database_x_refs,
+                           pair.second.comments, pair.second.kegg_terms,
+                           MappedDatabase::encode_go_terms(pair.second.go_terms)});
+    }
+    success &= writer.add_table(MappedDatabase::TABLE_UNIPROT, 6, records);
+    records.clear();
+
+    success &= writer.close();
+    if (!success) {
+        _pFilesystem->delete_file(out_path);
+        set_err_msg("Unable to write memory mapped database to: " + out_path, ERR_DATA_SERIALIZE_SAVE);
+        return ERR_DATA_SERIALIZE_SAVE;
+    }
+    FS_dprint("Success!");
+    return ERR_DATA_OK;
+}
+
+
+/**
+ * ======================================================================
+ * Function EntapDatabase::DATABASE_ERR EntapDatabase::mapped_database_read(std::string &in_path)
+ *
+ * Description          - Maps a database in the memory mapped format
+ *
+ * Notes                - Constant time, records are only touched on lookup
+ *
+ * @param in_path       - Path to mapped database
+ *
+ * @return              - DATABASE_ERR type
+ *
+ * =====================================================================
+ */
+EntapDatabase::DATABASE_ERR EntapDatabase::mapped_database_read(std::string &in_path) {
+    FS_dprint("Mapping EnTAP database from: " + in_path);
+
+    if (_pMappedDatabase != nullptr) return ERR_DATA_OK;
+    _pMappedDatabase = new MappedDatabase();
+    if (!_pMappedDatabase->open(in_path)) {
+        SAFE_DELETE(_pMappedDatabase);
+        set_err_msg("Unable to read memory mapped EnTAP database: " + in_path, ERR_DATA_SERIALIZE_READ);
+        return ERR_DATA_SERIALIZE_READ;
+    }
+    if (!is_valid_version()) {
+        set_err_msg("EnTAP database version is not compatible with this version of EnTAP.\n" \
+                    "Current Version: " + get_current_version_str() + "\nRequired version: " +
+                    get_required_version_str(),
+                    ERR_DATA_INCOMPATIBLE_VER);
+        FS_dprint("WARNING: invalid database version!!!");
+        SAFE_DELETE(_pMappedDatabase);
+        return ERR_DATA_INCOMPATIBLE_VER;
+    }
+    FS_dprint("Success! Taxonomy entries: " +
+              std::to_string(_pMappedDatabase->get_record_count(MappedDatabase::TABLE_TAXONOMY)) +
+              " GO entries: " + std::to_string(_pMappedDatabase->get_record_count(MappedDatabase::TABLE_GO)) +
+              " UniProt entries: " + std::to_string(_pMappedDatabase->get_record_count(MappedDatabase::TABLE_UNIPROT)));
+    return ERR_DATA_OK;
+}
+
+
+/**
+ * ======================================================================
+ * Function EntapDatabase::DATABASE_ERR EntapDatabase::convert_serialized_database(
+ *                                          std::string &in_path,
+ *                                          std::string &out_path)
+ *
+ * Description          - Converts an existing serialized (.bin) database
+ *                        to the memory mapped format
+ *
+ * Notes                - Serialized database is read in full once
+ *
+ * @param in_path       - Path to serialized database
+ * @param out_path      - Path to write mapped database to
+ *
+ * @return              - DATABASE_ERR type
+ *
+ * =====================================================================
+ */
+EntapDatabase::DATABASE_ERR EntapDatabase::convert_serialized_database(std::string &in_path, std::string &out_path) {
+    DATABASE_ERR err;
+
+    FS_dprint("Converting serialized database " + in_path + " to memory mapped format...");
+    _use_serial = true;
+    err = serialize_database_read(SERIALIZE_DEFAULT, in_path);
+    if (err != ERR_DATA_OK) return err;
+    return mapped_database_save(out_path, in_path);
+}
+
+
+// Returns path of the memory mapped copy of a serialized database (entap_database.bin -> entap_database.mdb)
+std::string EntapDatabase::get_mapped_path(const std::string &serial_path) {
+    const std::string serial_ext = ".bin";
+
+    if (serial_path.length() > serial_ext.length() &&
+        serial_path.compare(serial_path.length() - serial_ext.length(), serial_ext.length(), serial_ext) == 0) {
+        return serial_path.substr(0, serial_path.length() - serial_ext.length()) + ".mdb";
+    }
+    return serial_path + ".mdb";
+}
+
+
+TaxEntry EntapDatabase::get_mapped_tax_entry(std::string &species) {
+    TaxEntry               taxEntry;
+    MappedDatabase::Record record;
+    uint64                 len = species.length();
+
+    // If we can't find species, keep trying by making it more broad
+    while (true) {
+        record = _pMappedDatabase->find(MappedDatabase::TABLE_TAXONOMY, species.data(), (uint32) len);
+        if (record.is_valid()) break;
+        len = species.find_last_of(' ', len - 1);
+        if (len == std::string::npos || len == 0) return TaxEntry();
+    }
+    taxEntry.tax_id   = record.field(1).str();
+    taxEntry.lineage  = record.field(2).str();
+    taxEntry.tax_name = record.field(3).str();
+    return taxEntry;
+}
+
 bool EntapDatabase::set_database_versions(EntapDatabase::DATABASE_TYPE type) {
     bool ret;
 
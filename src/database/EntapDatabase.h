@@ -31,6 +31,7 @@
 #include "../EntapGlobals.h"
 #include "../EntapConfig.h"
 #include "SQLDatabaseHelper.h"
+#include "MappedDatabase.h"
 
 #ifdef USE_BOOST    // Include boost serialization headers
 #include <boost/serialization/serialization.hpp>
@@ -304,8 +305,13 @@ public:
     // Database accession routines
     TaxEntry get_tax_entry(std::string& species);
     GoEntry get_go_entry(std::string& go_id);
+    std::vector<GoEntry> get_go_entries(vect_str_t &go_ids);
     UniprotEntry get_uniprot_entry(std::string& accession);
 
+    // Memory mapped format
+    DATABASE_ERR convert_serialized_database(std::string &in_path, std::string &out_path);
+    static std::string get_mapped_path(const std::string &serial_path);
+
     // Database versioning
     bool is_valid_version();
     std::string get_current_version_str();
@@ -332,6 +338,9 @@ private:
 
     DATABASE_ERR serialize_database_save(SERIALIZATION_TYPE, std::string&);
     DATABASE_ERR serialize_database_read(SERIALIZATION_TYPE, std::string&);
+    DATABASE_ERR mapped_database_save(std::string&, std::string&);
+    DATABASE_ERR mapped_database_read(std::string&);
+    TaxEntry get_mapped_tax_entry(std::string &species);
 
     // FTP Paths
     const std::string FTP_GO_DATABASE =
@@ -400,6 +409,7 @@ private:
     const uint8 STATUS_UPDATES = 5;     // Percentage of updates when downloading/configuring
 
     EntapDatabaseStruct *_pSerializedDatabase;
+    MappedDatabase      *_pMappedDatabase;      // Set instead of _pSerializedDatabase when mapped file exists
     FileSystem          *_pFilesystem;
     SQLDatabaseHelper   *_pDatabaseHelper;
     std::string          _temp_directory;
@@ -0,0 +1,378 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "MappedDatabase.h"
+//**************************************************************
+
+constexpr char MappedDatabase::MAGIC[9];
+
+namespace {
+    const uint64 HEADER_SIZE        = 64;
+    const uint64 HEADER_VERSION_POS = 8;
+    const uint64 HEADER_MAJOR_POS   = 12;
+    const uint64 HEADER_MINOR_POS   = 13;
+    const uint64 HEADER_TABLES_POS  = 16;
+    const uint64 HEADER_SOURCE_POS  = 40;    // source size, source mtime
+    const uint64 TABLE_HEADER_SIZE  = 16;    // count, field count, padding
+    const char   GO_TERM_DELIM      = '\x1f';
+    const char   GO_CATEGORY_DELIM  = '\x1e';
+
+    template<typename T>
+    T read_value(const char *pos) {
+        T val;
+        memcpy(&val, pos, sizeof(T));
+        return val;
+    }
+
+    template<typename T>
+    void write_value(std::ofstream &file, T val) {
+        file.write(reinterpret_cast<const char*>(&val), sizeof(T));
+    }
+}
+
+
+MappedDatabase::MappedDatabase() {
+    close();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool MappedDatabase::open(const std::string &path)
+ *
+ * Description          - Maps a database file and validates its header
+ *                        and table bounds
+ *
+ * Notes                - No records are read, cost is independent of
+ *                        database size
+ *
+ * @param path          - Path to mapped database
+ *
+ * @return              - True if file is a valid mapped database
+ *
+ * =====================================================================
+ */
+bool MappedDatabase::open(const std::string &path) {
+    const char *data;
+    uint64      size;
+    uint64      offset;
+
+    close();
+    if (!_file.open(path)) return false;
+    data = _file.data();
+    size = _file.size();
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC) - 1) != 0 ||
+        read_value<uint32>(data + HEADER_VERSION_POS) != FORMAT_VERSION) {
+        close();
+        return false;
+    }
+    _major_version = read_value<uint8>(data + HEADER_MAJOR_POS);
+    _minor_version = read_value<uint8>(data + HEADER_MINOR_POS);
+    _source_size   = read_value<uint64>(data + HEADER_SOURCE_POS);
+    _source_mtime  = read_value<int64>(data + HEADER_SOURCE_POS + sizeof(uint64));
+
+    for (uint32 i = 0; i < TABLE_COUNT; i++) {
+        offset = read_value<uint64>(data + HEADER_TABLES_POS + i * sizeof(uint64));
+        if (offset == 0) continue;      // Table not present
+        if (offset + TABLE_HEADER_SIZE > size) {
+            close();
+            return false;
+        }
+        _tables[i].count       = read_value<uint64>(data + offset);
+        _tables[i].field_count = read_value<uint32>(data + offset + sizeof(uint64));
+        _tables[i].offsets     = data + offset + TABLE_HEADER_SIZE;
+        if (_tables[i].count > (size - offset - TABLE_HEADER_SIZE) / sizeof(uint64)) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedDatabase::close() {
+    _file.close();
+    for (TableInfo &table : _tables) {
+        table.offsets     = nullptr;
+        table.count       = 0;
+        table.field_count = 0;
+    }
+    _major_version = 0;
+    _minor_version = 0;
+    _source_size   = 0;
+    _source_mtime  = 0;
+}
+
+bool MappedDatabase::is_open() const {
+    return _file.is_open();
+}
+
+uint8 MappedDatabase::get_major_version() const {
+    return _major_version;
+}
+
+uint8 MappedDatabase::get_minor_version() const {
+    return _minor_version;
+}
+
+uint64 MappedDatabase::get_record_count(MappedDatabase::TABLE table) const {
+    return _tables[table].count;
+}
+
+// True if source file still has the size and modification time recorded when this database was written
+bool MappedDatabase::is_built_from(const std::string &source_path) const {
+    uint64 size;
+    int64  mtime;
+
+    if (!MappedFile::get_file_stamp(source_path, size, mtime)) return false;
+    return size == _source_size && mtime == _source_mtime;
+}
+
+
+/**
+ * ======================================================================
+ * Function MappedDatabase::Record MappedDatabase::find(TABLE table,
+ *                                          const char *key, uint32 key_len)
+ *
+ * Description          - Binary searches a table for a key
+ *
+ * Notes                - Keys compare bytewise, same as std::string
+ *
+ * @param table         - Table to search
+ * @param key           - Key to find
+ * @param key_len       - Length of key
+ *
+ * @return              - Record view, invalid if key not found
+ *
+ * =====================================================================
+ */
+MappedDatabase::Record MappedDatabase::find(MappedDatabase::TABLE table, const char *key, uint32 key_len) const {
+    const TableInfo &info = _tables[table];
+    uint64           low  = 0;
+    uint64           high = info.count;
+    uint64           mid;
+    int              cmp;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        Record record = get_record(info, mid);
+        if (!record.is_valid()) return Record();
+        FieldView record_key = record.field(0);
+
+        cmp = memcmp(record_key.data, key, std::min(record_key.length, key_len));
+        if (cmp == 0) cmp = record_key.length < key_len ? -1 : (record_key.length > key_len ? 1 : 0);
+        if (cmp == 0) return record;
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return Record();
+}
+
+MappedDatabase::Record MappedDatabase::find(MappedDatabase::TABLE table, const std::string &key) const {
+    return find(table, key.data(), (uint32) key.length());
+}
+
+// Record at index within a table, invalid if its field lengths or data fall outside the file
+MappedDatabase::Record MappedDatabase::get_record(const TableInfo &info, uint64 index) const {
+    uint64 size   = _file.size();
+    uint64 offset = read_value<uint64>(info.offsets + index * sizeof(uint64));
+    uint64 length = (uint64) info.field_count * sizeof(uint32);
+
+    if (info.field_count == 0 || offset > size || length > size - offset) return Record();
+    for (uint32 i = 0; i < info.field_count; i++) {
+        length += read_value<uint32>(_file.data() + offset + i * sizeof(uint32));
+    }
+    if (length > size - offset) return Record();
+    return Record(_file.data() + offset, info.field_count);
+}
+
+MappedDatabase::FieldView MappedDatabase::Record::field(uint32 index) const {
+    FieldView view;
+    const char *pos = _data + _field_count * sizeof(uint32);
+
+    if (index >= _field_count) {
+        view.data   = pos;
+        view.length = 0;
+        return view;
+    }
+
+    for (uint32 i = 0; i < index; i++) {
+        pos += read_value<uint32>(_data + i * sizeof(uint32));
+    }
+    view.data   = pos;
+    view.length = read_value<uint32>(_data + index * sizeof(uint32));
+    return view;
+}
+
+
+// Returns true if file at path begins with the mapped database magic
+bool MappedDatabase::is_mapped_database(const std::string &path) {
+    char magic[sizeof(MAGIC) - 1];
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.read(magic, sizeof(magic))) return false;
+    return memcmp(magic, MAGIC, sizeof(magic)) == 0;
+}
+
+
+// Flattens categorized GO terms into a single field
+std::string MappedDatabase::encode_go_terms(const std::map<std::string, std::vector<std::string>> &go_terms) {
+    std::string ret;
+
+    for (auto &pair : go_terms) {
+        ret += pair.first;
+        for (const std::string &term : pair.second) {
+            ret += GO_TERM_DELIM;
+            ret += term;
+        }
+        ret += GO_CATEGORY_DELIM;
+    }
+    return ret;
+}
+
+
+std::map<std::string, std::vector<std::string>> MappedDatabase::decode_go_terms(MappedDatabase::FieldView field) {
+    std::map<std::string, std::vector<std::string>> ret;
+    const char *pos = field.data;
+    const char *end = field.data + field.length;
+    const char *category_end;
+    const char *term_end;
+
+    while (pos < end) {
+        category_end = static_cast<const char*>(memchr(pos, GO_CATEGORY_DELIM, end - pos));
+        if (category_end == nullptr) category_end = end;
+        term_end = static_cast<const char*>(memchr(pos, GO_TERM_DELIM, category_end - pos));
+        if (term_end == nullptr) term_end = category_end;
+
+        std::vector<std::string> &terms = ret[std::string(pos, term_end)];
+        pos = term_end;
+        while (pos < category_end) {
+            pos++;  // Skip delim
+            term_end = static_cast<const char*>(memchr(pos, GO_TERM_DELIM, category_end - pos));
+            if (term_end == nullptr) term_end = category_end;
+            terms.emplace_back(pos, term_end);
+            pos = term_end;
+        }
+        pos = category_end + 1;
+    }
+    return ret;
+}
+
+
+MappedDatabaseWriter::MappedDatabaseWriter() {
+    for (uint64 &offset : _table_offsets) offset = 0;
+    _major_version = 0;
+    _minor_version = 0;
+    _source_size   = 0;
+    _source_mtime  = 0;
+}
+
+bool MappedDatabaseWriter::open(const std::string &path, uint8 major_version, uint8 minor_version,
+                                const std::string &source_path) {
+    _file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_file.is_open()) return false;
+    _major_version = major_version;
+    _minor_version = minor_version;
+    if (!MappedFile::get_file_stamp(source_path, _source_size, _source_mtime)) {
+        _source_size  = 0;
+        _source_mtime = 0;
+    }
+    // Reserve header, written on close once table offsets are known
+    std::string header(HEADER_SIZE, '\0');
+    _file.write(header.data(), header.size());
+    return _file.good();
+}
+
+
+/**
+ * ======================================================================
+ * Function bool MappedDatabaseWriter::add_table(MappedDatabase::TABLE table,
+ *                                               uint32 field_count,
+ *                                               std::vector<vect_str_t> &records)
+ *
+ * Description          - Sorts records by key and writes them as a table
+ *
+ * Notes                - Records are sorted in place
+ *
+ * @param table         - Table being written
+ * @param field_count   - Fields in every record, key first
+ * @param records       - Records to write
+ *
+ * @return              - True if written successfully
+ *
+ * =====================================================================
+ */
+bool MappedDatabaseWriter::add_table(MappedDatabase::TABLE table, uint32 field_count,
+                                     std::vector<vect_str_t> &records) {
+    uint64 table_pos;
+    uint64 record_pos;
+
+    std::sort(records.begin(), records.end(), [](const vect_str_t &first, const vect_str_t &second) {
+        return first[0] < second[0];
+    });
+
+    table_pos = (uint64) _file.tellp();
+    _table_offsets[table] = table_pos;
+    write_value<uint64>(_file, records.size());
+    write_value<uint32>(_file, field_count);
+    write_value<uint32>(_file, 0);
+
+    // Offset index, records follow directly after it
+    record_pos = table_pos + TABLE_HEADER_SIZE + records.size() * sizeof(uint64);
+    for (vect_str_t &record : records) {
+        if (record.size() != field_count) return false;
+        write_value<uint64>(_file, record_pos);
+        record_pos += field_count * sizeof(uint32);
+        for (std::string &field : record) record_pos += field.length();
+    }
+    for (vect_str_t &record : records) {
+        for (std::string &field : record) write_value<uint32>(_file, (uint32) field.length());
+        for (std::string &field : record) _file.write(field.data(), field.length());
+    }
+    return _file.good();
+}
+
+bool MappedDatabaseWriter::close() {
+    std::string header(HEADER_SIZE, '\0');
+
+    memcpy(&header[0], MappedDatabase::MAGIC, sizeof(MappedDatabase::MAGIC) - 1);
+    uint32 version = MappedDatabase::FORMAT_VERSION;
+    memcpy(&header[HEADER_VERSION_POS], &version, sizeof(version));
+    header[HEADER_MAJOR_POS] = (char) _major_version;
+    header[HEADER_MINOR_POS] = (char) _minor_version;
+    memcpy(&header[HEADER_TABLES_POS], _table_offsets, sizeof(_table_offsets));
+    memcpy(&header[HEADER_SOURCE_POS], &_source_size, sizeof(_source_size));
+    memcpy(&header[HEADER_SOURCE_POS + sizeof(uint64)], &_source_mtime, sizeof(_source_mtime));
+
+    _file.seekp(0);
+    _file.write(header.data(), header.size());
+    _file.close();
+    return !_file.fail();
+}
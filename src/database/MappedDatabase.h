@@ -0,0 +1,145 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_MAPPEDDATABASE_H
+#define ENTAP_MAPPEDDATABASE_H
+
+//*********************** Includes *****************************
+#include "../common.h"
+#include "../MappedFile.h"
+//**************************************************************
+
+
+/**
+ * Read-only, memory mapped EnTAP reference database.
+ *
+ * File layout (native byte order):
+ *
+ *      Header      magic "ENTAPMDB", format version, EnTAP database
+ *                  major/minor version, file offset of each table, size
+ *                  and modification time of the serialized database it
+ *                  was built from
+ *      Table       record count, fields per record, then one file offset
+ *                  per record. Records are sorted by key (field 0)
+ *      Record      length of each field followed by the field bytes
+ *
+ * Opening only maps the file and validates the header, so start up does
+ * not depend on database size. Pages are shared between every process
+ * mapping the same file. Lookups binary search the offset index and
+ * return views into the mapping, nothing is copied.
+ */
+class MappedDatabase {
+
+public:
+    typedef enum {
+        TABLE_TAXONOMY=0,   // species, tax id, lineage, tax name
+        TABLE_GO,           // go id, go id, term, category, level
+        TABLE_UNIPROT,      // accession, uniprot id, xrefs, comments, kegg, go terms
+        TABLE_COUNT
+    } TABLE;
+
+    // Pointer/length view of a field inside the mapping
+    struct FieldView {
+        const char *data;
+        uint32      length;
+
+        std::string str() const {return std::string(data, length);}
+    };
+
+    // View of a single record, valid while the database is open
+    class Record {
+    public:
+        Record() : _data(nullptr), _field_count(0) {}
+        Record(const char *data, uint32 field_count) : _data(data), _field_count(field_count) {}
+        bool is_valid() const {return _data != nullptr;}
+        FieldView field(uint32 index) const;
+
+    private:
+        const char *_data;
+        uint32      _field_count;
+    };
+
+    MappedDatabase();
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    uint8 get_major_version() const;
+    uint8 get_minor_version() const;
+    uint64 get_record_count(TABLE table) const;
+    bool is_built_from(const std::string &source_path) const;
+    Record find(TABLE table, const char *key, uint32 key_len) const;
+    Record find(TABLE table, const std::string &key) const;
+
+    static bool is_mapped_database(const std::string &path);
+    static std::string encode_go_terms(const std::map<std::string, std::vector<std::string>> &go_terms);
+    static std::map<std::string, std::vector<std::string>> decode_go_terms(FieldView field);
+
+    static constexpr uint32 FORMAT_VERSION = 2;
+    static constexpr char   MAGIC[9]       = "ENTAPMDB";
+
+private:
+    struct TableInfo {
+        const char *offsets;        // Start of record offset index
+        uint64      count;
+        uint32      field_count;
+    };
+
+    Record get_record(const TableInfo &info, uint64 index) const;
+
+    MappedFile  _file;
+    TableInfo   _tables[TABLE_COUNT];
+    uint8       _major_version;
+    uint8       _minor_version;
+    uint64      _source_size;
+    int64       _source_mtime;
+};
+
+
+/**
+ * Writes a MappedDatabase file. Tables may be added in any order, each is
+ * sorted by key and written as it is added. Header is written on close.
+ */
+class MappedDatabaseWriter {
+
+public:
+    MappedDatabaseWriter();
+    bool open(const std::string &path, uint8 major_version, uint8 minor_version,
+              const std::string &source_path);
+    bool add_table(MappedDatabase::TABLE table, uint32 field_count, std::vector<vect_str_t> &records);
+    bool close();
+
+private:
+    std::ofstream _file;
+    uint64        _table_offsets[MappedDatabase::TABLE_COUNT];
+    uint8         _major_version;
+    uint8         _minor_version;
+    uint64        _source_size;
+    int64         _source_mtime;
+};
+
+
+#endif //ENTAP_MAPPEDDATABASE_H
@@ -75,7 +75,82 @@ bool SQLDatabaseHelper::open(std::string file) {
  * =====================================================================
  */
 void SQLDatabaseHelper::close() {
-    sqlite3_close(_database);
+    finalize_statements();
+    if (_database != NULL) {
+        sqlite3_close(_database);
+        _database = NULL;
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function bool SQLDatabaseHelper::open_read_only(std::string file)
+ *
+ * Description          - Opens an existing sql database for reading only
+ *
+ * Notes                - Connection is opened without SQLite's own mutex,
+ *                        meant to be owned by a single worker thread
+ *
+ * @param file          - Path to database
+ *
+ * @return              - True/false if successful
+ *
+ * =====================================================================
+ */
+bool SQLDatabaseHelper::open_read_only(std::string file) {
+    int err_code;
+    err_code = sqlite3_open_v2(file.c_str(), &_database, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+    if (err_code != SQLITE_OK) close();
+    return err_code == SQLITE_OK;
+}
+
+
+/**
+ * ======================================================================
+ * Function SQLDatabaseHelper::Cursor::Cursor(SQLDatabaseHelper &database,
+ *                                            const std::string &sql)
+ *
+ * Description          - Prepares a query to be stepped through row by row
+ *
+ * Notes                - Statement is not cached, it lives as long as the
+ *                        cursor
+ *
+ * @param database      - Open database to query
+ * @param sql           - Query to run
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+SQLDatabaseHelper::Cursor::Cursor(SQLDatabaseHelper &database, const std::string &sql) {
+    if (sqlite3_prepare_v2(database._database, sql.c_str(), (int) sql.length() + 1, &_stmt, 0) != SQLITE_OK) {
+        throw ExceptionHandler("Error querying database: " + std::string(sqlite3_errmsg(database._database)),
+                               ERR_ENTAP_DATABASE_QUERY);
+    }
+}
+
+SQLDatabaseHelper::Cursor::~Cursor() {
+    sqlite3_finalize(_stmt);
+}
+
+// Reads the next row into row (NULL columns are empty), false once all rows are read
+bool SQLDatabaseHelper::Cursor::next(vect_str_t &row) {
+    char *txt;
+    int   col_num;
+
+    if (sqlite3_step(_stmt) != SQLITE_ROW) return false;
+    col_num = sqlite3_column_count(_stmt);
+    row.resize((uint64) col_num);
+    for (int i = 0; i < col_num; i++) {
+        txt = (char*)sqlite3_column_text(_stmt, i);
+        if (txt != nullptr) {
+            row[i].assign(txt);
+        } else {
+            row[i].clear();
+        }
+    }
+    return true;
 }
 
 
@@ -117,31 +192,8 @@ bool SQLDatabaseHelper::create(std::string file) {
 std::vector<std::vector<std::string>> SQLDatabaseHelper::query(char *query) {
     sqlite3_stmt *stmt;
     query_struct output;
-    char* txt;
     if (sqlite3_prepare_v2(_database,query,-1,&stmt,0) == SQLITE_OK) {
-        int col_num = sqlite3_column_count(stmt);
-        int stat = 0;
-        while (true) {
-            stat = sqlite3_step(stmt);
-            if (stat == SQLITE_ROW) {
-                std::vector<std::string> vals;
-                for (int i = 0; i < col_num; i++) {
-                    try {
-                        txt = (char*)sqlite3_column_text(stmt, i);
-                        if (txt != nullptr) {
-                            vals.push_back(std::string(txt));
-                        } else {
-                            vals.push_back("");
-                        }
-                    } catch (const std::exception &e) {
-                        FS_dprint("SQL Error: " + std::string(e.what()));
-                    }
-                }
-                output.push_back(vals);
-            } else {
-                break;
-            }
-        }
+        read_rows(stmt, output);
         sqlite3_finalize(stmt);
     } else {
         throw ExceptionHandler("Error querying database: " + std::string(sqlite3_errmsg(_database)),
@@ -151,6 +203,136 @@ std::vector<std::vector<std::string>> SQLDatabaseHelper::query(char *query) {
 }
 
 
+/**
+ * ======================================================================
+ * Function SQLDatabaseHelper::query_struct SQLDatabaseHelper::query(const std::string &sql,
+ *                                                    const vect_str_t &params)
+ *
+ * Description          - Runs a parameterized query ('?' placeholders)
+ *                        through a cached prepared statement
+ *
+ * Notes                - Statements are compiled once per SQL text and
+ *                        reset for reuse, parameters are bound as text
+ *                      - Safe to call from multiple threads
+ *
+ * @param sql           - SQL text with '?' placeholders
+ * @param params        - Values bound to placeholders in order
+ *
+ * @return              - Vector of queried information
+ *
+ * =====================================================================
+ */
+SQLDatabaseHelper::query_struct SQLDatabaseHelper::query(const std::string &sql, const vect_str_t &params) {
+    query_struct output;
+    std::lock_guard<std::mutex> guard(_lock);
+    sqlite3_stmt *stmt = get_statement(sql);
+
+    for (uint32 i = 0; i < params.size(); i++) {
+        sqlite3_bind_text(stmt, i + 1, params[i].c_str(), (int) params[i].length(), SQLITE_STATIC);
+    }
+    read_rows(stmt, output);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return output;
+}
+
+
+/**
+ * ======================================================================
+ * Function SQLDatabaseHelper::query_struct SQLDatabaseHelper::query_batch(const std::string &select,
+ *                                                    const std::string &key_column,
+ *                                                    const vect_str_t &keys)
+ *
+ * Description          - Looks up many keys with as few statements as
+ *                        possible ("WHERE key_column IN (?,?,...)")
+ *
+ * Notes                - Keys are bound in chunks of BATCH_KEYS_MAX
+ *                        through one cached statement, placeholders
+ *                        past the last key of a chunk stay NULL (never
+ *                        match)
+ *                      - Rows come back in no particular order, select
+ *                        the key column to match rows to keys
+ *
+ * @param select        - "SELECT ... FROM ..." portion of the query
+ * @param key_column    - Column keys are matched against
+ * @param keys          - Keys to look up
+ *
+ * @return              - Rows of all matched keys
+ *
+ * =====================================================================
+ */
+SQLDatabaseHelper::query_struct SQLDatabaseHelper::query_batch(const std::string &select,
+                                                               const std::string &key_column,
+                                                               const vect_str_t &keys) {
+    query_struct output;
+    std::string  sql;
+    uint64       chunk_size;
+
+    if (keys.empty()) return output;
+    sql = select + " WHERE " + key_column + " IN (?";
+    for (uint32 i = 1; i < BATCH_KEYS_MAX; i++) sql += ",?";
+    sql += ")";
+
+    for (uint64 start = 0; start < keys.size(); start += chunk_size) {
+        chunk_size = std::min<uint64>(BATCH_KEYS_MAX, keys.size() - start);
+
+        std::lock_guard<std::mutex> guard(_lock);
+        sqlite3_stmt *stmt = get_statement(sql);
+        for (uint64 i = 0; i < chunk_size; i++) {
+            const std::string &key = keys[start + i];
+            sqlite3_bind_text(stmt, (int) i + 1, key.c_str(), (int) key.length(), SQLITE_STATIC);
+        }
+        read_rows(stmt, output);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    return output;
+}
+
+
+// Returns cached statement for SQL text, compiling it on first use. Caller holds _lock
+sqlite3_stmt *SQLDatabaseHelper::get_statement(const std::string &sql) {
+    sqlite3_stmt *stmt;
+
+    auto it = _statements.find(sql);
+    if (it != _statements.end()) return it->second;
+
+    if (sqlite3_prepare_v2(_database, sql.c_str(), (int) sql.length() + 1, &stmt, 0) != SQLITE_OK) {
+        throw ExceptionHandler("Error querying database: " + std::string(sqlite3_errmsg(_database)),
+                               ERR_ENTAP_DATABASE_QUERY);
+    }
+    _statements.emplace(sql, stmt);
+    return stmt;
+}
+
+void SQLDatabaseHelper::read_rows(sqlite3_stmt *stmt, query_struct &output) {
+    char* txt;
+    int col_num = sqlite3_column_count(stmt);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::vector<std::string> vals;
+        vals.reserve(col_num);
+        for (int i = 0; i < col_num; i++) {
+            txt = (char*)sqlite3_column_text(stmt, i);
+            if (txt != nullptr) {
+                vals.push_back(std::string(txt));
+            } else {
+                vals.push_back("");
+            }
+        }
+        output.push_back(vals);
+    }
+}
+
+void SQLDatabaseHelper::finalize_statements() {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (auto &pair : _statements) {
+        sqlite3_finalize(pair.second);
+    }
+    _statements.clear();
+}
+
+
 SQLDatabaseHelper::SQLDatabaseHelper() {
     _database = NULL;
 }
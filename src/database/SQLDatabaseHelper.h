@@ -30,6 +30,7 @@
 #define ENTAP_DATABASEHELPER_H
 
 #include <iostream>
+#include <mutex>
 #include "../common.h"
 #include "sqlite3.h"
 
@@ -39,20 +40,45 @@ class SQLDatabaseHelper {
 public:
     typedef std::vector<std::vector<std::string>> query_struct;
 
+    // Steps through the rows of a query one at a time, for scans too large
+    // to hold in memory. Statement is finalized on destruction
+    class Cursor {
+    public:
+        Cursor(SQLDatabaseHelper &database, const std::string &sql);
+        ~Cursor();
+        Cursor(const Cursor&) = delete;
+        Cursor& operator=(const Cursor&) = delete;
+        bool next(vect_str_t &row);
+
+    private:
+        sqlite3_stmt *_stmt;
+    };
+
     SQLDatabaseHelper();
     ~SQLDatabaseHelper();
     bool open(std::string file);
+    bool open_read_only(std::string file);
     bool create(std::string file);
     bool execute_cmd(char*);
     void close();
     query_struct query(char* query);
+    query_struct query(const std::string &sql, const vect_str_t &params);
+    query_struct query_batch(const std::string &select, const std::string &key_column, const vect_str_t &keys);
 
     // change to template
     std::string format_container(std::set<std::string> &in_cont);
     std::string format_string(std::string& str, char delim);
 
 private:
+    static constexpr uint32 BATCH_KEYS_MAX = 500;   // Keys bound per IN (...) statement, below SQLite's limit
+
+    sqlite3_stmt *get_statement(const std::string &sql);
+    void read_rows(sqlite3_stmt *stmt, query_struct &output);
+    void finalize_statements();
+
     sqlite3 *_database;
+    std::unordered_map<std::string, sqlite3_stmt*> _statements;    // Prepared statements by SQL text
+    std::mutex _lock;                                               // Guards statement use across threads
 };
 
 
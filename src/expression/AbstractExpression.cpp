@@ -25,7 +25,17 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
+//*********************** Includes *****************************
 #include "AbstractExpression.h"
+#include "../QueryData.h"
+#include "../QuerySequence.h"
+#include "../ExceptionHandler.h"
+#include "../FastaScanner.h"
+#include "../MappedFile.h"
+#include "../OutputWriter.h"
+#include <thread>
+//**************************************************************
 
 AbstractExpression::AbstractExpression(std::string &execution_stage_path, std::string &in_hits,
                                        EntapDataPtrs &entap_data, std::string module_name, std::string &exe,
@@ -34,4 +44,338 @@ EntapModule(execution_stage_path, in_hits, entap_data, module_name, exe) {
 
     _alignpath = align;
     _execution_state = EXPRESSION_FILTERING;
-}
\ No newline at end of file
+}
+
+
+/**
+ * ======================================================================
+ * Function void AbstractExpression::filter_transcriptome(const std::string &results_path,
+ *                                                   const std::string &software_name,
+ *                                                   int err_code)
+ *
+ * Description          - Handles filtering of transcriptome based on
+ *                        user selected FPKM threshold
+ *                      - Updates master query sequence map
+ *
+ * Notes                - Results are memory mapped and split in place,
+ *                        only the FPKM column is converted
+ *                      - Kept and removed FASTA files are written
+ *                        concurrently once all rows are parsed
+ *
+ * @param results_path  - Results in RSEM .genes.results layout
+ * @param software_name - Module name for statistics
+ * @param err_code      - Error code thrown on failure
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void AbstractExpression::filter_transcriptome(const std::string &results_path, const std::string &software_name,
+                                              int err_code) {
+    FS_dprint("Beginning to filter transcriptome...");
+
+    uint32              count_removed=0;
+    uint32              count_kept=0;
+    uint32              count_total=0;      // Used to warn user if high percentage is removed
+    uint32              min_removed=0xFFFFFFFF;
+    uint32              min_selected=0xFFFFFFFF;
+    uint32              max_removed=0;
+    uint32              max_selected=0;
+    uint64              total_removed_len=0;
+    uint64              total_kept_len=0;
+    uint16              length;
+    fp32                fpkm_val;
+    fp32                rejected_percent=0;
+    fp32                avg_removed;
+    fp32                avg_kept;
+    bool                removed_ok=false;
+    const char         *pos;
+    const char         *line_start;
+    const char         *line_end;
+    RESULTS_FIELD       fields[RESULTS_COL_NUM];
+    std::string         geneid;
+    std::string         out_str;
+    std::string         out_kept;
+    std::string         out_removed;
+    std::string         kept_filename;
+    std::string         original_filename;
+    std::string         removed_filename;
+    std::string         fig_txt_box_path;
+    std::string         fig_png_box_path;
+    std::string         fig_row;
+    std::string         min_kept_seq;
+    std::string         max_kept_seq;
+    std::string         max_removed_seq;
+    std::string         min_removed_seq;
+    std::stringstream   out_msg;
+    std::vector<uint16> all_kept_lengths;
+    std::vector<uint16> all_lost_lengths;
+    std::vector<QuerySequence*> kept_sequences;
+    std::vector<QuerySequence*> removed_sequences;
+    std::pair<uint64,uint64> kept_n;
+    GraphingData        graphingStruct;
+    MappedFile          in_file;
+    OutputWriter        file_fig_box;
+    std::thread         removed_writer;
+    QUERY_MAP_T         *MAP;
+
+    MAP = _pQUERY_DATA->get_sequences_ptr();
+
+    if (!_pFileSystem->file_exists(results_path)) {
+        throw ExceptionHandler("File does not exist at: " + results_path,
+                               err_code);
+    }
+    if (!in_file.open(results_path)) {
+        throw ExceptionHandler("Unable to read expression results: " + results_path,
+                               err_code);
+    }
+
+    // Setup figure files, directories already created
+    fig_txt_box_path = PATHS(_figure_dir, GRAPH_TXT_BOX_PLOT);
+    fig_png_box_path = PATHS(_figure_dir, GRAPH_PNG_BOX_PLOT);
+
+    // Open figure text file
+    file_fig_box.open(fig_txt_box_path, true);
+    file_fig_box.write("flag\tsequence length\n");    // First line placeholder, not used
+
+    // Setup processed file paths, directories already created
+    original_filename = _filename;
+    removed_filename  = original_filename + EXP_OUT_REMOVED;
+    kept_filename     = original_filename + EXP_OUT_KEPT;
+    out_kept    = PATHS(_proc_dir, kept_filename);
+    out_removed = PATHS(_proc_dir, removed_filename);
+
+    // Begin to iterate through results file, first line is the header
+    pos = FastaScanner::next_line(in_file.data(), in_file.end(), line_end);
+    while (pos < in_file.end()) {
+        line_start = pos;
+        pos = FastaScanner::next_line(pos, in_file.end(), line_end);
+        if (line_end == line_start) continue;
+        if (!split_results_row(line_start, line_end, fields) ||
+            !parse_fp32(fields[RESULTS_COL_FPKM].first, fields[RESULTS_COL_FPKM].second, fpkm_val)) {
+            throw ExceptionHandler("Unable to parse expression results: " + results_path +
+                                   "\nLine: " + std::string(line_start, line_end),
+                                   err_code);
+        }
+        count_total++;
+        _pQUERY_DATA->trim_sequence_id(fields[0].first, fields[0].second, geneid);
+        QUERY_MAP_T::iterator it = MAP->find(geneid);
+        if (it == MAP->end()) {
+            throw ExceptionHandler("Unable to find sequence: " + geneid + " there may be a discrepancy between"
+                                                                          " sequence headers in your transcriptome and "
+                                                                          "headers in your BAM/SAM file. Try trimming"
+                                                                          " your sequence headers to the first space and re-running.",
+                                   err_code);
+        }
+        QuerySequence *querySequence = it->second;
+        querySequence->set_fpkm(fpkm_val);
+        length = (uint16)querySequence->getSeq_length();
+        fig_row.clear();
+        if (fpkm_val > _fpkm) {
+            // Kept sequence
+            kept_sequences.push_back(querySequence);
+            fig_row += GRAPH_KEPT_FLAG;
+            if (length < min_selected) {
+                min_selected = length;
+                min_kept_seq = geneid;
+            }
+            if (length > max_selected) {
+                max_selected = length;
+                max_kept_seq = geneid;
+            }
+            all_kept_lengths.push_back(length);
+            total_kept_len += length;
+            count_kept++;
+        } else {
+            // Removed sequence
+            querySequence->QUERY_FLAG_CLEAR(QuerySequence::QUERY_EXPRESSION_KEPT);
+            removed_sequences.push_back(querySequence);
+            fig_row += GRAPH_REJECTED_FLAG;
+
+            if (length < min_removed) {
+                min_removed = length;
+                min_removed_seq = geneid;
+            }
+            if (length > max_removed) {
+                max_removed_seq = geneid;
+                max_removed = length;
+            }
+            all_lost_lengths.push_back(length);
+            total_removed_len += length;
+            count_removed++;
+        }
+        fig_row += '\t';
+        fig_row += std::to_string(length);
+        fig_row += '\n';
+        file_fig_box.write(fig_row);
+    }
+    in_file.close();
+
+    // Removed sequences are written on their own thread while kept are written here
+    removed_writer = std::thread([&]() {
+        removed_ok = write_sequences(out_removed, removed_sequences);
+    });
+    if (!write_sequences(out_kept, kept_sequences)) {
+        removed_writer.join();
+        throw ExceptionHandler("Unable to write kept sequences to: " + out_kept,
+                               err_code);
+    }
+    removed_writer.join();
+    if (!removed_ok) {
+        throw ExceptionHandler("Unable to write removed sequences to: " + out_removed,
+                               err_code);
+    }
+    FS_dprint("File successfully filtered. Outputs at:\n" + out_kept + " and:\n" + out_removed);
+
+    //-----------------------STATISTICS-----------------------//
+    FS_dprint("Beginning to calculate statistics...");
+    _pFileSystem->format_stat_stream(out_msg, "Expression Filtering (" + software_name + ") with FPKM Cutoff " + float_to_string(_fpkm));
+    out_msg <<
+            "Total sequences kept: "        << count_kept     <<
+            "\nTotal sequences removed: "   << count_removed  <<std::endl;
+
+
+    if (count_kept > 0) {
+        rejected_percent = ((fp32)count_removed / count_total) * 100;
+        avg_kept = (fp32) total_kept_len / count_kept;
+        kept_n = _pQUERY_DATA->calculate_N_vals(all_kept_lengths, total_kept_len);
+        _pFileSystem->format_stat_stream(out_msg, "Expression Filtering: New Reference Transcriptome Statistics");
+        out_msg <<
+                "\nTotal sequences: "                   << count_kept     <<
+                "\nTotal length of transcriptome (bp): "<< total_kept_len <<
+                "\nAverage length (bp): "               << avg_kept       <<
+                "\nn50: "                               << kept_n.first   <<
+                "\nn90: "                               << kept_n.second  <<
+                "\nLongest sequence (bp): " << max_selected << " (" << max_kept_seq << ")" <<
+                "\nShortest sequence (bp): "<< min_selected << " (" << min_kept_seq << ")\n";
+    } else {
+        throw ExceptionHandler("Error in filtering transcriptome, no sequences kept",
+                               err_code);
+    }
+
+    if (count_removed > 0) {
+        avg_removed = (fp32) total_removed_len / count_removed;
+        std::pair<uint64, uint64> removed_n =
+                _pQUERY_DATA->calculate_N_vals(all_lost_lengths,total_removed_len);
+        out_msg <<
+                "\nRemoved Sequences (under FPKM threshold):"       <<
+                "\nTotal sequences: "                     << count_removed    <<
+                "\nAverage sequence length(bp): "         << avg_removed      <<
+                "\nn50: "                                 << removed_n.first  <<
+                "\nn90: "                                 << removed_n.second <<
+                "\nLongest sequence(bp): "  << max_removed<< " (" << max_removed_seq << ")" <<
+                "\nShortest sequence(bp): " << min_removed<< " (" << min_removed_seq << ")" <<"\n";
+
+        if (rejected_percent > REJECTED_ERROR_CUTOFF) {
+            // Warn user high percentage of transcriptome was rejected
+            out_msg << "\nWARNING: A high percentage of the transcriptome was removed: " << rejected_percent;
+        }
+    } else {
+        out_msg << "\nWARNING: No sequences were removed from Expression Filtering";
+    }
+
+    out_str = out_msg.str();
+    _pFileSystem->print_stats(out_str);
+    file_fig_box.close();
+    FS_dprint("Success!");
+    //--------------------------------------------------------//
+
+
+    //------------------------Graphing------------------------//
+    FS_dprint("Beginning to send data to graphing manager...");
+    graphingStruct.text_file_path   = fig_txt_box_path;
+    graphingStruct.graph_title      = GRAPH_TITLE_BOX_PLOT;
+    graphingStruct.fig_out_path     = fig_png_box_path;
+    graphingStruct.software_flag    = GRAPH_EXPRESSION_FLAG;
+    graphingStruct.graph_type       = GRAPH_BOX_FLAG;
+    _pGraphingManager->graph(graphingStruct);
+    FS_dprint("Success!");
+    //--------------------------------------------------------//
+
+    _final_fasta = out_kept;
+}
+
+
+/**
+ * ======================================================================
+ * Function bool AbstractExpression::split_results_row(const char *begin, const char *end,
+ *                                 RESULTS_FIELD *fields)
+ *
+ * Description          - Splits a tab delimited expression results row into its
+ *                        columns in place, trimming surrounding spaces
+ *
+ * Notes                - None
+ *
+ * @param begin         - Start of row
+ * @param end           - End of row (newline excluded)
+ * @param fields        - Output, RESULTS_COL_NUM column ranges
+ *
+ * @return              - False if row has the wrong number of columns
+ *
+ * =====================================================================
+ */
+bool AbstractExpression::split_results_row(const char *begin, const char *end, RESULTS_FIELD *fields) {
+    const char *col_end;
+    const char *col_start;
+
+    for (int col = 0; col < RESULTS_COL_NUM; col++) {
+        col_end = static_cast<const char*>(memchr(begin, '\t', end - begin));
+        if (col_end == nullptr) {
+            if (col != RESULTS_COL_NUM - 1) return false;
+            col_end = end;
+        } else if (col == RESULTS_COL_NUM - 1) {
+            return false;
+        }
+        col_start = begin;
+        fields[col].second = col_end;
+        while (col_start < col_end && *col_start == ' ') col_start++;
+        while (fields[col].second > col_start && fields[col].second[-1] == ' ') fields[col].second--;
+        fields[col].first = col_start;
+        begin = col_end + 1;
+    }
+    return true;
+}
+
+
+// Converts a bounded decimal field without copying it to a string, false if not fully numeric
+bool AbstractExpression::parse_fp32(const char *begin, const char *end, fp32 &val) {
+    char  buffer[RESULTS_NUM_MAX_LEN + 1];
+    char *num_end;
+    uint64 len = (uint64) (end - begin);
+
+    if (len == 0 || len > RESULTS_NUM_MAX_LEN) return false;
+    memcpy(buffer, begin, len);
+    buffer[len] = '\0';
+    val = strtof(buffer, &num_end);
+    return num_end == buffer + len;
+}
+
+
+/**
+ * ======================================================================
+ * Function bool AbstractExpression::write_sequences(const std::string &path,
+ *                                       const std::vector<QuerySequence*> &sequences)
+ *
+ * Description          - Writes sequences to a FASTA file through a
+ *                        single buffered writer
+ *
+ * Notes                - Called from the writer thread for removed
+ *                        sequences, must not throw
+ *
+ * @param path          - Output FASTA path, appended to
+ * @param sequences     - Sequences in results file order
+ *
+ * @return              - True if every record was written
+ *
+ * =====================================================================
+ */
+bool AbstractExpression::write_sequences(const std::string &path, const std::vector<QuerySequence*> &sequences) {
+    OutputWriter writer;
+
+    if (!writer.open(path, true)) return false;
+    for (QuerySequence *querySequence : sequences) {
+        writer.write(querySequence->get_sequence());
+        writer.write("\n", 1);
+    }
+    return writer.close();
+}
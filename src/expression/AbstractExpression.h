@@ -34,6 +34,8 @@
 #include "../EntapModule.h"
 #include "../GraphingManager.h"
 
+class QuerySequence;
+
 //**************************************************************
 
 
@@ -98,8 +100,35 @@ public:
 
 
 protected:
+    const std::string EXP_OUT_KEPT          = "_kept.fasta";
+    const std::string EXP_OUT_REMOVED       = "_removed.fasta";
+    const std::string GRAPH_TXT_BOX_PLOT    = "comparison_box.txt";
+    const std::string GRAPH_PNG_BOX_PLOT    = "comparison_box.png";
+    const std::string GRAPH_TITLE_BOX_PLOT  = "Expression_Analysis";
+    const std::string GRAPH_REJECTED_FLAG   = "Removed";
+    const std::string GRAPH_KEPT_FLAG       = "Selected";
+    const fp32 REJECTED_ERROR_CUTOFF        = 75.0;
+
+    const unsigned char GRAPH_EXPRESSION_FLAG = 2;
+    const unsigned char GRAPH_BOX_FLAG        = 1;
+
+    // Results follow RSEM .genes.results: gene, transcript(s), length, eff. length, count, TPM, FPKM
+    static constexpr int RESULTS_COL_NUM  = 7;
+    static constexpr int RESULTS_COL_FPKM = 6;
+    static constexpr uint32 RESULTS_NUM_MAX_LEN = 63;     // Longest numeric field accepted
+
+    typedef std::pair<const char*, const char*> RESULTS_FIELD;  // Column range within a mapped row
+
     std::string     _alignpath;
     std::string     _final_fasta;
+    std::string     _filename;
+    fp32            _fpkm;
+    bool            _issingle;
+
+    void filter_transcriptome(const std::string &results_path, const std::string &software_name, int err_code);
+    bool split_results_row(const char *begin, const char *end, RESULTS_FIELD *fields);
+    static bool parse_fp32(const char *begin, const char *end, fp32 &val);
+    bool write_sequences(const std::string &path, const std::vector<QuerySequence*> &sequences);
 };
 
 #endif //ENTAP_ABSTRACTEXPRESSION_H
@@ -0,0 +1,509 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "ModEMQuant.h"
+#include "../QueryData.h"
+#include "../OutputWriter.h"
+#include <htslib/sam.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+//**************************************************************
+
+// Hash of a sorted transcript set, used to merge fragments into classes
+struct ClassHash {
+    size_t operator()(const std::vector<uint32> &members) const {
+        uint64 hash = 14695981039346656037ULL;
+        for (uint32 member : members) {
+            hash ^= member;
+            hash *= 1099511628211ULL;
+        }
+        return (size_t) hash;
+    }
+};
+
+// Counts are split across threads by class (E step) and by transcript (M step),
+// threads meet at a barrier between the two
+struct ModEMQuant::EmState {
+    uint32                          threads;
+    std::vector<std::vector<fp64>>  partials;   // Per thread expected counts of this iteration
+    std::vector<uint32>             changed;    // Per thread transcripts not yet converged
+    std::vector<uint32>             iterations; // Per thread, all threads agree
+    std::mutex                      lock;
+    std::condition_variable         released;
+    uint32                          waiting = 0;
+    uint64                          generation = 0;
+
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        uint64 current = generation;
+        if (++waiting == threads) {
+            waiting = 0;
+            generation++;
+            released.notify_all();
+        } else {
+            released.wait(guard, [&]() { return generation != current; });
+        }
+    }
+};
+
+
+ModEMQuant::ModEMQuant(std::string &execution_stage_path, std::string &in_hits, EntapDataPtrs &entap_data,
+                       std::string &exe, std::string &align) :
+AbstractExpression(execution_stage_path, in_hits, entap_data, "EM_Quant", exe, align){
+    FS_dprint("Spawn Object - ModEMQuant");
+
+    _fragments_aligned   = 0;
+    _fragments_unaligned = 0;
+    _mean_fragment       = 0;
+}
+
+ModEMQuant::~ModEMQuant() {
+    FS_dprint("Killing object - ModEMQuant");
+}
+
+
+/**
+ * ======================================================================
+ * Function EntapModule::ModVerifyData ModEMQuant::verify_files()
+ *
+ * Description          - Checks whether quantification was already run
+ *                        for this transcriptome
+ *
+ * Notes                - None
+ *
+ * @return              - ModVerifyData, files_exist if results were found
+ *
+ * =====================================================================
+ */
+EntapModule::ModVerifyData ModEMQuant::verify_files() {
+    ModVerifyData modVerifyData;
+
+    _filename = _pFileSystem->get_filename(_in_hits, false);
+    _em_out   = PATHS(_mod_out_dir, _filename) + EM_OUT_FILE;
+    if (_pFileSystem->file_exists(_em_out)) {
+        FS_dprint("File found at " + _em_out +  "\nmoving to filter transcriptome");
+        modVerifyData.files_exist = true;
+    } else {
+        FS_dprint("File not found at " + _em_out +  " Continuing EM quantification.");
+        modVerifyData.files_exist = false;
+    }
+    return modVerifyData;
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModEMQuant::execute()
+ *
+ * Description          - Quantifies expression from the user's SAM/BAM
+ *                      - Reads alignments once into compatibility
+ *                        classes, runs EM and writes the results file
+ *
+ * Notes                - Incorporates --single-end flag
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModEMQuant::execute() {
+    uint32 iterations;
+
+    FS_dprint("Running EM quantification...");
+    read_alignments();
+    FS_dprint("Fragments aligned: " + std::to_string(_fragments_aligned) +
+              ", unaligned: " + std::to_string(_fragments_unaligned) +
+              ", compatibility classes: " + std::to_string(_classes.size()) +
+              ", mean fragment length: " + float_to_string(_mean_fragment));
+    if (_fragments_aligned == 0) {
+        throw ExceptionHandler("No aligned fragments found in: " + _alignpath,
+                               ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+
+    set_effective_lengths();
+    iterations = run_em();
+    FS_dprint("EM finished after " + std::to_string(iterations) + " iterations");
+
+    write_results();
+    FS_dprint("Expression results written to: " + _em_out);
+}
+
+
+void ModEMQuant::parse() {
+    filter_transcriptome(_em_out, EM_SOFTWARE_NAME, ERR_ENTAP_RUN_EXPRESSION_EM);
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModEMQuant::read_alignments()
+ *
+ * Description          - Streams the SAM/BAM once, reducing each fragment
+ *                        to the sorted set of transcripts it aligns to
+ *                      - Fragments with the same set share a class
+ *
+ * Notes                - Paired-end fragments are taken from the first
+ *                        mate, its mate must align to the same transcript
+ *                      - Supplementary, QC failed and unmapped records
+ *                        are skipped, secondary alignments are kept
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModEMQuant::read_alignments() {
+    samFile            *in_file;
+    bam_hdr_t          *header;
+    bam1_t             *record;
+    int                 status;
+    uint16              flag;
+    bool                in_read=false;
+    uint64              fragment_len_total=0;
+    uint64              fragment_len_count=0;
+    std::string         read_name;
+    std::string         target_id;
+    std::vector<uint32> target_index;       // tid to transcript
+    std::vector<uint32> compatible;
+    std::vector<uint32> unique_fragments;   // Fragments aligning to a single transcript
+    std::unordered_map<std::string, uint32> transcript_index;
+    std::unordered_map<std::vector<uint32>, uint32, ClassHash> class_index;
+    QUERY_MAP_T        *MAP;
+
+    // Transcripts in ID order, same as the RSEM results
+    MAP = _pQUERY_DATA->get_sequences_ptr();
+    _transcripts.clear();
+    _transcripts.reserve(MAP->size());
+    for (auto &pair : *MAP) {
+        _transcripts.push_back({&pair.first, (uint64) pair.second->getSeq_length(), 0, 0});
+    }
+    std::sort(_transcripts.begin(), _transcripts.end(),
+              [](const EmTranscript &lhs, const EmTranscript &rhs) { return *lhs.id < *rhs.id; });
+    for (uint32 i = 0; i < _transcripts.size(); i++) transcript_index.emplace(*_transcripts[i].id, i);
+    unique_fragments.assign(_transcripts.size(), 0);
+
+    in_file = sam_open(_alignpath.c_str(), "r");
+    if (in_file == nullptr) {
+        throw ExceptionHandler("Unable to open alignment file: " + _alignpath, ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+    header = sam_hdr_read(in_file);
+    if (header == nullptr) {
+        sam_close(in_file);
+        throw ExceptionHandler("Unable to read header of alignment file: " + _alignpath,
+                               ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+    if (header->text != nullptr && strstr(header->text, "SO:coordinate") != nullptr) {
+        bam_hdr_destroy(header);
+        sam_close(in_file);
+        throw ExceptionHandler("Alignment file is sorted by coordinate: " + _alignpath + "\nAlignments of "
+                               "a read must be grouped together, sort by read name or use the aligner output",
+                               ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+
+    // Header references must match transcriptome headers, lengths are taken from the header
+    target_index.resize((uint64) header->n_targets);
+    for (int32 tid = 0; tid < header->n_targets; tid++) {
+        const char *name = header->target_name[tid];
+        _pQUERY_DATA->trim_sequence_id(name, name + strlen(name), target_id);
+        auto it = transcript_index.find(target_id);
+        if (it == transcript_index.end()) {
+            bam_hdr_destroy(header);
+            sam_close(in_file);
+            throw ExceptionHandler("Unable to find sequence: " + target_id + " there may be a discrepancy between"
+                                   " sequence headers in your transcriptome and headers in your BAM/SAM file. "
+                                   "Try trimming your sequence headers to the first space and re-running.",
+                                   ERR_ENTAP_RUN_EXPRESSION_EM);
+        }
+        target_index[tid] = it->second;
+        _transcripts[it->second].length = header->target_len[tid];
+    }
+
+    // Ends the current fragment, adding it to its class
+    auto end_fragment = [&]() {
+        if (compatible.empty()) {
+            _fragments_unaligned++;
+            return;
+        }
+        _fragments_aligned++;
+        std::sort(compatible.begin(), compatible.end());
+        compatible.erase(std::unique(compatible.begin(), compatible.end()), compatible.end());
+        if (compatible.size() == 1) {
+            unique_fragments[compatible[0]]++;
+        } else {
+            auto it = class_index.emplace(compatible, (uint32) _classes.size());
+            if (it.second) {
+                _classes.push_back({_class_members.size(), (uint32) compatible.size(), 0});
+                _class_members.insert(_class_members.end(), compatible.begin(), compatible.end());
+            }
+            _classes[it.first->second].fragments++;
+        }
+        compatible.clear();
+    };
+
+    record = bam_init1();
+    while ((status = sam_read1(in_file, header, record)) >= 0) {
+        const char *name = bam_get_qname(record);
+        if (!in_read || read_name != name) {
+            if (in_read) end_fragment();
+            read_name = name;
+            in_read = true;
+        }
+        flag = record->core.flag;
+        if ((flag & (BAM_FUNMAP | BAM_FSUPPLEMENTARY | BAM_FQCFAIL)) || record->core.tid < 0) continue;
+        if (!_issingle && (flag & BAM_FPAIRED)) {
+            if (flag & BAM_FREAD2) continue;
+            if ((flag & BAM_FMUNMAP) || record->core.mtid != record->core.tid) continue;
+            if (!(flag & BAM_FSECONDARY) && record->core.isize != 0) {
+                fragment_len_total += (uint64) std::abs(record->core.isize);
+                fragment_len_count++;
+            }
+        } else if (!(flag & BAM_FSECONDARY) && record->core.l_qseq > 0) {
+            fragment_len_total += (uint64) record->core.l_qseq;
+            fragment_len_count++;
+        }
+        compatible.push_back(target_index[record->core.tid]);
+    }
+    if (in_read) end_fragment();
+    bam_destroy1(record);
+    bam_hdr_destroy(header);
+    sam_close(in_file);
+    if (status < -1) {
+        throw ExceptionHandler("Alignment file is truncated or corrupt: " + _alignpath,
+                               ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+
+    // Single transcript classes
+    for (uint32 i = 0; i < unique_fragments.size(); i++) {
+        if (unique_fragments[i] == 0) continue;
+        _classes.push_back({_class_members.size(), 1, unique_fragments[i]});
+        _class_members.push_back(i);
+    }
+    _mean_fragment = fragment_len_count == 0 ? 0 : (fp64) fragment_len_total / fragment_len_count;
+}
+
+
+// Transcripts shorter than the mean fragment cannot produce fragments and are given 0
+void ModEMQuant::set_effective_lengths() {
+    for (EmTranscript &transcript : _transcripts) {
+        transcript.eff_length = (fp64) transcript.length - _mean_fragment + 1;
+        if (_mean_fragment == 0) transcript.eff_length = (fp64) transcript.length;
+        if (transcript.eff_length < 1) transcript.eff_length = 0;
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function uint32 ModEMQuant::run_em()
+ *
+ * Description          - Estimates expected fragments per transcript
+ *                      - Each class splits its fragments between members
+ *                        by abundance / effective length until counts
+ *                        stop changing
+ *
+ * Notes                - Same convergence rule as kallisto: stops once no
+ *                        count above EM_CHANGE_LIMIT moves by more than
+ *                        EM_CHANGE relative
+ *
+ * @return              - Iterations run
+ *
+ * =====================================================================
+ */
+uint32 ModEMQuant::run_em() {
+    EmState                  state;
+    uint32                   expressible=0;
+    std::vector<std::thread> workers;
+
+    // Start uniform over transcripts that can produce fragments
+    for (EmTranscript &transcript : _transcripts) {
+        if (transcript.eff_length > 0) expressible++;
+    }
+    for (EmTranscript &transcript : _transcripts) {
+        transcript.count = transcript.eff_length > 0 ? (fp64) _fragments_aligned / expressible : 0;
+    }
+
+    state.threads = (uint32) std::min<uint64>((uint64) std::max(_threads, 1),
+                                              _classes.size() / EM_CLASSES_PER_THREAD);
+    if (state.threads == 0) state.threads = 1;
+    state.partials.assign(state.threads, std::vector<fp64>(_transcripts.size(), 0));
+    state.changed.assign(state.threads, 0);
+    state.iterations.assign(state.threads, 0);
+    FS_dprint("Running EM with " + std::to_string(state.threads) + " thread(s)");
+
+    if (state.threads == 1) {
+        em_worker(0, state);
+    } else {
+        for (uint32 i = 0; i < state.threads; i++) {
+            workers.emplace_back(&ModEMQuant::em_worker, this, i, std::ref(state));
+        }
+        for (std::thread &worker : workers) worker.join();
+    }
+
+    for (EmTranscript &transcript : _transcripts) {
+        if (transcript.count < EM_ZERO_LIMIT) transcript.count = 0;
+    }
+    return state.iterations[0];
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModEMQuant::em_worker(uint32 thread_id, EmState &state)
+ *
+ * Description          - One EM thread, owns a range of classes for the
+ *                        E step and a range of transcripts for the M step
+ *
+ * Notes                - Counts are only written in the M step, after
+ *                        every thread finished reading them
+ *
+ * @param thread_id     - Index of this thread
+ * @param state         - Shared EM state
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModEMQuant::em_worker(uint32 thread_id, EmState &state) {
+    uint64              class_begin = _classes.size() * thread_id / state.threads;
+    uint64              class_end   = _classes.size() * (thread_id + 1) / state.threads;
+    uint64              trans_begin = _transcripts.size() * thread_id / state.threads;
+    uint64              trans_end   = _transcripts.size() * (thread_id + 1) / state.threads;
+    uint32              changed;
+    uint32              total_changed;
+    uint32             &iterations = state.iterations[thread_id];
+    fp64                denom;
+    fp64                sum;
+    std::vector<fp64>  &partial = state.partials[thread_id];
+
+    while (true) {
+        // E step, split each class between its members
+        for (uint64 c = class_begin; c < class_end; c++) {
+            const EmClass &em_class = _classes[c];
+            const uint32  *members  = &_class_members[em_class.offset];
+            denom = 0;
+            for (uint32 i = 0; i < em_class.size; i++) {
+                const EmTranscript &transcript = _transcripts[members[i]];
+                if (transcript.eff_length > 0) denom += transcript.count / transcript.eff_length;
+            }
+            if (denom <= 0) continue;
+            for (uint32 i = 0; i < em_class.size; i++) {
+                const EmTranscript &transcript = _transcripts[members[i]];
+                if (transcript.eff_length > 0) {
+                    partial[members[i]] += em_class.fragments * (transcript.count / transcript.eff_length) / denom;
+                }
+            }
+        }
+        state.wait();
+
+        // M step, gather counts for this thread's transcripts
+        changed = 0;
+        for (uint64 t = trans_begin; t < trans_end; t++) {
+            sum = 0;
+            for (std::vector<fp64> &thread_partial : state.partials) {
+                sum += thread_partial[t];
+                thread_partial[t] = 0;
+            }
+            if (sum > EM_CHANGE_LIMIT && std::fabs(sum - _transcripts[t].count) / sum > EM_CHANGE) changed++;
+            _transcripts[t].count = sum;
+        }
+        state.changed[thread_id] = changed;
+        state.wait();
+
+        // Every thread reaches the same decision
+        iterations++;
+        total_changed = 0;
+        for (uint32 thread_changed : state.changed) total_changed += thread_changed;
+        if ((iterations >= EM_MIN_ITERATIONS && total_changed == 0) || iterations >= EM_MAX_ITERATIONS) break;
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModEMQuant::write_results()
+ *
+ * Description          - Writes expected counts, TPM and FPKM in the RSEM
+ *                        .genes.results layout
+ *
+ * Notes                - Written to a temporary file first so an
+ *                        interrupted run is not picked up on restart
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModEMQuant::write_results() {
+    fp64         total_count=0;
+    fp64         total_rate=0;
+    fp64         tpm;
+    fp64         fpkm;
+    char         numbers[128];
+    std::string  tmp_path;
+    std::string  row;
+    OutputWriter writer;
+
+    for (EmTranscript &transcript : _transcripts) {
+        if (transcript.eff_length <= 0) continue;
+        total_count += transcript.count;
+        total_rate  += transcript.count / transcript.eff_length;
+    }
+
+    tmp_path = _em_out + ".tmp";
+    if (!writer.open(tmp_path, false)) {
+        throw ExceptionHandler("Unable to open expression results: " + tmp_path, ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+    writer.write("gene_id\ttranscript_id(s)\tlength\teffective_length\texpected_count\tTPM\tFPKM\n");
+    for (EmTranscript &transcript : _transcripts) {
+        tpm  = 0;
+        fpkm = 0;
+        if (transcript.eff_length > 0 && total_rate > 0) {
+            tpm  = transcript.count / transcript.eff_length / total_rate * 1e6;
+            fpkm = transcript.count / transcript.eff_length / total_count * 1e9;
+        }
+        snprintf(numbers, sizeof(numbers), "\t%lu\t%.2f\t%.2f\t%.2f\t%.2f\n",
+                 (unsigned long) transcript.length, transcript.eff_length, transcript.count, tpm, fpkm);
+        row = *transcript.id;
+        row += '\t';
+        row += *transcript.id;
+        row += numbers;
+        writer.write(row);
+    }
+    if (!writer.close() || !_pFileSystem->rename_file(tmp_path, _em_out)) {
+        throw ExceptionHandler("Unable to write expression results: " + _em_out, ERR_ENTAP_RUN_EXPRESSION_EM);
+    }
+}
+
+
+void ModEMQuant::set_data(int thread, float fpkm, bool single) {
+    _threads = thread;
+    _fpkm = fpkm;
+    _issingle = single;
+}
+
+std::string ModEMQuant::get_final_fasta() {
+    return this->_final_fasta;
+}
@@ -0,0 +1,109 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ENTAP_MODEMQUANT_H
+#define ENTAP_MODEMQUANT_H
+
+//*********************** Includes *****************************
+#include "AbstractExpression.h"
+#include "../ExceptionHandler.h"
+#include "../FileSystem.h"
+#include "../QuerySequence.h"
+#include "../common.h"
+
+//**************************************************************
+
+/**
+ * Built in expression quantification, RSEM is not needed. The user's SAM/BAM
+ * is streamed once with htslib and every fragment is reduced to the set of
+ * transcripts it aligns to (its compatibility class). Abundances are then
+ * estimated with EM over the classes on worker threads, no reference is
+ * prepared.
+ *
+ * Results are written in the RSEM .genes.results layout so filtering,
+ * statistics and restarts behave the same as with RSEM.
+ *
+ * Alignments of a read must be grouped together (aligner output order),
+ * coordinate sorted files are rejected, as with RSEM.
+ */
+class ModEMQuant : public AbstractExpression {
+
+public:
+    ModEMQuant(std::string &execution_stage_path, std::string &in_hits,
+               EntapDataPtrs &entap_data, std::string &exe,
+               std::string &align);
+
+    ~ModEMQuant();
+
+    virtual ModVerifyData verify_files() override ;
+    virtual void execute() override ;
+    virtual void parse() override;
+    virtual void set_data(int, float, bool) override    ;
+
+    virtual std::string get_final_fasta() override ;
+
+private:
+    struct EmTranscript {
+        const std::string *id;
+        uint64      length;
+        fp64        eff_length;     // 0 if shorter than the mean fragment
+        fp64        count;          // Expected fragments
+    };
+
+    struct EmClass {
+        uint64      offset;         // First member in _class_members
+        uint32      size;
+        uint32      fragments;
+    };
+
+    const std::string EM_OUT_FILE           = ".genes.results";
+    const std::string EM_SOFTWARE_NAME      = "EnTAP EM";
+    static constexpr uint32 EM_MIN_ITERATIONS   = 50;
+    static constexpr uint32 EM_MAX_ITERATIONS   = 10000;
+    static constexpr fp64 EM_CHANGE_LIMIT       = 1e-2;     // Counts above this must converge
+    static constexpr fp64 EM_CHANGE             = 1e-2;     // Relative change counted as converged
+    static constexpr fp64 EM_ZERO_LIMIT         = 1e-8;     // Counts below this are reported as 0
+    static constexpr uint64 EM_CLASSES_PER_THREAD = 4096;   // Min classes worth a thread
+
+    std::string _em_out;
+    std::vector<EmTranscript> _transcripts;
+    std::vector<EmClass>      _classes;
+    std::vector<uint32>       _class_members;   // Transcript indices of each class
+    uint64                    _fragments_aligned;
+    uint64                    _fragments_unaligned;
+    fp64                      _mean_fragment;
+
+    struct EmState;                             // Shared by EM worker threads
+
+    void read_alignments();
+    void set_effective_lengths();
+    uint32 run_em();
+    void em_worker(uint32 thread_id, EmState &state);
+    void write_results();
+};
+
+
+#endif //ENTAP_MODEMQUANT_H
@@ -123,209 +123,18 @@ void ModRSEM::execute() {
 
 /**
  * ======================================================================
- * Function std::string ModRSEM::filter(std::map<std::string, QuerySequence> & MAP)
+ * Function void ModRSEM::parse()
  *
- * Description          - Handles filtering of transcriptome based on
- *                        user selected FPKM threshold
- *                      - Updates master query sequence map
+ * Description          - Filters the transcriptome with the RSEM results
  *
  * Notes                - None
  *
- * @param MAP           - Master QuerySequence map
- *
- * @return              - Output path of sequences that were kept
+ * @return              - None
  *
  * =====================================================================
  */
 void ModRSEM::parse() {
-    FS_dprint("Beginning to filter transcriptome...");
-
-    uint32              count_removed=0;
-    uint32              count_kept=0;
-    uint32              count_total=0;      // Used to warn user if high percentage is removed
-    uint32              min_removed=0xFFFFFFFF;
-    uint32              min_selected=0xFFFFFFFF;
-    uint32              max_removed=0;
-    uint32              max_selected=0;
-    uint64              total_removed_len=0;
-    uint64              total_kept_len=0;
-    uint16              length;
-    fp32                in_len;
-    fp32                e_leng;
-    fp32                e_count;
-    fp32                tpm;
-    fp32                fpkm_val;
-    fp32                rejected_percent=0;
-    fp32                avg_removed;
-    fp32                avg_kept;
-    std::string         geneid;
-    std::string         transid;
-    std::string         out_str;
-    std::string         out_kept;
-    std::string         out_removed;
-    std::string         kept_filename;
-    std::string         original_filename;
-    std::string         removed_filename;
-    std::string         fig_txt_box_path;
-    std::string         fig_png_box_path;
-    std::string         min_kept_seq;
-    std::string         max_kept_seq;
-    std::string         max_removed_seq;
-    std::string         min_removed_seq;
-    std::stringstream   out_msg;
-    std::vector<uint16> all_kept_lengths;
-    std::vector<uint16> all_lost_lengths;
-    std::pair<uint64,uint64> kept_n;
-    GraphingData        graphingStruct;
-    QUERY_MAP_T         *MAP;
-
-    MAP = _pQUERY_DATA->get_sequences_ptr();
-
-    if (!_pFileSystem->file_exists(_rsem_out)) {
-        throw ExceptionHandler("File does not exist at: " + _rsem_out,
-                               ERR_ENTAP_RUN_RSEM_EXPRESSION);
-    }
-
-    // Setup figure files, directories already created
-    fig_txt_box_path = PATHS(_figure_dir, GRAPH_TXT_BOX_PLOT);
-    fig_png_box_path = PATHS(_figure_dir, GRAPH_PNG_BOX_PLOT);
-
-    // Open figure text file
-    std::ofstream file_fig_box(fig_txt_box_path, std::ios::out | std::ios::app);
-    file_fig_box << "flag\tsequence length" << std::endl;    // First line placeholder, not used
-
-    // Setup processed file paths, directories already created
-    original_filename = _filename;
-    removed_filename  = original_filename + RSEM_OUT_REMOVED;
-    kept_filename     = original_filename + RSEM_OUT_KEPT;
-    out_kept    = PATHS(_proc_dir, kept_filename);
-    out_removed = PATHS(_proc_dir, removed_filename);
-    std::ofstream out_file(out_kept, std::ios::out | std::ios::app);
-    std::ofstream removed_file(out_removed, std::ios::out | std::ios::app);
-
-    // Begin to iterate through RSEM output file
-    io::CSVReader<RSEM_COL_NUM, io::trim_chars<' '>,
-    io::no_quote_escape<'\t'>> in(_rsem_out);
-    in.next_line();
-    while (in.read_row(geneid, transid, in_len, e_leng, e_count, tpm, fpkm_val)) {
-        count_total++;
-        _pQUERY_DATA->trim_sequence_header(geneid,geneid);
-        QUERY_MAP_T::iterator it = MAP->find(geneid);
-        if (it == MAP->end()) {
-            throw ExceptionHandler("Unable to find sequence: " + geneid + " there may be a discrepancy between"
-                                                                          " sequence headers in your transcriptome and "
-                                                                          "headers in your BAM/SAM file. Try trimming"
-                                                                          " your sequence headers to the first space and re-running.",
-                                   ERR_ENTAP_RUN_RSEM_EXPRESSION_PARSE);
-        }
-        QuerySequence *querySequence = it->second;
-        querySequence->set_fpkm(fpkm_val);
-        length = (uint16)querySequence->getSeq_length();
-        if (fpkm_val > _fpkm) {
-            // Kept sequence
-            out_file << querySequence->get_sequence() << std::endl;
-            file_fig_box << GRAPH_KEPT_FLAG << '\t' << std::to_string(length) << std::endl;
-            //TODO move to QueryData
-            if (length < min_selected) {
-                min_selected = length;
-                min_kept_seq = geneid;
-            }
-            if (length > max_selected) {
-                max_selected = length;
-                max_kept_seq = geneid;
-            }
-            all_kept_lengths.push_back(length);
-            total_kept_len += length;
-            count_kept++;
-        } else {
-            // Removed sequence
-            querySequence->QUERY_FLAG_CLEAR(QuerySequence::QUERY_EXPRESSION_KEPT);
-            removed_file << querySequence->get_sequence() << std::endl;
-            file_fig_box << GRAPH_REJECTED_FLAG << '\t' << std::to_string(length) << std::endl;
-
-            if (length < min_removed) {
-                min_removed = length;
-                min_removed_seq = geneid;
-            }
-            if (length > max_removed) {
-                max_removed_seq = geneid;
-                max_removed = length;
-            }
-            all_lost_lengths.push_back(length);
-            total_removed_len += length;
-            count_removed++;
-        }
-    }
-    FS_dprint("File successfully filtered. Outputs at:\n" + out_kept + " and:\n" + out_removed);
-
-    //-----------------------STATISTICS-----------------------//
-    FS_dprint("Beginning to calculate statistics...");
-    _pFileSystem->format_stat_stream(out_msg, "Expression Filtering (RSEM) with FPKM Cutoff " + float_to_string(_fpkm));
-    out_msg <<
-            "Total sequences kept: "        << count_kept     <<
-            "\nTotal sequences removed: "   << count_removed  <<std::endl;
-
-
-    if (count_kept > 0) {
-        rejected_percent = ((fp32)count_removed / count_total) * 100;
-        avg_kept = (fp32) total_kept_len / count_kept;
-        kept_n = _pQUERY_DATA->calculate_N_vals(all_kept_lengths, total_kept_len);
-        _pFileSystem->format_stat_stream(out_msg, "Expression Filtering: New Reference Transcriptome Statistics");
-        out_msg <<
-                "\nTotal sequenes: "                    << count_kept     <<
-                "\nTotal length of transcriptome (bp)"  << total_kept_len <<
-                "\nAverage length (bp): "               << avg_kept       <<
-                "\nn50: "                               << kept_n.first   <<
-                "\nn90: "                               << kept_n.second  <<
-                "\nLongest sequence (bp): " << max_selected << " (" << max_kept_seq << ")" <<
-                "\nShortest sequence (bp): "<< min_selected << " (" << min_kept_seq << ")\n";
-    } else {
-        throw ExceptionHandler("Error in filtering transcriptome, no sequences kept",
-                               ERR_ENTAP_RUN_RSEM_EXPRESSION);
-    }
-
-    if (count_removed > 0) {
-        avg_removed = (fp32) total_removed_len / count_removed;
-        std::pair<uint64, uint64> removed_n =
-                _pQUERY_DATA->calculate_N_vals(all_lost_lengths,total_removed_len);
-        out_msg <<
-                "\nRemoved Sequences (under FPKM threshold):"       <<
-                "\nTotal sequences: "                     << count_removed    <<
-                "\nAverage sequence length(bp): "         << avg_removed      <<
-                "\nn50: "                                 << removed_n.first  <<
-                "\nn90: "                                 << removed_n.second <<
-                "\nLongest sequence(bp): "  << max_removed<< " (" << max_removed_seq << ")" <<
-                "\nShortest sequence(bp): " << min_removed<< " (" << min_removed_seq << ")" <<"\n";
-
-        if (rejected_percent > REJECTED_ERROR_CUTOFF) {
-            // Warn user high percentage of transcriptome was rejected
-            out_msg << "\nWARNING: A high percentage of the transcriptome was removed: " << rejected_percent;
-        }
-    } else {
-        out_msg << "\nWARNING: No sequences were removed from Expression Filtering";
-    }
-
-    out_str = out_msg.str();
-    _pFileSystem->print_stats(out_str);
-    out_file.close();
-    removed_file.close();
-    file_fig_box.close();
-    FS_dprint("Success!");
-    //--------------------------------------------------------//
-
-
-    //------------------------Graphing------------------------//
-    FS_dprint("Beginning to send data to graphing manager...");
-    graphingStruct.text_file_path   = fig_txt_box_path;
-    graphingStruct.graph_title      = GRAPH_TITLE_BOX_PLOT;
-    graphingStruct.fig_out_path     = fig_png_box_path;
-    graphingStruct.software_flag    = GRAPH_EXPRESSION_FLAG;
-    graphingStruct.graph_type       = GRAPH_BOX_FLAG;
-    _pGraphingManager->graph(graphingStruct);
-    FS_dprint("Success!");
-    //--------------------------------------------------------//
-
-    _final_fasta = out_kept;
+    filter_transcriptome(_rsem_out, "RSEM", ERR_ENTAP_RUN_RSEM_EXPRESSION_PARSE);
 }
 
 
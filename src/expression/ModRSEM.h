@@ -31,7 +31,6 @@
 
 //*********************** Includes *****************************
 #include "AbstractExpression.h"
-#include <csv.h>
 #include "../ExceptionHandler.h"
 #include "../GraphingManager.h"
 #include "../FileSystem.h"
@@ -62,30 +61,14 @@ private:
     const std::string RSEM_PREP_REF_EXE     = "rsem-prepare-reference";
     const std::string RSEM_CALC_EXP_EXE     = "rsem-calculate-expression";
     const std::string RSEM_CONV_SAM         = "convert-sam-for-rsem";
-    const std::string RSEM_OUT_KEPT         = "_kept.fasta";
-    const std::string RSEM_OUT_REMOVED      = "_removed.fasta";
     const std::string RSEM_OUT_FILE         = ".genes.results";
     const std::string STD_REF_OUT           = "_rsem_reference";
     const std::string STD_EXP_OUT           = "_rsem_exp";
     const std::string STD_VALID_OUT         = "_rsem_validate";
     const std::string STD_CONVERT_SAM       = "_rsem_convert";
-    const std::string GRAPH_TXT_BOX_PLOT    = "comparison_box.txt";
-    const std::string GRAPH_PNG_BOX_PLOT    = "comparison_box.png";
-    const std::string GRAPH_TITLE_BOX_PLOT  = "Expression_Analysis";
-    const std::string GRAPH_REJECTED_FLAG   = "Removed";
-    const std::string GRAPH_KEPT_FLAG       = "Selected";
-    const float REJECTED_ERROR_CUTOFF       = 75.0;
 
-    const unsigned char GRAPH_EXPRESSION_FLAG = 2;
-    const unsigned char GRAPH_BOX_FLAG        = 1;
-    static constexpr int RSEM_COL_NUM = 7;
-
-    std::string _filename;
     std::string _rsem_out;
     std::string _exp_out;
-    int         _threads;
-    float       _fpkm;
-    bool        _issingle;
 
     bool rsem_validate_file(std::string);
 #if 0
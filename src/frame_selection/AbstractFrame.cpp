@@ -25,7 +25,11 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+//*********************** Includes *****************************
 #include "AbstractFrame.h"
+#include "../ExceptionHandler.h"
+#include "../FileSystem.h"
+//**************************************************************
 
 AbstractFrame::AbstractFrame(std::string &execution_stage_path, std::string &in_hits,
                              EntapDataPtrs &entap_data, std::string module_name, std::string &exe)
@@ -33,4 +37,241 @@ AbstractFrame::AbstractFrame(std::string &execution_stage_path, std::string &in_
 
     _execution_state = FRAME_SELECTION;
 
-}
\ No newline at end of file
+}
+
+/**
+ * ======================================================================
+ * Function void AbstractFrame::write_frame_results(
+ *                          std::vector<QUERY_MAP_T::value_type*> &sequences,
+ *                          const std::string &software_name,
+ *                          const std::string &extra_output, int err_code)
+ *
+ * Description          - Writes complete/partial/internal/removed files,
+ *                        statistics and figures of frame selection
+ *
+ * Notes                - Modules set the sequences and frame of kept
+ *                        transcripts and clear QUERY_FRAME_KEPT of
+ *                        removed ones before calling
+ *
+ * @param sequences     - Transcripts that went through frame selection
+ * @param software_name - Module name for statistics
+ * @param extra_output  - Additional output files listed in statistics
+ * @param err_code      - Error code raised on failure
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void AbstractFrame::write_frame_results(std::vector<QUERY_MAP_T::value_type*> &sequences,
+                                        const std::string &software_name,
+                                        const std::string &extra_output, int err_code) {
+    std::string                             out_removed_path;
+    std::string                             out_internal_path;
+    std::string                             out_complete_path;
+    std::string                             out_partial_path;
+    std::string                             figure_results_path;
+    std::string                             figure_results_png;
+    std::string                             figure_removed_path;
+    std::string                             figure_removed_png;
+    std::string                             min_removed_seq;
+    std::string                             min_kept_seq;
+    std::string                             max_removed_seq;
+    std::string                             max_kept_seq;
+    std::stringstream                       stat_output;
+    std::map<std::string, std::ofstream*>   file_map_faa;
+    std::map<std::string, std::ofstream*>   file_map_fnn;
+    std::map<std::string, uint32>           count_map;
+    std::vector<uint16>                     all_kept_lengths;
+    std::vector<uint16>                     all_lost_lengths;
+    uint16                                  length;
+    fp32                                    avg_selected;
+    fp32                                    avg_lost;
+    std::pair<uint64, uint64>               kept_n;
+    GraphingData                            graphingStruct;
+
+    // Set up outpaths, directories are created by super
+    out_removed_path    = PATHS(_proc_dir, FRAME_SELECTION_LOST);
+    out_internal_path   = PATHS(_proc_dir, FRAME_SELECTION_INTERNAL);
+    out_complete_path   = PATHS(_proc_dir, FRAME_SELECTION_COMPLTE);
+    out_partial_path    = PATHS(_proc_dir, FRAME_SELECTION_PARTIAL);
+    figure_removed_path = PATHS(_figure_dir, GRAPH_TEXT_REF_COMPAR);
+    figure_removed_png  = PATHS(_figure_dir, GRAPH_FILE_REF_COMPAR);
+    figure_results_path = PATHS(_figure_dir, GRAPH_TEXT_FRAME_RESUTS);
+    figure_results_png  = PATHS(_figure_dir, GRAPH_FILE_FRAME_RESUTS);
+
+    // all nucleotide lengths
+    uint32 min_removed=0xFFFFFFFF;
+    uint32 min_selected=0xFFFFFFFF;
+    uint32 max_removed=0;
+    uint32 max_selected=0;
+    uint64 total_removed_len=0;
+    uint64 total_kept_len=0;
+
+    // Sequence count
+    uint32 count_selected=0;
+    uint32 count_removed=0;
+
+    std::ofstream file_figure_removed(figure_removed_path,std::ios::out | std::ios::app);
+    std::ofstream file_figure_results(figure_results_path,std::ios::out | std::ios::app);
+
+    file_figure_removed << "flag\tsequence length" << std::endl;    // First line placeholder, not used
+    file_figure_results << "flag\tsequence length" << std::endl;
+
+    // Partial 5' and 3' share files
+    file_map_faa[FRAME_SELECTION_INTERNAL_FLAG] =
+            new std::ofstream(out_internal_path+ FileSystem::EXT_FAA, std::ios::out | std::ios::app);
+    file_map_faa[FRAME_SELECTION_COMPLETE_FLAG] =
+            new std::ofstream(out_complete_path + FileSystem::EXT_FAA, std::ios::out | std::ios::app);
+    file_map_faa[FRAME_SELECTION_FIVE_FLAG] =
+            new std::ofstream(out_partial_path + FileSystem::EXT_FAA, std::ios::out | std::ios::app);
+    file_map_faa[FRAME_SELECTION_THREE_FLAG] = file_map_faa[FRAME_SELECTION_FIVE_FLAG];
+
+    file_map_fnn[FRAME_SELECTION_LOST_FLAG] =
+            new std::ofstream(out_removed_path + FileSystem::EXT_FNN, std::ios::out | std::ios::app);
+    file_map_fnn[FRAME_SELECTION_INTERNAL_FLAG] =
+            new std::ofstream(out_internal_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
+    file_map_fnn[FRAME_SELECTION_COMPLETE_FLAG] =
+            new std::ofstream(out_complete_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
+    file_map_fnn[FRAME_SELECTION_FIVE_FLAG] =
+            new std::ofstream(out_partial_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
+    file_map_fnn[FRAME_SELECTION_THREE_FLAG] = file_map_fnn[FRAME_SELECTION_FIVE_FLAG];
+
+    count_map ={
+            {FRAME_SELECTION_INTERNAL_FLAG,0 },
+            {FRAME_SELECTION_COMPLETE_FLAG,0 },
+            {FRAME_SELECTION_FIVE_FLAG    ,0 },
+            {FRAME_SELECTION_THREE_FLAG   ,0 },
+    };
+
+    for (QUERY_MAP_T::value_type *pair : sequences) {
+        QuerySequence *query = pair->second;
+
+        length = (uint16) query->getSeq_length();  // Nucleotide sequence length
+        if (query->QUERY_FLAG_GET(QuerySequence::QUERY_FRAME_KEPT)) {
+            // Kept sequence, either partial, complete, or internal
+            auto file_it   = file_map_faa.find(query->getFrame());
+            auto file_it_n = file_map_fnn.find(query->getFrame());
+            if (file_it == file_map_faa.end() || file_it_n == file_map_fnn.end()) {
+                throw ExceptionHandler("Unknown frame flag found: " + query->getFrame(), err_code);
+            }
+            count_selected++;
+            if (length < min_selected) {
+                min_selected = length;
+                min_kept_seq = pair->first;
+            }
+            if (length > max_selected) {
+                max_selected = length;
+                max_kept_seq = pair->first;
+            }
+            total_kept_len += length;
+            all_kept_lengths.push_back(length);
+            file_figure_removed << GRAPH_KEPT_FLAG << '\t' << std::to_string(length) << '\n';
+            *file_it->second   << query->get_sequence_p() << '\n';
+            *file_it_n->second << query->get_sequence_n() << '\n';
+            count_map[query->getFrame()]++;
+        } else {
+            // Lost sequence
+            count_removed++;
+            *file_map_fnn[FRAME_SELECTION_LOST_FLAG] << query->get_sequence_n() << '\n';
+
+            if (length < min_removed) {
+                min_removed = length;
+                min_removed_seq = pair->first;
+            }
+            if (length > max_removed) {
+                max_removed_seq = pair->first;
+                max_removed = length;
+            }
+            file_figure_removed << GRAPH_REJECTED_FLAG << '\t' << std::to_string(length) << '\n';
+            all_lost_lengths.push_back(length);
+            total_removed_len += length;
+        }
+    }
+
+    // Cleanup/close files
+    for(auto& pair : file_map_faa) {
+        if (pair.first != FRAME_SELECTION_THREE_FLAG) delete pair.second;
+    }
+    for(auto& pair : file_map_fnn) {
+        if (pair.first != FRAME_SELECTION_THREE_FLAG) delete pair.second;
+    }
+
+    // Ensure some sequences were kept and not all removed before we continue
+    if (count_selected == 0) {
+        throw ExceptionHandler("No sequences were kept after Frame Selection!", err_code);
+    }
+
+    // Calculate and print stats
+    FS_dprint("Beginning to calculate statistics...");
+    avg_selected = (fp32)total_kept_len / count_selected;
+    _pFileSystem->format_stat_stream(stat_output, "Frame Selected Transcripts (" + software_name + ")");
+    stat_output <<
+                "Total sequences frame selected: "      << count_selected          <<
+                "\n\tTranslated protein sequences: "    << get_final_faa()         <<
+                extra_output                                                       <<
+                "\nTotal sequences removed (no frame): "<< count_removed           <<
+                "\n\tFrame selected CDS removed: "      << out_removed_path        <<
+                "\nTotal of "                           <<
+                count_map[FRAME_SELECTION_FIVE_FLAG]    << " 5 prime partials and "<<
+                count_map[FRAME_SELECTION_THREE_FLAG]   << " 3 prime partials"     <<
+                "\n\tPartial CDS: "                     << out_partial_path        <<
+                "\nTotal of "                           <<
+                count_map[FRAME_SELECTION_COMPLETE_FLAG]<<" complete genes:\n\t" << out_complete_path<<
+                "\nTotal of "                           <<
+                count_map[FRAME_SELECTION_INTERNAL_FLAG]<<" internal genes:\n\t" << out_internal_path<<"\n\n";
+
+    _pFileSystem->format_stat_stream(stat_output, "Frame Selection: New Reference Transcriptome Statistics");
+
+    kept_n = _pQUERY_DATA->calculate_N_vals(all_kept_lengths,total_kept_len);
+    stat_output <<
+                "\nTotal sequences: "      << count_selected <<
+                "\nTotal length of transcriptome(bp): "      << total_kept_len <<
+                "\nAverage length(bp): "   << avg_selected   <<
+                "\nn50: "                  << kept_n.first   <<
+                "\nn90: "                  << kept_n.second  <<
+                "\nLongest sequence(bp): " << max_selected   << " (" << max_kept_seq << ")" <<
+                "\nShortest sequence(bp): "<< min_selected   << " (" << min_kept_seq << ")";
+
+    if (count_removed > 0) {
+        avg_lost     = (fp32)total_removed_len / count_removed;
+        std::pair<uint64, uint64> removed_n =
+                _pQUERY_DATA->calculate_N_vals(all_lost_lengths,total_removed_len);
+        stat_output <<
+                    "\n\nRemoved Sequences (no frame):"       <<
+                    "\nTotal sequences: "                     << count_removed    <<
+                    "\nAverage sequence length(bp): "         << avg_lost         <<
+                    "\nn50: "                                 << removed_n.first  <<
+                    "\nn90: "                                 << removed_n.second <<
+                    "\nLongest sequence(bp): "  << max_removed<< " (" << max_removed_seq << ")" <<
+                    "\nShortest sequence(bp): " << min_removed<< " (" << min_removed_seq << ")" <<"\n";
+    } else {
+        stat_output << "WARNING: No sequences were removed from Frame Selection";
+    }
+    std::string stat_out_msg = stat_output.str();
+    _pFileSystem->print_stats(stat_out_msg);
+    FS_dprint("Success!");
+
+    //---------------------- Figure handling ----------------------//
+    FS_dprint("Beginning figure handling...");
+    file_figure_results << GRAPH_REJECTED_FLAG           << '\t' << std::to_string(count_removed)   <<std::endl;
+    file_figure_results << FRAME_SELECTION_FIVE_FLAG     << '\t' << std::to_string(count_map[FRAME_SELECTION_FIVE_FLAG]) <<std::endl;
+    file_figure_results << FRAME_SELECTION_THREE_FLAG    << '\t' << std::to_string(count_map[FRAME_SELECTION_THREE_FLAG]) <<std::endl;
+    file_figure_results << FRAME_SELECTION_COMPLETE_FLAG << '\t' << std::to_string(count_map[FRAME_SELECTION_COMPLETE_FLAG])   <<std::endl;
+    file_figure_results << FRAME_SELECTION_INTERNAL_FLAG << '\t' << std::to_string(count_map[FRAME_SELECTION_INTERNAL_FLAG])   <<std::endl;
+    file_figure_results.close();
+    file_figure_removed.close();
+
+    graphingStruct.text_file_path = figure_results_path;
+    graphingStruct.graph_title    = GRAPH_TITLE_FRAME_RESULTS;
+    graphingStruct.fig_out_path   = figure_results_png;
+    graphingStruct.software_flag  = GRAPH_FRAME_FLAG;
+    graphingStruct.graph_type     = GRAPH_PIE_RESULTS_FLAG;
+    _pGraphingManager->graph(graphingStruct);
+
+    graphingStruct.text_file_path = figure_removed_path;
+    graphingStruct.graph_title    = GRAPH_TITLE_REF_COMPAR;
+    graphingStruct.fig_out_path   = figure_removed_png;
+    graphingStruct.graph_type     = GRAPH_COMP_BOX_FLAG;
+    _pGraphingManager->graph(graphingStruct);
+    FS_dprint("Success!");
+}
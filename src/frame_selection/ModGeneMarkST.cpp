@@ -205,29 +205,7 @@ void ModGeneMarkST::parse() {
     // generate maps, query->sequence
     FS_dprint("Beginning to calculate Genemark statistics...");
 
-    std::string                             out_removed_path;
-    std::string                             out_internal_path;
-    std::string                             out_complete_path;
-    std::string                             out_partial_path;
-    std::string                             figure_results_path;
-    std::string                             figure_results_png;
-    std::string                             figure_removed_path;
-    std::string                             figure_removed_png;
-    std::string                             min_removed_seq;
-    std::string                             min_kept_seq;
-    std::string                             max_removed_seq;
-    std::string                             max_kept_seq;
-    std::stringstream                       stat_output;
-    std::map<std::string, std::ofstream*>   file_map_faa;
-    std::map<std::string, std::ofstream*>   file_map_fnn;
-    std::map<std::string, uint32>           count_map;
-    std::vector<uint16>                     all_kept_lengths;
-    std::vector<uint16>                     all_lost_lengths;
-    uint16                                  length;
-    fp32                                    avg_selected;
-    fp32                                    avg_lost;
-    std::pair<uint64, uint64>               kept_n;
-    GraphingData                            graphingStruct;
+    std::vector<QUERY_MAP_T::value_type*>   sequences;
 
     // Ensure paths we need exist
     if (!_pFileSystem->file_exists(_final_faa_path)) {
@@ -241,28 +219,6 @@ void ModGeneMarkST::parse() {
                                ERR_ENTAP_RUN_GENEMARK_PARSE);
     }
 
-    // Set up outpaths, directories are created by super
-    out_removed_path    = PATHS(_proc_dir, FRAME_SELECTION_LOST);
-    out_internal_path   = PATHS(_proc_dir, FRAME_SELECTION_INTERNAL);
-    out_complete_path   = PATHS(_proc_dir, FRAME_SELECTION_COMPLTE);
-    out_partial_path    = PATHS(_proc_dir, FRAME_SELECTION_PARTIAL);
-    figure_removed_path = PATHS(_figure_dir, GRAPH_TEXT_REF_COMPAR);
-    figure_removed_png  = PATHS(_figure_dir, GRAPH_FILE_REF_COMPAR);
-    figure_results_path = PATHS(_figure_dir, GRAPH_TEXT_FRAME_RESUTS);
-    figure_results_png  = PATHS(_figure_dir, GRAPH_FILE_FRAME_RESUTS);
-
-    // all nucleotide lengths
-    uint32 min_removed=0xFFFFFFFF;
-    uint32 min_selected=0xFFFFFFFF;
-    uint32 max_removed=0;
-    uint32 max_selected=0;
-    uint64 total_removed_len=0;
-    uint64 total_kept_len=0;
-
-    // Sequence count
-    uint32 count_selected=0;
-    uint32 count_removed=0;
-
     try {
         // Parse protein file (.faa)
         std::map<std::string,frame_seq> protein_map = genemark_parse_fasta(_final_faa_path);
@@ -271,46 +227,12 @@ void ModGeneMarkST::parse() {
         // Parse lst file to get info for each sequence (partial, internal...)
         genemark_parse_lst(_final_lst_path,protein_map);
 
-        std::ofstream file_figure_removed(figure_removed_path,std::ios::out | std::ios::app);
-        std::ofstream file_figure_results(figure_results_path,std::ios::out | std::ios::app);
-
-        file_figure_removed << "flag\tsequence length" << std::endl;    // First line placeholder, not used
-        file_figure_results << "flag\tsequence length" << std::endl;
-
-
-        // Initialize protein output streams (will be moved/changed)
-        file_map_faa[FRAME_SELECTION_INTERNAL_FLAG] =
-                new std::ofstream(out_internal_path+ FileSystem::EXT_FAA, std::ios::out | std::ios::app);
-        file_map_faa[FRAME_SELECTION_COMPLETE_FLAG] =
-                new std::ofstream(out_complete_path + FileSystem::EXT_FAA, std::ios::out | std::ios::app);
-        file_map_faa[FRAME_SELECTION_FIVE_FLAG] =
-                new std::ofstream(out_partial_path + FileSystem::EXT_FAA, std::ios::out | std::ios::app);
-        file_map_faa[FRAME_SELECTION_THREE_FLAG] = file_map_faa[FRAME_SELECTION_FIVE_FLAG];
-
-        // Initialize nucleotide output streams
-        file_map_fnn[FRAME_SELECTION_LOST_FLAG] =
-                new std::ofstream(out_removed_path + FileSystem::EXT_FNN, std::ios::out | std::ios::app);
-        file_map_fnn[FRAME_SELECTION_INTERNAL_FLAG] =
-                new std::ofstream(out_internal_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
-        file_map_fnn[FRAME_SELECTION_COMPLETE_FLAG] =
-                new std::ofstream(out_complete_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
-        file_map_fnn[FRAME_SELECTION_FIVE_FLAG] =
-                new std::ofstream(out_partial_path+ FileSystem::EXT_FNN, std::ios::out | std::ios::app);
-        file_map_fnn[FRAME_SELECTION_THREE_FLAG] = file_map_fnn[FRAME_SELECTION_FIVE_FLAG];
-
-        count_map ={
-                {FRAME_SELECTION_INTERNAL_FLAG,0 },
-                {FRAME_SELECTION_COMPLETE_FLAG,0 },
-                {FRAME_SELECTION_FIVE_FLAG    ,0 },
-                {FRAME_SELECTION_THREE_FLAG   ,0 },
-        };
-
         for (auto& pair : *_pQUERY_DATA->get_sequences_ptr()) {
             std::map<std::string,frame_seq>::iterator p_it = protein_map.find(pair.first);
             if (!pair.second->is_kept()) continue; // Skip seqs that were lost to expression
+            sequences.push_back(&pair);
             if (p_it != protein_map.end()) {
                 // Kept sequence, either partial, complete, or internal
-                count_selected++;
                 pair.second->set_sequence_p(p_it->second.sequence); // Sets isprotein flag
                 pair.second->setFrame(p_it->second.frame_type);
 
@@ -318,145 +240,13 @@ void ModGeneMarkST::parse() {
                 if (n_it != nucleotide_map.end()) {
                     pair.second->set_sequence_n(n_it->second.sequence);
                 }
-
-                length = (uint16) pair.second->getSeq_length();  // Nucleotide sequence length
-
-                if (length < min_selected) {
-                    min_selected = length;
-                    min_kept_seq = pair.first;
-                }
-                if (length > max_selected) {
-                    max_selected = length;
-                    max_kept_seq = pair.first;
-                }
-                total_kept_len += length;
-                all_kept_lengths.push_back(length);
-                file_figure_removed << GRAPH_KEPT_FLAG << '\t' << std::to_string(length) << std::endl;
-                std::map<std::string, std::ofstream*>::iterator file_it = file_map_faa.find(p_it->second.frame_type);
-                std::map<std::string, std::ofstream*>::iterator file_it_n = file_map_fnn.find(p_it->second.frame_type);
-                if (file_it != file_map_faa.end() && file_it_n != file_map_faa.end()) {
-                    *file_it->second << p_it->second.sequence << std::endl;
-                    *file_it_n->second << n_it->second.sequence << std::endl;
-                    count_map[p_it->second.frame_type]++;
-                } else {
-                    throw ExceptionHandler("Unknown frame flag found", ERR_ENTAP_RUN_GENEMARK_STATS);
-                }
-
             } else {
                 // Lost sequence
-                count_removed++;
                 pair.second->QUERY_FLAG_CLEAR(QuerySequence::QUERY_FRAME_KEPT);
-                *file_map_fnn[FRAME_SELECTION_LOST_FLAG] << pair.second->get_sequence_n() << std::endl;
-                length = (uint16) pair.second->getSeq_length();  // Nucleotide sequence length
-
-                if (length < min_removed) {
-                    min_removed = length;
-                    min_removed_seq = pair.first;
-                }
-                if (length > max_removed) {
-                    max_removed_seq = pair.first;
-                    max_removed = length;
-                }
-                file_figure_removed << GRAPH_REJECTED_FLAG << '\t' << std::to_string(length) << std::endl;
-                all_lost_lengths.push_back(length);
-                total_removed_len += length;
             }
         }
 
-        // Cleanup/close files
-        for(auto& pair : file_map_faa) {
-            if (pair.first.compare(FRAME_SELECTION_THREE_FLAG)!=0){
-                pair.second->close();
-                delete pair.second;
-                pair.second = 0;
-            }
-        }
-        for(auto& pair : file_map_fnn) {
-            if (pair.first.compare(FRAME_SELECTION_THREE_FLAG)!=0){
-                pair.second->close();
-                delete pair.second;
-                pair.second = 0;
-            }
-        }
-
-        // Ensure some sequences were kept and not all removed before we continue
-        if (count_selected == 0) {
-            throw ExceptionHandler("No sequences were kept after Frame Selection!",
-                ERR_ENTAP_RUN_GENEMARK_PARSE);
-        }
-
-        // Calculate and print stats
-        FS_dprint("Beginning to calculate statistics...");
-        avg_selected = (fp32)total_kept_len / count_selected;
-        _pFileSystem->format_stat_stream(stat_output, "Frame Selected Transcripts (GeneMarkS-T)");
-        stat_output <<
-                    "Total sequences frame selected: "      << count_selected          <<
-                    "\n\tTranslated protein sequences: "    << _final_faa_path              <<
-                    "\nTotal sequences removed (no frame): "<< count_removed           <<
-                    "\n\tFrame selected CDS removed: "      << out_removed_path        <<
-                    "\nTotal of "                           <<
-                    count_map[FRAME_SELECTION_FIVE_FLAG]    << " 5 prime partials and "<<
-                    count_map[FRAME_SELECTION_THREE_FLAG]   << " 3 prime partials"     <<
-                    "\n\tPartial CDS: "                     << out_partial_path        <<
-                    "\nTotal of "                           <<
-                    count_map[FRAME_SELECTION_COMPLETE_FLAG]<<" complete genes:\n\t" << out_complete_path<<
-                    "\nTotal of "                           <<
-                    count_map[FRAME_SELECTION_INTERNAL_FLAG]<<" internal genes:\n\t" << out_internal_path<<"\n\n";
-
-        _pFileSystem->format_stat_stream(stat_output, "Frame Selection: New Reference Transcriptome Statistics");
-
-        kept_n = _pQUERY_DATA->calculate_N_vals(all_kept_lengths,total_kept_len);
-        stat_output <<
-                    "\nTotal sequences: "      << count_selected <<
-                    "\nTotal length of transcriptome(bp): "      << total_kept_len <<
-                    "\nAverage length(bp): "   << avg_selected   <<
-                    "\nn50: "                  << kept_n.first   <<
-                    "\nn90: "                  << kept_n.second  <<
-                    "\nLongest sequence(bp): " << max_selected   << " (" << max_kept_seq << ")" <<
-                    "\nShortest sequence(bp): "<< min_selected   << " (" << min_kept_seq << ")";
-
-        if (count_removed > 0) {
-            avg_lost     = (fp32)total_removed_len / count_removed;
-            std::pair<uint64, uint64> removed_n =
-                    _pQUERY_DATA->calculate_N_vals(all_lost_lengths,total_removed_len);
-            stat_output <<
-                        "\n\nRemoved Sequences (no frame):"       <<
-                        "\nTotal sequences: "                     << count_removed    <<
-                        "\nAverage sequence length(bp): "         << avg_lost         <<
-                        "\nn50: "                                 << removed_n.first  <<
-                        "\nn90: "                                 << removed_n.second <<
-                        "\nLongest sequence(bp): "  << max_removed<< " (" << max_removed_seq << ")" <<
-                        "\nShortest sequence(bp): " << min_removed<< " (" << min_removed_seq << ")" <<"\n";
-        } else {
-            stat_output << "WARNING: No sequences were removed from Frame Selection";
-        }
-        std::string stat_out_msg = stat_output.str();
-        _pFileSystem->print_stats(stat_out_msg);
-        FS_dprint("Success!");
-
-        //---------------------- Figure handling ----------------------//
-        FS_dprint("Beginning figure handling...");
-        file_figure_results << GRAPH_REJECTED_FLAG           << '\t' << std::to_string(count_removed)   <<std::endl;
-        file_figure_results << FRAME_SELECTION_FIVE_FLAG     << '\t' << std::to_string(count_map[FRAME_SELECTION_FIVE_FLAG]) <<std::endl;
-        file_figure_results << FRAME_SELECTION_THREE_FLAG    << '\t' << std::to_string(count_map[FRAME_SELECTION_THREE_FLAG]) <<std::endl;
-        file_figure_results << FRAME_SELECTION_COMPLETE_FLAG << '\t' << std::to_string(count_map[FRAME_SELECTION_COMPLETE_FLAG])   <<std::endl;
-        file_figure_results << FRAME_SELECTION_INTERNAL_FLAG << '\t' << std::to_string(count_map[FRAME_SELECTION_INTERNAL_FLAG])   <<std::endl;
-
-        graphingStruct.text_file_path = figure_results_path;
-        graphingStruct.graph_title    = GRAPH_TITLE_FRAME_RESULTS;
-        graphingStruct.fig_out_path   = figure_results_png;
-        graphingStruct.software_flag  = GRAPH_FRAME_FLAG;
-        graphingStruct.graph_type     = GRAPH_PIE_RESULTS_FLAG;
-        _pGraphingManager->graph(graphingStruct);
-
-        graphingStruct.text_file_path = figure_removed_path;
-        graphingStruct.graph_title    = GRAPH_TITLE_REF_COMPAR;
-        graphingStruct.fig_out_path   = figure_removed_png;
-        graphingStruct.graph_type     = GRAPH_COMP_BOX_FLAG;
-        _pGraphingManager->graph(graphingStruct);
-        FS_dprint("Success!");
-        //-----------------------------------------------------------//
-
+        write_frame_results(sequences, "GeneMarkS-T", "", ERR_ENTAP_RUN_GENEMARK_PARSE);
     } catch (ExceptionHandler &e) {throw e;}
     FS_dprint("Success! Parsing complete");
 }
@@ -55,31 +55,9 @@ public:
 
 private:
 
-    const std::string GRAPH_TITLE_FRAME_RESULTS     = "Frame_Selection_ORFs";
-    const std::string GRAPH_FILE_FRAME_RESUTS       = "frame_results_pie.png";
-    const std::string GRAPH_TEXT_FRAME_RESUTS       = "frame_results_pie.txt";
-    const std::string GRAPH_TITLE_REF_COMPAR        = "Frame_Selected_Sequences";
-    const std::string GRAPH_FILE_REF_COMPAR         = "removed_comparison_box.png";
-    const std::string GRAPH_TEXT_REF_COMPAR         = "removed_comparison_box.txt";
-    const std::string GRAPH_REJECTED_FLAG           = "Removed";
-    const std::string GRAPH_KEPT_FLAG               = "Selected";
-
-    const uint8       GRAPH_FRAME_FLAG              = 1;    // Ensure these match with entap_graphing.py
-    const uint8       GRAPH_PIE_RESULTS_FLAG        = 1;
-    const uint8       GRAPH_COMP_BOX_FLAG           = 2;
-
     const std::string GENEMARK_LOG_FILE             = "gms.log";
     const std::string GENEMARK_HMM_FILE             = "GeneMark_hmm.mod";
     const std::string GENEMARK_STD_OUT              = "genemark_run";
-    const std::string FRAME_SELECTION_PARTIAL       = "partial_genes";
-    const std::string FRAME_SELECTION_COMPLTE       = "complete_genes";
-    const std::string FRAME_SELECTION_INTERNAL      = "internal_genes";
-    const std::string FRAME_SELECTION_LOST          = "sequences_removed";
-    const std::string FRAME_SELECTION_LOST_FLAG     = "lost";
-    const std::string FRAME_SELECTION_FIVE_FLAG     = "Partial 5 Prime";
-    const std::string FRAME_SELECTION_THREE_FLAG    = "Partial 3 Prime";
-    const std::string FRAME_SELECTION_COMPLETE_FLAG = "Complete";
-    const std::string FRAME_SELECTION_INTERNAL_FLAG = "Internal";
 
     std::string _final_faa_path;
     std::string _final_fnn_path;
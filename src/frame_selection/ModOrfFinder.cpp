@@ -0,0 +1,368 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include <atomic>
+#include <mutex>
+#include "ModOrfFinder.h"
+#include "../ExceptionHandler.h"
+#include "../FileSystem.h"
+//**************************************************************
+
+static const uint64 NO_START = ~0ULL;     // Segment has no ATG
+
+
+/**
+ * ======================================================================
+ * Function EntapModule::ModVerifyData ModOrfFinder::verify_files()
+ *
+ * Description           - ORFs are always called again, previous outputs
+ *                         are overwritten
+ *
+ * Notes                 - Calling ORFs in process is faster than reading
+ *                         a previous run back in
+ *
+ *
+ * @return               - ModVerifyData, files never exist
+ *
+ * =====================================================================
+ */
+EntapModule::ModVerifyData ModOrfFinder::verify_files() {
+    ModVerifyData modVerifyData;
+
+    FS_dprint("ORF Finder results are not reused, continuing with Frame Selection");
+    modVerifyData.files_exist  = false;
+    modVerifyData.output_paths = vect_str_t{_final_faa_path};
+    return modVerifyData;
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModOrfFinder::execute()
+ *
+ * Description          - Calls the longest ORF of every transcript kept
+ *                        so far and writes the frame selected protein,
+ *                        CDS and ORF table files
+ *
+ * Notes                - Transcripts are split into chunks pulled by
+ *                        worker threads, each chunk fills its own slots of
+ *                        the results so no locking is needed
+ *
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModOrfFinder::execute() {
+    std::atomic<uint64>      next_chunk(0);
+    std::vector<std::thread> workers;
+    std::mutex               error_lock;
+    std::string              error_msg;
+    uint64                   chunk_count;
+    uint32                   thread_count;
+
+    FS_dprint("Calling ORFs for transcriptome at: " + _in_hits);
+
+    _sequences.clear();
+    for (auto &pair : *_pQUERY_DATA->get_sequences_ptr()) {
+        if (pair.second->is_kept()) _sequences.push_back(&pair); // Skip seqs that were lost to expression
+    }
+    _orf_calls.assign(_sequences.size(), OrfCall());
+
+    chunk_count  = (_sequences.size() + ORF_CHUNK_SEQS - 1) / ORF_CHUNK_SEQS;
+    thread_count = (uint32) std::max<uint64>(1, std::min<uint64>((uint64) std::max(_threads, 1), chunk_count));
+
+    auto worker = [&]() {
+        uint64 begin;
+
+        try {
+            while ((begin = next_chunk++ * ORF_CHUNK_SEQS) < _sequences.size()) {
+                find_orfs(begin, std::min<uint64>(begin + ORF_CHUNK_SEQS, _sequences.size()));
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> lock(error_lock);
+            if (error_msg.empty()) error_msg = e.what();
+        }
+    };
+
+    for (uint32 i = 0; i < thread_count; i++) workers.emplace_back(worker);
+    for (std::thread &t : workers) t.join();
+
+    if (!error_msg.empty()) {
+        throw ExceptionHandler("Error calling ORFs for transcriptome at: " + _in_hits + "\n" + error_msg,
+                               ERR_ENTAP_RUN_ORF_FINDER);
+    }
+    FS_dprint("Success! ORFs called with " + std::to_string(thread_count) + " threads");
+
+    write_orfs();
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModOrfFinder::parse()
+ *
+ * Description          - Adds frame selected sequences to query data
+ *                      - Writes complete/partial/internal/removed files
+ *                        and calculates statistics
+ *
+ * Notes                - Same outputs and statistics as GeneMarkS-T
+ *
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModOrfFinder::parse() {
+    FS_dprint("Beginning to calculate ORF Finder statistics...");
+
+    std::string     sequence;
+
+    if (_orf_calls.size() != _sequences.size() || _sequences.empty()) {
+        throw ExceptionHandler("No ORF Finder results to parse for: " + _in_hits,
+                               ERR_ENTAP_RUN_ORF_FINDER);
+    }
+
+    for (uint64 i = 0; i < _sequences.size(); i++) {
+        const std::string &seq_id = _sequences[i]->first;
+        QuerySequence *query      = _sequences[i]->second;
+        OrfCall &call             = _orf_calls[i];
+
+        if (!call.protein.empty()) {
+            // Kept sequence, either partial, complete, or internal
+            sequence = ">" + seq_id + "\n" + call.protein;
+            query->set_sequence_p(sequence); // Sets isprotein flag
+            query->set_sequence_n(">" + seq_id + "\n" + call.cds);
+            query->setFrame(get_frame_flag(call));
+        } else {
+            // Lost sequence
+            query->QUERY_FLAG_CLEAR(QuerySequence::QUERY_FRAME_KEPT);
+        }
+    }
+
+    // Results now live in query data
+    _orf_calls.clear();
+    _orf_calls.shrink_to_fit();
+
+    write_frame_results(_sequences, "ORF Finder", "\n\tORF coordinates: " + _final_orf_path,
+                        ERR_ENTAP_RUN_ORF_FINDER);
+    FS_dprint("Success! Parsing complete");
+}
+
+
+// Calls ORFs for transcripts [begin, end), run on worker threads
+void ModOrfFinder::find_orfs(uint64 begin, uint64 end) {
+    for (uint64 i = begin; i < end; i++) {
+        if (!call_orf(_sequences[i]->second->get_sequence_n(), _orf_calls[i])) {
+            _orf_calls[i].protein.clear();
+        }
+    }
+}
+
+
+/**
+ * ======================================================================
+ * Function bool ModOrfFinder::call_orf(const std::string &record, OrfCall &call)
+ *
+ * Description          - Finds the longest ORF of a transcript over all
+ *                        six frames
+ *
+ * Notes                - Amino acid of every codon position is computed
+ *                        once per strand with CodonTranslator, frames and
+ *                        stop codons are read from it
+ *                      - ORFs begin at the first ATG after a stop codon,
+ *                        or at the first codon of the frame when there is
+ *                        no upstream stop (5' open unless that is ATG)
+ *                      - Ties keep the first ORF (forward strand, frame 1)
+ *
+ * @param record        - FASTA record (header included) of transcript
+ * @param call          - ORF found
+ *
+ * @return              - True if an ORF of at least MIN_ORF_LENGTH found
+ *
+ * =====================================================================
+ */
+bool ModOrfFinder::call_orf(const std::string &record, OrfCall &call) const {
+    static thread_local std::vector<uint8> strands[2];      // Forward, reverse complement codes
+    static thread_local std::vector<uint8> codons[2];       // Codon index of every position
+    static thread_local std::string        amino_acids[2];  // Amino acid of every position
+    uint64  seq_start;
+    uint64  len;
+    uint64  best_len   = 0;
+    uint64  best_begin = 0;
+    uint64  best_end   = 0;
+    uint8   best_strand = 0;
+    bool    best_open_5 = false;
+    bool    best_open_3 = false;
+
+    seq_start = record.find('\n');
+    if (seq_start == std::string::npos) return false;
+
+    len = _translator.encode(record.data() + seq_start + 1, record.size() - seq_start - 1, strands[0]);
+    if (len < MIN_ORF_LENGTH * 3) return false;
+    CodonTranslator::reverse_complement(strands[0], strands[1]);
+
+    for (uint8 strand = 0; strand < 2; strand++) {
+        std::vector<uint8> &codon = codons[strand];
+        std::string        &aa    = amino_acids[strand];
+
+        codon.resize(len - 2);
+        aa.resize(len - 2);
+        _translator.codon_indices(strands[strand].data(), len - 2, codon.data());
+        _translator.translate_codons(codon.data(), len - 2, &aa[0]);
+
+        // ORF [begin, end), end includes stop codon unless open_3
+        auto consider = [&](uint64 begin, uint64 end, bool open_seg, bool open_3) {
+            uint64 aa_len;
+
+            if (begin == NO_START || begin >= end) return;
+            aa_len = (end - begin) / 3 - (open_3 ? 0 : 1);
+            if (aa_len > best_len) {
+                best_len    = aa_len;
+                best_begin  = begin;
+                best_end    = end;
+                best_strand = strand;
+                best_open_5 = open_seg && codon[begin] != CodonTranslator::CODON_ATG;
+                best_open_3 = open_3;
+            }
+        };
+
+        for (uint64 frame = 0; frame < 3; frame++) {
+            uint64 segment = frame;         // First codon after last stop
+            uint64 start   = NO_START;      // First ATG of segment
+            bool   open_5  = true;          // No stop before segment
+            uint64 i;
+
+            for (i = frame; i + 3 <= len; i += 3) {
+                if (aa[i] == CodonTranslator::STOP_CHAR) {
+                    consider(open_5 ? segment : start, i + 3, open_5, false);
+                    segment = i + 3;
+                    start   = NO_START;
+                    open_5  = false;
+                } else if (start == NO_START && codon[i] == CodonTranslator::CODON_ATG) {
+                    start = i;
+                }
+            }
+            consider(open_5 ? segment : start, i, open_5, true);
+        }
+    }
+    if (best_len < MIN_ORF_LENGTH) return false;
+
+    const std::string &aa = amino_acids[best_strand];
+    call.protein.resize(best_len);
+    for (uint64 i = 0; i < best_len; i++) call.protein[i] = aa[best_begin + i * 3];
+    call.cds.resize(best_end - best_begin);
+    CodonTranslator::decode(strands[best_strand].data() + best_begin, best_end - best_begin, &call.cds[0]);
+    call.reverse = best_strand == 1;
+    call.start   = call.reverse ? len - best_end + 1 : best_begin + 1;
+    call.end     = call.reverse ? len - best_begin : best_end;
+    call.open_5  = best_open_5;
+    call.open_3  = best_open_3;
+    return true;
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModOrfFinder::write_orfs()
+ *
+ * Description          - Writes frame selected proteins (.faa), their CDS
+ *                        (.fnn) and a table of ORF coordinates
+ *
+ * Notes                - Transcripts without an ORF are left out
+ *
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModOrfFinder::write_orfs() {
+    FS_dprint("Writing ORF Finder results to: " + _mod_out_dir);
+
+    std::ofstream file_faa(_final_faa_path, std::ios::out | std::ios::trunc);
+    std::ofstream file_fnn(_final_fnn_path, std::ios::out | std::ios::trunc);
+    std::ofstream file_orf(_final_orf_path, std::ios::out | std::ios::trunc);
+
+    if (!file_faa.is_open() || !file_fnn.is_open() || !file_orf.is_open()) {
+        throw ExceptionHandler("Unable to open ORF Finder output files in: " + _mod_out_dir,
+                               ERR_ENTAP_RUN_ORF_FINDER);
+    }
+
+    file_orf << "query\tframe\tstrand\tstart\tend\tlength(aa)\n";
+    for (uint64 i = 0; i < _sequences.size(); i++) {
+        const std::string &seq_id = _sequences[i]->first;
+        OrfCall &call             = _orf_calls[i];
+
+        if (call.protein.empty()) continue;
+        file_faa << '>' << seq_id << '\n' << call.protein << '\n';
+        file_fnn << '>' << seq_id << '\n' << call.cds << '\n';
+        file_orf << seq_id                          << '\t' <<
+                    get_frame_flag(call)            << '\t' <<
+                    (call.reverse ? '-' : '+')      << '\t' <<
+                    call.start                      << '\t' <<
+                    call.end                        << '\t' <<
+                    call.protein.size()             << '\n';
+    }
+    file_faa.close();
+    file_fnn.close();
+    file_orf.close();
+    if (file_faa.fail() || file_fnn.fail() || file_orf.fail()) {
+        throw ExceptionHandler("Error writing ORF Finder output files in: " + _mod_out_dir,
+                               ERR_ENTAP_RUN_ORF_FINDER);
+    }
+    FS_dprint("Success!");
+}
+
+
+// Frame flag matching GeneMarkS-T lst classification
+const std::string &ModOrfFinder::get_frame_flag(const OrfCall &call) {
+    if (call.open_5 && call.open_3) return FRAME_SELECTION_INTERNAL_FLAG;
+    if (call.open_5) return FRAME_SELECTION_FIVE_FLAG;
+    if (call.open_3) return FRAME_SELECTION_THREE_FLAG;
+    return FRAME_SELECTION_COMPLETE_FLAG;
+}
+
+
+ModOrfFinder::~ModOrfFinder() {
+    FS_dprint("Killing object - ModOrfFinder");
+}
+
+
+ModOrfFinder::ModOrfFinder(std::string &execution_stage_path, std::string &in_hits,
+                           EntapDataPtrs &entap_data, std::string &exe) :
+    AbstractFrame(execution_stage_path, in_hits, entap_data, "ORF Finder", exe) {
+    _transcriptome_filename = _pFileSystem->get_filename(in_hits, true);
+
+    _final_faa_path = PATHS(_mod_out_dir, _transcriptome_filename) + FileSystem::EXT_FAA;
+    _final_fnn_path = PATHS(_mod_out_dir, _transcriptome_filename) + FileSystem::EXT_FNN;
+    _final_orf_path = PATHS(_mod_out_dir, _transcriptome_filename) + ORF_TABLE_EXT;
+}
+
+std::string ModOrfFinder::get_final_faa() {
+    return _final_faa_path;
+}
@@ -0,0 +1,91 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_MODORFFINDER_H
+#define ENTAP_MODORFFINDER_H
+
+
+#include "AbstractFrame.h"
+#include "../CodonTranslator.h"
+
+/**
+ * Built in frame selection. Each transcript is translated in all six frames
+ * and its longest open reading frame is selected, GeneMarkS-T is not needed.
+ * Transcripts are processed on worker threads, results are applied to the
+ * query data in the same order as the serial GeneMarkS-T parse.
+ *
+ * Translation uses the shared CodonTranslator kernel (standard code).
+ *
+ * ORFs are classified like GeneMarkS-T genes: no start codon (runs off the
+ * 5' end) is a 5' partial, no stop codon a 3' partial, both an internal.
+ */
+class ModOrfFinder : public AbstractFrame {
+
+public:
+    ModOrfFinder(std::string &execution_stage_path, std::string &in_hits,
+                 EntapDataPtrs &entap_data, std::string &exe);
+
+    ~ModOrfFinder();
+
+    virtual ModVerifyData verify_files() override ;
+    virtual void execute() override ;
+    virtual void parse() override ;
+
+    virtual std::string get_final_faa() override ;
+
+private:
+    // Longest ORF of a transcript, empty protein if none long enough
+    struct OrfCall {
+        std::string protein;        // Stop codon excluded
+        std::string cds;            // Stop codon included when present
+        uint64      start;          // 1-based, forward strand coordinates
+        uint64      end;
+        bool        reverse;
+        bool        open_5;         // No start codon
+        bool        open_3;         // No stop codon
+    };
+
+    static constexpr uint64 MIN_ORF_LENGTH  = 100;      // Amino acids
+    static constexpr uint32 ORF_CHUNK_SEQS  = 256;      // Transcripts per work item
+    const std::string ORF_TABLE_EXT         = ".orfs.tsv";
+
+    std::string _final_faa_path;
+    std::string _final_fnn_path;
+    std::string _final_orf_path;
+    std::string _transcriptome_filename;    // Filename of input transcriptome
+    CodonTranslator _translator;
+    std::vector<QUERY_MAP_T::value_type*> _sequences;  // Transcripts to frame select, map order
+    std::vector<OrfCall>                  _orf_calls;  // One per transcript
+
+    void find_orfs(uint64 begin, uint64 end);
+    void write_orfs();
+    const std::string &get_frame_flag(const OrfCall &call);
+    bool call_orf(const std::string &record, OrfCall &call) const;
+};
+
+
+#endif //ENTAP_MODORFFINDER_H
@@ -25,10 +25,12 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <csv.h>
 #include "ModEggnogDMND.h"
 #include "../database/EggnogDatabase.h"
 #include "../TerminalCommands.h"
 #include "../QueryAlignment.h"
+#include "../Instrumentation.h"
 
 const std::vector<ENTAP_HEADERS> ModEggnogDMND::DEFAULT_HEADERS = {
     ENTAP_HEADER_ONT_EGG_SEED_ORTHO,
@@ -160,7 +162,7 @@ void ModEggnogDMND::parse() {
 
             // Print progress to debug
             if (++sequence_ct % STATUS_UPDATE_HITS == 0) {
-                FS_dprint("Alignments parsed: " + std::to_string(sequence_ct));
+                FS_DPRINT_HOT("Alignments parsed: " + std::to_string(sequence_ct));
             }
 
             // Ensure we recognize the query sequence before continuing
@@ -184,6 +186,7 @@ void ModEggnogDMND::parse() {
 
         } // End WHILE in.read_row
 
+        Instrumentation::counter("rows_parsed.eggnog_dmnd") += sequence_ct;
         if (sequence_ct > 0) {
             FS_dprint("Success!");
             calculate_stats(stats_stream);
@@ -213,6 +216,9 @@ void ModEggnogDMND::calculate_stats(std::stringstream &stream) {
     GraphingData                        graphingStruct;
     EggnogDatabase    *eggnogDatabase;
     std::vector<ENTAP_HEADERS> output_headers;
+    std::vector<QuerySequence::EggnogResults*> eggnog_batch;
+    std::vector<QuerySequence*>         sequences;
+    std::vector<bool>                   sequence_hits;      // Output order, true if hit EggNOG
 
     uint64         ct_alignments=0;
     uint64         ct_no_alignment=0;
@@ -230,10 +236,29 @@ void ModEggnogDMND::calculate_stats(std::stringstream &stream) {
 
     // Generate EggNOG database
     eggnogDatabase = new EggnogDatabase(_pFileSystem, _pEntapDatabase, _pQUERY_DATA);
-    if (eggnogDatabase->open_sql(EGG_SQL_DB_PATH) != EggnogDatabase::ERR_EGG_OK) {
+    // Precompiled index (from configuration) is used in place of SQL if available
+    std::string index_path = EggnogDatabase::get_index_path(EGG_SQL_DB_PATH);
+    if (eggnogDatabase->open_index(index_path, EGG_SQL_DB_PATH) != EggnogDatabase::ERR_EGG_OK &&
+        eggnogDatabase->open_sql(EGG_SQL_DB_PATH) != EggnogDatabase::ERR_EGG_OK) {
         throw ExceptionHandler("Unable to open EggNOG SQL Database", ERR_ENTAP_PARSE_EGGNOG_DMND);
     }
 
+    // Resolve every best hit in bulk before printing (fewer SQL round trips)
+    for (auto &pair : *_pQUERY_DATA->get_sequences_ptr()) {
+        if (pair.second->hit_database(GENE_ONTOLOGY, _software_flag, EGG_DMND_PATH)) {
+            best_hit = pair.second->get_best_hit_alignment<EggnogDmndAlignment>
+                    (GENE_ONTOLOGY, _software_flag, EGG_DMND_PATH);
+            eggnog_batch.push_back(best_hit->get_results());
+        }
+    }
+    FS_dprint("Resolving EggNOG annotations for " + std::to_string(eggnog_batch.size()) + " alignments...");
+    {
+        Instrumentation::ScopedTimer timer("eggnog_lookup");
+        eggnogDatabase->get_eggnog_entries(eggnog_batch, (uint16) _threads);
+    }
+    Instrumentation::counter("db_lookups.eggnog") += eggnog_batch.size();
+    FS_dprint("Success!");
+
     // Output files
     std::string out_no_hits_base = PATHS(_proc_dir, FILENAME_OUT_UNANNOTATED);
     std::string out_hits_base    = PATHS(_proc_dir, FILENAME_OUT_ANNOTATED);
@@ -242,21 +267,21 @@ void ModEggnogDMND::calculate_stats(std::stringstream &stream) {
     _pQUERY_DATA->start_alignment_files(out_hits_base, output_headers, 0, _alignment_file_types);
 
     // Parse through all query sequences
-    for (auto &pair : *_pQUERY_DATA->get_sequences_ptr()) {
+    sequences = _pQUERY_DATA->get_output_order();
+    sequence_hits.resize(sequences.size());
+    for (uint64 i = 0; i < sequences.size(); i++) {
         // Check if each sequence is an eggnog alignment
-        if (pair.second->hit_database(GENE_ONTOLOGY, _software_flag, EGG_DMND_PATH)) {
+        if (sequences[i]->hit_database(GENE_ONTOLOGY, _software_flag, EGG_DMND_PATH)) {
             // Yes, hit EggNOG database
             ct_alignments++;
+            sequence_hits[i] = true;
 
-            best_hit = pair.second->get_best_hit_alignment<EggnogDmndAlignment>
+            best_hit = sequences[i]->get_best_hit_alignment<EggnogDmndAlignment>
                     (GENE_ONTOLOGY, _software_flag, EGG_DMND_PATH);
 
             eggnog_results = best_hit->get_results();
-            eggnogDatabase->get_eggnog_entry(eggnog_results);
             best_hit->refresh_headers();
 
-            _pQUERY_DATA->add_alignment_data(out_hits_base, pair.second, nullptr);
-
             //  Analyze Gene Ontology Stats
             if (!eggnog_results->parsed_go.empty()) {
                 ct_total_go_hits++;
@@ -286,13 +311,22 @@ void ModEggnogDMND::calculate_stats(std::stringstream &stream) {
         } else {
             // No, did not hit database
             ct_no_alignment++;
-            _pQUERY_DATA->add_alignment_data(out_no_hits_base, pair.second, nullptr);
+            sequence_hits[i] = false;
         }
     } // END FOR LOOP
 
-    // Close files
-    _pQUERY_DATA->end_alignment_files(out_hits_base);
-    _pQUERY_DATA->end_alignment_files(out_no_hits_base);
+    // Write annotated/unannotated files, formatted across threads
+    {
+        Instrumentation::ScopedTimer timer("output");
+        _pQUERY_DATA->write_alignment_rows(sequences.size(), [&](uint64 i) {
+            _pQUERY_DATA->add_alignment_data(sequence_hits[i] ? out_hits_base : out_no_hits_base,
+                                             sequences[i], nullptr);
+        });
+
+        // Close files
+        _pQUERY_DATA->end_alignment_files(out_hits_base);
+        _pQUERY_DATA->end_alignment_files(out_no_hits_base);
+    }
     delete eggnogDatabase;
 
     // Begin to print stats / files
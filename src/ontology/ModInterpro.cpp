@@ -27,10 +27,12 @@
 
 
 //*********************** Includes *****************************
-#include <csv.h>
 #include <iomanip>
+#include <thread>
 #include "ModInterpro.h"
 #include "../ExceptionHandler.h"
+#include "../FastaScanner.h"
+#include "../MappedFile.h"
 
 // Used for XML parsing
 #if 0
@@ -170,7 +172,7 @@ void ModInterpro::parse() {
     std::string                           path_no_hits_fnn;
     std::string                           path_hits_faa;
     std::string                           path_hits_fnn;
-    std::map<std::string,InterProData>    interpro_map;
+    std::unordered_map<QuerySequence*,InterProData> interpro_map;
     go_format_t                           go_terms_parsed;
     uint32                                count_hits=0;
     uint32                                count_no_hits=0;
@@ -207,7 +209,7 @@ void ModInterpro::parse() {
     QuerySequence::InterProResults interProResults;
     try {
         for (auto &pair : *_pQUERY_DATA->get_sequences_ptr()) {
-            std::map<std::string, InterProData>::iterator it = interpro_map.find(pair.first);
+            auto it = interpro_map.find(pair.second);
             if (it != interpro_map.end()) {
                 count_hits++;
 
@@ -341,120 +343,197 @@ std::map<std::string,ModInterpro::InterProData> ModInterpro::parse_xml(void) {
 
 /**
 * ======================================================================
-* Function std::map<std::string,ModInterpro::InterProData> ModInterpro::parse_tsv(void)
+* Function std::unordered_map<QuerySequence*,ModInterpro::InterProData> ModInterpro::parse_tsv(void)
 *
 * Description          - Parses nucleotide data from interpro and returns
 *                        parsed data map of BEST HITS according to E_value
+*                      - File is memory mapped and split into line aligned
+*                        ranges, each parsed on its own thread
 *
-* Notes                - None
+* Notes                - Shards are merged in file order so ties resolve
+*                        the same as a serial parse (last row wins)
 *
-* @return              - Map of parsed data keyed to sequence id
+* @return              - Map of parsed data keyed to query sequence
 *
 * =====================================================================
 */
-std::map<std::string,ModInterpro::InterProData> ModInterpro::parse_tsv(void) {
-    // Made them separate handles for xml vs tsv, can change though...might not need all info
-    InterProData                        interProData;
-    std::map<std::string,InterProData>  interpro_map;
-    std::string temp_file_path;
-    std::string query;
-    std::string md5;
-    std::string length;
-    std::string database;
-    std::string database_id;
-    std::string database_desc;
-    std::string start;
-    std::string stop;
-    fp64        eval;
-    std::string status;
-    std::string date;
-    std::string interpro_id;
-    std::string interpro_desc;
-    std::string go_terms;       // GO:43112|GO:43111 format
-    std::string pathways;       // KEGG: 00290+1.1.1.86|KEGG: 00770+1.1.1.86
-
-    temp_file_path = format_interpro();
-
-    io::CSVReader<INTERPRO_COL_NUM, io::trim_chars<' '>, io::no_quote_escape<'\t'>> in(temp_file_path);
-    while (in.read_row(query, md5, length, database, database_id, database_desc,
-                       start, stop, eval, status, date, interpro_id, interpro_desc,
-                       go_terms, pathways)) {
-        if (query.empty()) continue;
-
-        std::map<std::string,InterProData>::iterator it = interpro_map.find(query);
-        if (it != interpro_map.end() && it->second.eval < eval) continue;
-        // Current hit is better
-        if (!go_terms.empty() && go_terms.find('|') != std::string::npos) {
-            std::replace(go_terms.begin(), go_terms.end(), '|', ',');
+std::unordered_map<QuerySequence*,ModInterpro::InterProData> ModInterpro::parse_tsv(void) {
+    uint32                                       chunk_count;
+    MappedFile                                   in_file;
+    std::vector<const char*>                     chunk_bounds;
+    std::vector<std::unique_ptr<InterProShard>>  shards;
+    std::vector<std::thread>                     workers;
+    std::unordered_map<QuerySequence*,InterProData> interpro_map;
+
+    if (!in_file.open(_final_outpath)) {
+        throw ExceptionHandler("Unable to read InterProScan file: " + _final_outpath, ERR_ENTAP_PARSE_INTERPRO);
+    }
+
+    // Split into line aligned ranges, small files are not worth spawning threads for
+    chunk_count = (uint32) std::min<uint64>((uint64) std::max(_threads, 1), in_file.size() / PARSE_CHUNK_MIN);
+    if (chunk_count == 0) chunk_count = 1;
+    chunk_bounds = MappedFile::split_lines(in_file.data(), in_file.end(), chunk_count);
+    for (uint32 i = 0; i < chunk_count; i++) shards.emplace_back(new InterProShard());
+    FS_dprint("Parsing with " + std::to_string(chunk_count) + " thread(s)");
+
+    if (chunk_count == 1) {
+        parse_tsv_range(chunk_bounds[0], chunk_bounds[1], shards[0].get());
+    } else {
+        for (uint32 i = 0; i < chunk_count; i++) {
+            workers.emplace_back(&ModInterpro::parse_tsv_range, this, chunk_bounds[i], chunk_bounds[i+1],
+                                 shards[i].get());
+        }
+        for (std::thread &worker : workers) worker.join();
+    }
+    in_file.close();
+
+    // Report the first error in file order, then keep the best hit of each query
+    for (std::unique_ptr<InterProShard> &shard : shards) {
+        if (shard->error) std::rethrow_exception(shard->error);
+    }
+    interpro_map = std::move(shards[0]->hits);
+    for (uint32 i = 1; i < chunk_count; i++) {
+        for (auto &pair : shards[i]->hits) {
+            auto it = interpro_map.find(pair.first);
+            if (it == interpro_map.end()) {
+                interpro_map.emplace(pair.first, std::move(pair.second));
+            } else if (it->second.eval >= pair.second.eval) {
+                it->second = std::move(pair.second);
+            }
         }
+        shards[i].reset();
+    }
+    return interpro_map;
+}
+
 
-        if (_pQUERY_DATA->get_sequence(query) == nullptr) {
-            // InterProScan5 adds underscore to identifier
-            if (query.find_last_of('_') != std::string::npos) {
-                query = query.substr(0,query.find_last_of('_'));
-                // Check if query is good
-                if (_pQUERY_DATA->get_sequence(query) == nullptr) {
+/**
+* ======================================================================
+* Function void ModInterpro::parse_tsv_range(const char *begin, const char *end,
+*                                            InterProShard *shard)
+*
+* Description          - Parses a line aligned range of the InterProScan
+*                        TSV, keeping the best hit of each query
+*
+* Notes                - Short rows are accepted, missing columns are
+*                        empty (InterProScan drops trailing empty columns)
+*                      - Errors are stored in the shard, not thrown
+*
+* @param begin         - Start of range
+* @param end           - End of range
+* @param shard         - Output for this range
+*
+* @return              - None
+*
+* =====================================================================
+*/
+void ModInterpro::parse_tsv_range(const char *begin, const char *end, InterProShard *shard) {
+    const char     *pos = begin;
+    const char     *line_start;
+    const char     *line_end;
+    fp64            eval;
+    std::string     query;
+    INTERPRO_FIELD  fields[INTERPRO_COL_NUM];
+    QuerySequence  *sequence;
+
+    try {
+        while (pos < end) {
+            line_start = pos;
+            pos = FastaScanner::next_line(pos, end, line_end);
+            split_row(line_start, line_end, fields);
+            if (fields[INTERPRO_COL_QUERY].first == fields[INTERPRO_COL_QUERY].second) continue;
+
+            if (!parse_eval(fields[INTERPRO_COL_EVAL].first, fields[INTERPRO_COL_EVAL].second, eval)) {
+                throw ExceptionHandler("Invalid e-value in InterProScan file: " + _final_outpath +
+                    "\nLine: " + std::string(line_start, line_end), ERR_ENTAP_PARSE_INTERPRO);
+            }
+
+            query.assign(fields[INTERPRO_COL_QUERY].first, fields[INTERPRO_COL_QUERY].second);
+            sequence = _pQUERY_DATA->get_sequence(query);
+            if (sequence == nullptr) {
+                // InterProScan5 adds underscore to identifier
+                if (query.find_last_of('_') == std::string::npos) continue;
+                query.erase(query.find_last_of('_'));
+                sequence = _pQUERY_DATA->get_sequence(query);
+                if (sequence == nullptr) {
                     throw ExceptionHandler("InterPro Query: " + query + " not found in transcriptome!",
                                            ERR_ENTAP_PARSE_INTERPRO);
                 }
             }
-        }
 
-        interProData = {};
-        interProData.interID      = interpro_id;
-        interProData.interDesc    = interpro_desc;
-        interProData.databaseID   = database_id;
-        interProData.databasetype = database;
-        interProData.databaseDesc = database_desc;
-        interProData.pathways     = pathways;
-        interProData.go_terms     = go_terms;
-        interProData.eval         = eval;
-        interpro_map[query] = interProData;
+            // Current hit is better, or equal and later in the file
+            auto it = shard->hits.find(sequence);
+            if (it != shard->hits.end() && it->second.eval < eval) continue;
+            InterProData &interProData = shard->hits[sequence];
+            interProData.interID.assign(fields[INTERPRO_COL_INTER_ID].first, fields[INTERPRO_COL_INTER_ID].second);
+            interProData.interDesc.assign(fields[INTERPRO_COL_INTER_DESC].first, fields[INTERPRO_COL_INTER_DESC].second);
+            interProData.databaseID.assign(fields[INTERPRO_COL_DB_ID].first, fields[INTERPRO_COL_DB_ID].second);
+            interProData.databasetype.assign(fields[INTERPRO_COL_DB].first, fields[INTERPRO_COL_DB].second);
+            interProData.databaseDesc.assign(fields[INTERPRO_COL_DB_DESC].first, fields[INTERPRO_COL_DB_DESC].second);
+            interProData.pathways.assign(fields[INTERPRO_COL_PATHWAYS].first, fields[INTERPRO_COL_PATHWAYS].second);
+            interProData.go_terms.assign(fields[INTERPRO_COL_GO].first, fields[INTERPRO_COL_GO].second);
+            std::replace(interProData.go_terms.begin(), interProData.go_terms.end(), '|', ',');
+            interProData.eval = eval;
+        }
+    } catch (...) {
+        shard->error = std::current_exception();
     }
-
-    _pFileSystem->delete_file(temp_file_path);
-    return interpro_map;
 }
 
 
 /**
 * ======================================================================
-* Function std::string ModInterpro::format_interpro(void)
+* Function void ModInterpro::split_row(const char *begin, const char *end,
+*                                      INTERPRO_FIELD *fields)
 *
-* Description          - Formats tsv file to be read easier with current
-*                        lib (complains if tabs are not perfect)
-*                      - This will add in tabs to keep everything consistent
+* Description          - Splits a tab delimited InterProScan row in place,
+*                        trimming surrounding spaces
 *
+* Notes                - Missing trailing columns are left empty, columns
+*                        past INTERPRO_COL_NUM are ignored
 *
-* Notes                - None
+* @param begin         - Start of row
+* @param end           - End of row (newline excluded)
+* @param fields        - Output, INTERPRO_COL_NUM column ranges
 *
-* @return              - Path of temporary altered file
+* @return              - None
 *
 * =====================================================================
 */
-std::string ModInterpro::format_interpro(void) {
-    // Replace
-    std::string path_temp;
-    std::string line;
-    uint16      tab_ct;
-
-    path_temp = _final_outpath + "_temp";
-    _pFileSystem->delete_file(path_temp);
-    std::ifstream file_in(_final_outpath);
-    std::ofstream file_temp(path_temp, std::ios::out | std::ios::app);
-    while(std::getline(file_in, line)) {
-        if (line.empty()) continue;
-        file_temp << line;
-        tab_ct = (uint16)std::count(line.begin(), line.end(), '\t');
-        while (tab_ct < INTERPRO_COL_NUM - 1) {
-            file_temp<<'\t';
-            tab_ct++;
+void ModInterpro::split_row(const char *begin, const char *end, INTERPRO_FIELD *fields) {
+    const char *col_end;
+    const char *col_start;
+
+    for (int col = 0; col < INTERPRO_COL_NUM; col++) {
+        if (begin > end) {
+            fields[col].first = fields[col].second = end;
+            continue;
         }
-        file_temp << std::endl;
+        col_end = static_cast<const char*>(memchr(begin, '\t', end - begin));
+        if (col_end == nullptr) col_end = end;
+        col_start = begin;
+        fields[col].second = col_end;
+        while (col_start < col_end && *col_start == ' ') col_start++;
+        while (fields[col].second > col_start && fields[col].second[-1] == ' ') fields[col].second--;
+        fields[col].first = col_start;
+        begin = col_end + 1;
     }
-    file_in.close();
-    file_temp.close();
-    return path_temp;
+}
+
+
+// Missing e-values ("-" or empty) are read as 0, same as the previous CSV parse
+bool ModInterpro::parse_eval(const char *begin, const char *end, fp64 &val) {
+    char   buffer[INTERPRO_NUM_MAX_LEN + 1];
+    char  *num_end;
+    uint64 len = (uint64) (end - begin);
+
+    val = 0;
+    if (len == 0 || (len == 1 && *begin == '-')) return true;
+    if (len > INTERPRO_NUM_MAX_LEN) return false;
+    memcpy(buffer, begin, len);
+    buffer[len] = '\0';
+    val = strtod(buffer, &num_end);
+    return num_end == buffer + len;
 }
 
 ModInterpro::~ModInterpro() {
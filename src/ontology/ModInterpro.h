@@ -33,6 +33,7 @@
 #include "AbstractOntology.h"
 #include "../UserInput.h"
 #include "../QuerySequence.h"
+#include <memory>
 
 class ModInterpro : public AbstractOntology{
 
@@ -47,6 +48,11 @@ class ModInterpro : public AbstractOntology{
         fp64        eval;
     };
 
+    struct InterProShard {
+        std::unordered_map<QuerySequence*, InterProData> hits;    // Best hit per query
+        std::exception_ptr                               error;
+    };
+
 public:
     ~ModInterpro();
     ModInterpro(std::string &ont, std::string &in,
@@ -83,6 +89,19 @@ private:
     static const std::string INTERPRO_DEFAULT;
 
     static constexpr short INTERPRO_COL_NUM = 15;
+    static constexpr short INTERPRO_COL_QUERY      = 0;
+    static constexpr short INTERPRO_COL_DB         = 3;
+    static constexpr short INTERPRO_COL_DB_ID      = 4;
+    static constexpr short INTERPRO_COL_DB_DESC    = 5;
+    static constexpr short INTERPRO_COL_EVAL       = 8;
+    static constexpr short INTERPRO_COL_INTER_ID   = 11;
+    static constexpr short INTERPRO_COL_INTER_DESC = 12;
+    static constexpr short INTERPRO_COL_GO         = 13;
+    static constexpr short INTERPRO_COL_PATHWAYS   = 14;
+    static constexpr uint32 INTERPRO_NUM_MAX_LEN   = 63;                   // Longest e-value accepted
+    static constexpr uint64 PARSE_CHUNK_MIN        = 4 * 1024 * 1024;      // Min bytes per parse thread
+
+    typedef std::pair<const char*, const char*> INTERPRO_FIELD;   // Column range within a mapped row
 
     std::string XML_SIGNATURE = "signature";
     std::string XML_ENTRY     = "entry";
@@ -104,8 +123,10 @@ private:
 #if 0
     std::map<std::string,InterProData> parse_xml(void);
 #endif
-    std::map<std::string,InterProData> parse_tsv(void);
-    std::string format_interpro(void);
+    std::unordered_map<QuerySequence*,InterProData> parse_tsv(void);
+    void parse_tsv_range(const char *begin, const char *end, InterProShard *shard);
+    void split_row(const char *begin, const char *end, INTERPRO_FIELD *fields);
+    static bool parse_eval(const char *begin, const char *end, fp64 &val);
 };
 
 
@@ -31,7 +31,7 @@
 AbstractSimilaritySearch::AbstractSimilaritySearch(std::string &execution_stage_path, std::string &in_hits,
                                                    EntapDataPtrs &entap_data, std::string mod_name,
                                                    std::string &exe, vect_str_t &databases)
-    :EntapModule(execution_stage_path, in_hits, entap_data, mod_name, exe) {
+    :EntapModule(execution_stage_path, in_hits, entap_data, mod_name, exe), _tax_cache(TAX_CACHE_MAX) {
 
     _execution_state = SIMILARITY_SEARCH;
 
@@ -161,4 +161,43 @@ bool AbstractSimilaritySearch::is_uniprot_entry(std::string &sseqid, UniprotEntr
     accession = sseqid.substr(sseqid.rfind('|',sseqid.length())+1);     // Q9FJZ9
     entry = _pEntapDatabase->get_uniprot_entry(accession);
     return !entry.is_empty();
-}
\ No newline at end of file
+}
+
+
+/**
+ * ======================================================================
+ * Function void AbstractSimilaritySearch::get_taxonomy(std::string &species,
+ *                                          TaxEntry &tax_entry,
+ *                                          std::pair<bool, std::string> &contam_info)
+ *
+ * Description          - Resolves taxonomic and contaminant information
+ *                        of a species pulled from a hit title
+ *
+ * Notes                - Memoized, hit titles repeat the same species many
+ *                        times and SQL lookups walk up the name on a miss
+ *                      - Safe to call from multiple threads
+ *
+ * @param species       - Species from hit title, normalized on return
+ *                        the same way EntapDatabase::get_tax_entry does
+ * @param tax_entry     - Taxonomic information of species
+ * @param contam_info   - Whether species is a contaminant and which
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void AbstractSimilaritySearch::get_taxonomy(std::string &species, TaxEntry &tax_entry,
+                                            std::pair<bool, std::string> &contam_info) {
+    TaxonomyCacheEntry entry;
+
+    if (!_tax_cache.find(species, entry)) {
+        std::string raw_species = species;
+        entry.tax_entry   = _pEntapDatabase->get_tax_entry(species);
+        entry.species     = species;
+        entry.contam_info = is_contaminant(entry.tax_entry.lineage, _contaminants);
+        _tax_cache.insert(raw_species, entry);
+    }
+    species     = entry.species;
+    tax_entry   = entry.tax_entry;
+    contam_info = entry.contam_info;
+}
@@ -30,6 +30,7 @@
 
 
 #include "../EntapModule.h"
+#include "TaxonomyCache.h"
 
 class AbstractSimilaritySearch : public EntapModule{
 
@@ -51,6 +52,8 @@ public:
         fp32                tcoverage;      // target coverage
         uint16              top_num;        // default = 3
         uint16              output_flags;    // currently unused
+        const std::atomic<bool> *cancel = nullptr;  // Stops search when set
+        std::string         stage;          // Timing stage, set when run off the stage's thread
     };
 
     AbstractSimilaritySearch(std::string &execute_stage_path,
@@ -79,10 +82,12 @@ protected:
     fp64                            _e_val;
     fp32                            _qcoverage;
     fp32                            _tcoverage;
+    TaxonomyCache                   _tax_cache;             // Species lookups shared by parse threads
 
     const std::string BLASTX_STR           = "blastx";
     const std::string BLASTP_STR           = "blastp";
     const uint8       UNIPROT_ATTEMPTS     = 15;   // Number of attempts to see if database is uniprot
+    static constexpr uint64 TAX_CACHE_MAX  = 500000; // Max species held in taxonomy cache
     const std::string NCBI_REGEX          = "\\[(.+)\\](?!.+\\[.+\\])";
     const std::string UNIPROT_REGEX       = "OS=(.+?)\\s\\S\\S=";
 
@@ -92,6 +97,7 @@ protected:
     bool is_informative(std::string title, vect_str_t &uninformative_vect);
     std::string get_species(std::string &title);
     bool is_uniprot_entry(std::string &sseqid, UniprotEntry &entry);
+    void get_taxonomy(std::string &species, TaxEntry &tax_entry, std::pair<bool, std::string> &contam_info);
 };
 
 
@@ -25,10 +25,12 @@
  * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <csv.h>
 #include "ModDiamond.h"
 #include "../QuerySequence.h"
 #include "../QueryAlignment.h"
+#include "../FastaScanner.h"
+#include "../Instrumentation.h"
+#include "../OutputWriter.h"
 
 #ifdef USE_BOOST
 #include <boost/regex.hpp>
@@ -128,10 +130,40 @@ bool ModDiamond::is_executable(std::string &exe) {
     return TC_execute_cmd(terminalData) == 0;
 }
 
+/**
+ * ======================================================================
+ * Function void ModDiamond::execute()
+ *
+ * Description          - Runs DIAMOND against each database that does not
+ *                        already have output
+ *                      - Reports thread budget and achieved core
+ *                        utilization of the searches
+ *
+ * Notes                - Up to --search-jobs searches run at once, each
+ *                        with an even share of the threads. Leftover
+ *                        threads go to the first searches
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
 void ModDiamond::execute() {
     std::string output_path;
     uint16 file_status = 0;
+    int    search_jobs;
+    uint32 jobs;
+    uint32 total_threads;
+    uint16 search_threads;
+    fp64   wall_secs;
+    fp64   cpu_secs;
+    fp64   utilization;
     SimSearchCmd simSearchCmd;
+    std::vector<SimSearchCmd> search_cmds;
+    std::vector<uint16> job_threads;
+    struct rusage child_start;
+    struct rusage child_end;
+    std::stringstream ss;
+    std::chrono::steady_clock::time_point start_time;
 
     FS_dprint("Executing DIAMOND for necessary files....");
 
@@ -147,23 +179,130 @@ void ModDiamond::execute() {
             simSearchCmd.database_path = database_path;
             simSearchCmd.output_path   = output_path;
             simSearchCmd.std_out_path  = output_path + FileSystem::EXT_STD;
-            simSearchCmd.threads       = (uint16)_threads;
             simSearchCmd.query_path    = _in_hits;
             simSearchCmd.eval          = _e_val;
             simSearchCmd.tcoverage     = _tcoverage;
             simSearchCmd.qcoverage     = _qcoverage;
             simSearchCmd.exe_path      = _exe_path;
             simSearchCmd.blastp        = _blastp;
+            search_cmds.push_back(simSearchCmd);
+        }
+    }
+    if (search_cmds.empty()) return;
+
+    // Split thread budget between concurrent searches, leftover threads go to the first ones.
+    // Never run more searches at once than there are threads, each needs at least one
+    search_jobs = _pUserInput->get_user_input<int>(_pUserInput->INPUT_FLAG_SEARCH_JOBS);
+    jobs = (uint32) std::max(1, std::min({search_jobs, (int) search_cmds.size(), _threads}));
+    search_threads = (uint16) std::max(1, _threads / (int) jobs);
+    job_threads.assign(jobs, search_threads);
+    if (_threads > (int) jobs) {
+        for (uint32 i = 0; i < (uint32) _threads % jobs; i++) job_threads[i]++;
+    }
+    total_threads = 0;
+    for (uint16 threads : job_threads) total_threads += threads;
 
-            try {
-                run_blast(&simSearchCmd, true);
-            } catch (const ExceptionHandler &e ){
-                throw e;
-            }
+    FS_dprint("Running " + std::to_string(search_cmds.size()) + " DIAMOND searches, " +
+              std::to_string(jobs) + " at a time with " + std::to_string(total_threads) +
+              " threads between them");
+
+    getrusage(RUSAGE_CHILDREN, &child_start);
+    start_time = std::chrono::steady_clock::now();
+
+    run_searches(search_cmds, job_threads);
+
+    wall_secs = std::chrono::duration<fp64>(std::chrono::steady_clock::now() - start_time).count();
+    getrusage(RUSAGE_CHILDREN, &child_end);
+    cpu_secs = (child_end.ru_utime.tv_sec - child_start.ru_utime.tv_sec) +
+               (child_end.ru_utime.tv_usec - child_start.ru_utime.tv_usec) / 1e6 +
+               (child_end.ru_stime.tv_sec - child_start.ru_stime.tv_sec) +
+               (child_end.ru_stime.tv_usec - child_start.ru_stime.tv_usec) / 1e6;
+    utilization = wall_secs > 0 ? 100.0 * cpu_secs / (wall_secs * total_threads) : 0;
+
+    ss<<std::fixed<<std::setprecision(2);
+    _pFileSystem->format_stat_stream(ss, "Similarity Search - DIAMOND - Execution");
+    ss <<
+       "Searches run: "                   << search_cmds.size()   <<
+       "\n\tConcurrent searches: "          << jobs                 <<
+       "\n\tThreads per search: "           << search_threads       <<
+       (job_threads.front() != search_threads ? "-" + std::to_string(job_threads.front()) : "") <<
+       "\n\tWall time (s): "                << wall_secs            <<
+       "\n\tDIAMOND CPU time (s): "         << cpu_secs             <<
+       "\n\tCore utilization ("             << total_threads << " threads): " << utilization << "%";
+    std::string out_msg = ss.str() + "\n";
+    _pFileSystem->print_stats(out_msg);
+}
 
-            FS_dprint("Success! Results written to: " + output_path);
+/**
+ * ======================================================================
+ * Function void ModDiamond::run_searches(std::vector<SimSearchCmd> &cmds,
+ *                                        std::vector<uint16> &job_threads)
+ *
+ * Description          - Runs DIAMOND searches, one worker per entry of
+ *                        job_threads
+ *
+ * Notes                - Workers pull the next search as soon as theirs
+ *                        finishes, each search runs with its worker's
+ *                        threads
+ *                      - Searches are timed under the calling thread's
+ *                        stage, workers have no timers of their own
+ *                      - First failure cancels the searches still running
+ *                        (their partial output is removed) and is rethrown
+ *                        once all workers have stopped
+ *
+ * @param cmds          - Searches to run
+ * @param job_threads   - DIAMOND threads of each concurrent search
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModDiamond::run_searches(std::vector<SimSearchCmd> &cmds, std::vector<uint16> &job_threads) {
+    std::atomic<uint32>      next(0);
+    std::atomic<bool>        cancel(false);
+    std::exception_ptr       first_error;
+    std::mutex               error_lock;
+    std::vector<std::thread> workers;
+    std::string              stage = Instrumentation::current_stage();
+
+    if (job_threads.size() <= 1) {
+        for (SimSearchCmd &cmd : cmds) {
+            cmd.threads = job_threads.front();
+            run_blast(&cmd, true);
+            FS_dprint("Success! Results written to: " + cmd.output_path);
         }
+        return;
     }
+
+    for (SimSearchCmd &cmd : cmds) {
+        cmd.cancel = &cancel;
+        cmd.stage  = stage;
+    }
+    auto worker = [&](uint16 threads) {
+        uint32 index;
+
+        while ((index = next++) < cmds.size()) {
+            SimSearchCmd &cmd = cmds[index];
+
+            if (cancel) return;
+            cmd.threads = threads;
+            try {
+                run_blast(&cmd, true);
+                FS_dprint("Success! Results written to: " + cmd.output_path);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_lock);
+                // Later errors are usually searches we cancelled
+                if (!first_error) first_error = std::current_exception();
+                cancel = true;
+                return;
+            }
+        }
+    };
+
+    for (uint16 threads : job_threads) workers.emplace_back(worker, threads);
+    for (std::thread &t : workers) t.join();
+
+    if (first_error) std::rethrow_exception(first_error);
 }
 
 bool ModDiamond::run_blast(AbstractSimilaritySearch::SimSearchCmd *cmd, bool use_defaults) {
@@ -196,6 +335,8 @@ bool ModDiamond::run_blast(AbstractSimilaritySearch::SimSearchCmd *cmd, bool use
     terminalData.command        = diamond_cmd;
     terminalData.base_std_path  = cmd->std_out_path;
     terminalData.print_files    = true;
+    terminalData.cancel         = cmd->cancel;
+    terminalData.stage          = cmd->stage;
 
     err_code = TC_execute_cmd(terminalData);
 
@@ -210,22 +351,34 @@ bool ModDiamond::run_blast(AbstractSimilaritySearch::SimSearchCmd *cmd, bool use
     return ret;
 }
 
+/**
+ * ======================================================================
+ * Function void ModDiamond::parse()
+ *
+ * Description          - Parses each DIAMOND output file and adds the
+ *                        alignments to their query sequences
+ *                      - Calculates per database and overall statistics
+ *
+ * Notes                - Files are memory mapped and split on line
+ *                        boundaries, rows are enriched (species, taxonomy,
+ *                        contaminant, UniProt) on worker threads
+ *                      - Queries are partitioned across merge threads, each
+ *                        inserts its queries' hits in file order so results
+ *                        match a serial parse
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
 void ModDiamond::parse() {
-    bool                is_uniprot;
-    uint32              uniprot_attempts=0;
     uint16              file_status=0;
-    std::string         database_shortname;
-    std::string         species;
-    QuerySequence::SimSearchResults simSearchResults;
-    TaxEntry            taxEntry;
-    std::pair<bool, std::string> contam_info;
-
-    // ------------------ Read from DIAMOND output ---------------------- //
-    std::string qseqid, sseqid, stitle, database_name,pident, bitscore,
-            length, mismatch, gapopen, qstart, qend, sstart, send;
-    fp64  evalue, coverage;
-
-    // ----------------------------------------------------------------- //
+    uint32              chunk_count;
+    MappedFile          in_file;
+    const char         *uniprot_start;
+    std::vector<const char*>                   chunk_bounds;
+    std::vector<std::unique_ptr<DiamondShard>> shards;
+    std::vector<std::thread>                   workers;
+    Instrumentation::Counter                  &rows_parsed = Instrumentation::counter("rows_parsed.diamond");
 
     FS_dprint("Beginning to filter individual DIAMOND files...");
 
@@ -235,25 +388,223 @@ void ModDiamond::parse() {
     for (std::string &output_path : _output_paths) {
         FS_dprint("DIAMOND file located at " + output_path + " being parsed");
 
-        // reset uniprot info for each database
-        is_uniprot = false;
-        uniprot_attempts = 0;
-        simSearchResults = {};
-
         // ensure file exists
         file_status = _pFileSystem->get_file_status(output_path);
         if (file_status != 0) {
             throw ExceptionHandler("File not found or empty: " + output_path, ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
         }
+        if (!in_file.open(output_path)) {
+            throw ExceptionHandler("Unable to read DIAMOND file: " + output_path, ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
+        }
+
+        // Check whether this is a UniProt database before splitting up the work
+        uniprot_start = find_uniprot_start(in_file.data(), in_file.end(), output_path);
+
+        // Split into line aligned ranges, small files are not worth spawning threads for
+        chunk_count = (uint32) std::min<uint64>((uint64) std::max(_threads, 1), in_file.size() / PARSE_CHUNK_MIN);
+        if (chunk_count == 0) chunk_count = 1;
+        chunk_bounds = MappedFile::split_lines(in_file.data(), in_file.end(), chunk_count);
+        shards.clear();
+        for (uint32 i = 0; i < chunk_count; i++) shards.emplace_back(new DiamondShard());
+        FS_dprint("Parsing with " + std::to_string(chunk_count) + " thread(s)");
+
+        if (chunk_count == 1) {
+            parse_hits_range(chunk_bounds[0], chunk_bounds[1], uniprot_start, output_path, 1, shards[0].get());
+        } else {
+            workers.clear();
+            for (uint32 i = 0; i < chunk_count; i++) {
+                workers.emplace_back(&ModDiamond::parse_hits_range, this, chunk_bounds[i], chunk_bounds[i+1],
+                                     uniprot_start, std::ref(output_path), chunk_count, shards[i].get());
+            }
+            for (std::thread &worker : workers) worker.join();
+        }
+        in_file.close();
 
-        // setup individual database directories for stats/figures
-        database_shortname = _path_to_database[output_path];
+        // Report the first error in file order, same as a serial parse would
+        for (std::unique_ptr<DiamondShard> &shard : shards) {
+            if (shard->error) std::rethrow_exception(shard->error);
+            rows_parsed += shard->hits.size();
+        }
+
+        // Add alignments to sequences, each merge thread owns a subset of queries
+        if (chunk_count == 1) {
+            merge_hits(shards, 0, output_path);
+        } else {
+            workers.clear();
+            for (uint32 i = 0; i < chunk_count; i++) {
+                workers.emplace_back(&ModDiamond::merge_hits, this, std::ref(shards), i, std::ref(output_path));
+            }
+            for (std::thread &worker : workers) worker.join();
+        }
+        shards.clear();
+
+        // Finished parsing and adding to alignment data, being to calc stats
+        FS_dprint("File parsed, calculating statistics and writing output...");
+        calculate_best_stats(false,output_path);
+        FS_dprint("Success!");
+    } // END FOR LOOP
+
+    FS_dprint("Taxonomy cache: " + std::to_string(_tax_cache.hits()) + " hits, " +
+              std::to_string(_tax_cache.misses()) + " misses, " + std::to_string(_tax_cache.size()) + " species");
+    Instrumentation::counter("taxonomy_cache.hits") += _tax_cache.hits();
+    Instrumentation::counter("taxonomy_cache.misses") += _tax_cache.misses();
 
-        // Begin using CSVReader lib to parse data
-        io::CSVReader<DMND_COL_NUMBER, io::trim_chars<' '>, io::no_quote_escape<'\t'>> in(output_path);
-        while (in.read_row(qseqid, sseqid, pident, length, mismatch, gapopen,
-                           qstart, qend, sstart, send, evalue, bitscore, coverage,stitle)) {
-            simSearchResults = {};
+    FS_dprint("Calculating overall Similarity Searching statistics...");
+    calculate_best_stats(true);
+    FS_dprint("Success!");
+}
+
+
+/**
+ * ======================================================================
+ * Function bool ModDiamond::split_row(const char *begin, const char *end,
+ *                                    std::string *fields)
+ *
+ * Description          - Splits a tab delimited DIAMOND row into its
+ *                        columns, trimming surrounding spaces
+ *
+ * Notes                - None
+ *
+ * @param begin         - Start of row
+ * @param end           - End of row (newline excluded)
+ * @param fields        - Output, DMND_COL_NUMBER columns
+ *
+ * @return              - False if row has the wrong number of columns
+ *
+ * =====================================================================
+ */
+bool ModDiamond::split_row(const char *begin, const char *end, std::string *fields) {
+    const char *col_end;
+    const char *col_start;
+    const char *trim_end;
+
+    for (int col = 0; col < DMND_COL_NUMBER; col++) {
+        col_end = static_cast<const char*>(memchr(begin, '\t', end - begin));
+        if (col_end == nullptr) {
+            if (col != DMND_COL_NUMBER - 1) return false;
+            col_end = end;
+        } else if (col == DMND_COL_NUMBER - 1) {
+            return false;
+        }
+        col_start = begin;
+        trim_end  = col_end;
+        while (col_start < trim_end && *col_start == ' ') col_start++;
+        while (trim_end > col_start && trim_end[-1] == ' ') trim_end--;
+        fields[col].assign(col_start, trim_end - col_start);
+        begin = col_end + 1;
+    }
+    return true;
+}
+
+
+/**
+ * ======================================================================
+ * Function const char* ModDiamond::find_uniprot_start(const char *begin,
+ *                                              const char *end,
+ *                                              std::string &output_path)
+ *
+ * Description          - Checks the first rows of a DIAMOND file to see
+ *                        whether it was run against UniProt
+ *
+ * Notes                - The first row that is a UniProt match marks the
+ *                        database as UniProt, every row from there on is
+ *                        looked up. Gives up after UNIPROT_ATTEMPTS rows
+ *
+ * @param begin         - Start of file
+ * @param end           - End of file
+ * @param output_path   - Path to DIAMOND file
+ *
+ * @return              - Row where UniProt lookups start, end if not UniProt
+ *
+ * =====================================================================
+ */
+const char* ModDiamond::find_uniprot_start(const char *begin, const char *end, std::string &output_path) {
+    uint32       uniprot_attempts=0;
+    const char  *pos = begin;
+    const char  *line_start;
+    const char  *line_end;
+    std::string  fields[DMND_COL_NUMBER];
+    UniprotEntry uniprot_entry;
+
+    while (pos < end && uniprot_attempts <= UNIPROT_ATTEMPTS) {
+        line_start = pos;
+        pos = FastaScanner::next_line(pos, end, line_end);
+        if (line_end == line_start) continue;
+        if (!split_row(line_start, line_end, fields)) break;   // Reported by parse
+
+        if (is_uniprot_entry(fields[1], uniprot_entry)) {
+            FS_dprint("Database file at " + output_path + "\nDetermined to be UniProt");
+            _pQUERY_DATA->set_is_uniprot(true);
+            _pQUERY_DATA->header_set_uniprot(true);
+            return line_start;
+        }
+        uniprot_attempts++;
+    }
+    return end;
+}
+
+
+/**
+ * ======================================================================
+ * Function void ModDiamond::parse_hits_range(const char *begin, const char *end,
+ *                                            const char *uniprot_start,
+ *                                            std::string &output_path,
+ *                                            uint32 owners,
+ *                                            DiamondShard *shard)
+ *
+ * Description          - Parses and enriches DIAMOND rows within a line
+ *                        aligned range of the mapped file into a shard
+ *                      - Run on worker threads, only reads shared data
+ *
+ * Notes                - Errors are stored in the shard and rethrown by
+ *                        the calling thread
+ *
+ * @param begin         - Start of range
+ * @param end           - End of range
+ * @param uniprot_start - Rows at or past this are looked up in UniProt
+ * @param output_path   - Path to DIAMOND file
+ * @param owners        - Number of merge threads queries are split across
+ * @param shard         - Output for this range
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModDiamond::parse_hits_range(const char *begin, const char *end, const char *uniprot_start,
+                                  std::string &output_path, uint32 owners, DiamondShard *shard) {
+    const char          *pos = begin;
+    const char          *line_start;
+    const char          *line_end;
+    char                *num_end;
+    std::string          fields[DMND_COL_NUMBER];
+    std::string          species;
+    TaxEntry             taxEntry;
+    std::pair<bool, std::string> contam_info;
+    fp64                 evalue, coverage;
+
+    try {
+        while (pos < end) {
+            line_start = pos;
+            pos = FastaScanner::next_line(pos, end, line_end);
+            if (line_end == line_start) continue;
+            if (!split_row(line_start, line_end, fields)) {
+                throw ExceptionHandler("Unexpected number of columns in DIAMOND file: " + output_path +
+                    "\nLine: " + std::string(line_start, line_end), ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
+            }
+            std::string &qseqid = fields[0];
+            std::string &sseqid = fields[1];
+            std::string &stitle = fields[13];
+
+            evalue   = strtod(fields[10].c_str(), &num_end);
+            if (fields[10].empty() || *num_end != '\0') {
+                throw ExceptionHandler("Invalid e-value in DIAMOND file: " + output_path +
+                    "\nLine: " + std::string(line_start, line_end), ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
+            }
+            coverage = strtod(fields[12].c_str(), &num_end);
+            if (fields[12].empty() || *num_end != '\0') {
+                throw ExceptionHandler("Invalid coverage in DIAMOND file: " + output_path +
+                    "\nLine: " + std::string(line_start, line_end), ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
+            }
 
             // Get pointer to sequence in overall map
             QuerySequence *query = _pQUERY_DATA->get_sequence(qseqid);
@@ -262,45 +613,36 @@ void ModDiamond::parse() {
                                        ERR_ENTAP_RUN_SIM_SEARCH_FILTER);
             }
 
-            // get species from database alignment (using boost regex for now)
+            shard->hits.emplace_back();
+            DiamondHit &hit = shard->hits.back();
+            QuerySequence::SimSearchResults &simSearchResults = hit.results;
+            hit.query = query;
+            hit.owner = (uint32) (std::hash<QuerySequence*>()(query) % owners);
+
+            // get species from database alignment
             species = get_species(stitle);
-            // get taxonomic information with species
-            taxEntry = _pEntapDatabase->get_tax_entry(species);
-            // get contaminant information
-            contam_info = is_contaminant(taxEntry.lineage, _contaminants);
+            // get taxonomic and contaminant information with species
+            get_taxonomy(species, taxEntry, contam_info);
 
             // Check if this is a UniProt match and pull back info if so
-            if (is_uniprot) {
-                // Get uniprot info
+            if (line_start >= uniprot_start) {
                 is_uniprot_entry(sseqid, simSearchResults.uniprot_info);
-            } else {
-                if (uniprot_attempts <= UNIPROT_ATTEMPTS) {
-                    // First UniProt match assumes the rest are UniProt as well in database
-                    is_uniprot = is_uniprot_entry(sseqid, simSearchResults.uniprot_info);
-                    if (!is_uniprot) {
-                        uniprot_attempts++;
-                    } else {
-                        FS_dprint("Database file at " + output_path + "\nDetermined to be UniProt");
-                        _pQUERY_DATA->set_is_uniprot(true);
-                        _pQUERY_DATA->header_set_uniprot(true);
-                    }
-                } // Else, database is NOT UniProt after # of attempts
             }
 
             // Compile sim search data
             simSearchResults.database_path = output_path;
             simSearchResults.qseqid = qseqid;
             simSearchResults.sseqid = sseqid;
-            simSearchResults.pident = pident;
-            simSearchResults.length = length;
-            simSearchResults.mismatch = mismatch;
-            simSearchResults.gapopen = gapopen;
-            simSearchResults.qstart = qstart;
-            simSearchResults.qend = qend;
-            simSearchResults.sstart = sstart;
-            simSearchResults.send = send;
+            simSearchResults.pident = fields[2];
+            simSearchResults.length = fields[3];
+            simSearchResults.mismatch = fields[4];
+            simSearchResults.gapopen = fields[5];
+            simSearchResults.qstart = fields[6];
+            simSearchResults.qend = fields[7];
+            simSearchResults.sstart = fields[8];
+            simSearchResults.send = fields[9];
             simSearchResults.stitle = stitle;
-            simSearchResults.bit_score = bitscore;
+            simSearchResults.bit_score = fields[11];
             simSearchResults.lineage = taxEntry.lineage;
             simSearchResults.species = species;
             simSearchResults.e_val_raw = evalue;
@@ -314,20 +656,41 @@ void ModDiamond::parse() {
             simSearchResults.is_informative = is_informative(stitle, _uninformative_vect);
             simSearchResults.is_informative ? simSearchResults.yes_no_inform = YES_FLAG :
                     simSearchResults.yes_no_inform  = NO_FLAG;
+        }
+    } catch (...) {
+        shard->error = std::current_exception();
+    }
+}
 
-            query->add_alignment(_execution_state, _software_flag,
-                    simSearchResults, output_path, _input_lineage);
-        } // END WHILE LOOP
-
-        // Finished parsing and adding to alignment data, being to calc stats
-        FS_dprint("File parsed, calculating statistics and writing output...");
-        calculate_best_stats(false,output_path);
-        FS_dprint("Success!");
-    } // END FOR LOOP
 
-    FS_dprint("Calculating overall Similarity Searching statistics...");
-    calculate_best_stats(true);
-    FS_dprint("Success!");
+/**
+ * ======================================================================
+ * Function void ModDiamond::merge_hits(std::vector<std::unique_ptr<DiamondShard>> &shards,
+ *                                      uint32 owner, std::string &output_path)
+ *
+ * Description          - Adds parsed hits to their query sequences
+ *
+ * Notes                - Only hits of queries owned by this thread are
+ *                        added, so threads never share a sequence. Shards
+ *                        are walked in file order
+ *
+ * @param shards        - Parsed shards in file order
+ * @param owner         - Owner index of this merge thread
+ * @param output_path   - Path to DIAMOND file
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void ModDiamond::merge_hits(std::vector<std::unique_ptr<DiamondShard>> &shards, uint32 owner,
+                            std::string &output_path) {
+    for (std::unique_ptr<DiamondShard> &shard : shards) {
+        for (DiamondHit &hit : shard->hits) {
+            if (hit.owner != owner) continue;
+            hit.query->add_alignment(_execution_state, _software_flag,
+                                     hit.results, output_path, _input_lineage);
+        }
+    }
 }
 
 typedef std::map<std::string,std::map<std::string,uint32>> graph_sum_t;
@@ -342,7 +705,9 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
     std::string                 base_path;
     std::string                 temp_file_path;
     std::string                 contam;
+    std::string                 row;
     std::stringstream           ss;
+    std::stringstream           header_stream;
     uint64                      count_no_hit=0;
     uint64                      count_contam=0;
     uint64                      count_filtered=0;
@@ -357,6 +722,10 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
     Compair<std::string>        species_counter;
     Compair<std::string>        contam_species_counter;
     graph_sum_t                 graphing_sum_map;
+    Instrumentation::ScopedTimer timer("best_hits");     // Statistics and output files
+    std::vector<QuerySequence*> sequences;
+    std::vector<QueryAlignment*> unselected_hits;
+    std::vector<std::pair<QuerySequence*, SimSearchAlignment*>> best_hits;   // Output order
 
     // Set up output directories (processed directory cleared earlier so these will be empty)
     if (is_final) {
@@ -386,15 +755,18 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
 
     // Open unselected hits, so every hit that was not the best hit (tsv)
     std::string out_unselected_tsv  = PATHS(base_path, SIM_SEARCH_DATABASE_UNSELECTED + FileSystem::EXT_TSV);
-    std::ofstream file_unselected_hits(out_unselected_tsv, std::ios::out | std::ios::app);
+    OutputWriter file_unselected_hits;
+    file_unselected_hits.open(out_unselected_tsv, true);
 
     // Open no hits file (fasta nucleotide)
     std::string out_no_hits_fa_nucl = PATHS(base_path, SIM_SEARCH_DATABASE_NO_HITS + FileSystem::EXT_FNN);
-    std::ofstream file_no_hits_nucl(out_no_hits_fa_nucl, std::ios::out | std::ios::app);
+    OutputWriter file_no_hits_nucl;
+    file_no_hits_nucl.open(out_no_hits_fa_nucl, true);
 
     // Open no hits file (fasta protein)
     std::string out_no_hits_fa_prot  = PATHS(base_path, SIM_SEARCH_DATABASE_NO_HITS + FileSystem::EXT_FAA);
-    std::ofstream file_no_hits_prot(out_no_hits_fa_prot, std::ios::out | std::ios::app);
+    OutputWriter file_no_hits_prot;
+    file_no_hits_prot.open(out_no_hits_fa_prot, true);
 
     // ------------------- Setup graphing files ------------------------- //
 
@@ -412,7 +784,8 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
     // ------------------------------------------------------------------ //
 
     // Print headers to relevant tsv files
-    _pFileSystem->print_headers(file_unselected_hits, DEFAULT_HEADERS, FileSystem::DELIM_TSV);
+    _pFileSystem->initialize_file(&header_stream, DEFAULT_HEADERS, FileSystem::ENT_FILE_DELIM_TSV);
+    file_unselected_hits.write(header_stream.str());
 
 
     try {
@@ -421,24 +794,27 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
         graph_sum_file     << "Category\tCount"    << std::endl;
 
         // Cycle through all sequences
-        for (auto &pair : *_pQUERY_DATA->get_sequences_ptr()) {
+        sequences = _pQUERY_DATA->get_output_order();
+        for (QuerySequence *query : sequences) {
             // Check if original sequences have hit a database
-            if (!pair.second->hit_database(SIMILARITY_SEARCH, SIM_DIAMOND, database_path)) {
+            if (!query->hit_database(SIMILARITY_SEARCH, SIM_DIAMOND, database_path)) {
                 // Did NOT hit a database during sim search
                 // Do NOT log if it was never blasted
-                if ((pair.second->QUERY_FLAG_GET(QuerySequence::QUERY_IS_PROTEIN) && _blastp) ||
-                    (!pair.second->QUERY_FLAG_GET(QuerySequence::QUERY_IS_PROTEIN) && !_blastp)) {
+                if ((query->QUERY_FLAG_GET(QuerySequence::QUERY_IS_PROTEIN) && _blastp) ||
+                    (!query->QUERY_FLAG_GET(QuerySequence::QUERY_IS_PROTEIN) && !_blastp)) {
                     // Protein/nucleotide did not hit database
                     count_no_hit++;
-                    file_no_hits_nucl << pair.second->get_sequence_n() << std::endl;
-                    file_no_hits_prot << pair.second->get_sequence_p() << std::endl;
+                    file_no_hits_nucl.write(query->get_sequence_n());
+                    file_no_hits_nucl.write("\n", 1);
+                    file_no_hits_prot.write(query->get_sequence_p());
+                    file_no_hits_prot.write("\n", 1);
                     // Graphing
-                    frame = pair.second->getFrame();
+                    frame = query->getFrame();
                     if (graphing_sum_map[frame].find(NO_HIT_FLAG) != graphing_sum_map[frame].end()) {
                         graphing_sum_map[frame][NO_HIT_FLAG]++;
                     } else graphing_sum_map[frame][NO_HIT_FLAG] = 1;
                 } else {
-                    pair.second->QUERY_FLAG_SET(QuerySequence::QUERY_BLASTED);
+                    query->QUERY_FLAG_SET(QuerySequence::QUERY_BLASTED);
                 }
             } else {
                 // HIT a database during sim search
@@ -448,45 +824,50 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
                 // Process unselected hits for non-final analysis and set best hit pointer
                 if (is_final) {
                     best_hit =
-                            pair.second->get_best_hit_alignment<SimSearchAlignment>(
+                            query->get_best_hit_alignment<SimSearchAlignment>(
                                     SIMILARITY_SEARCH, SIM_DIAMOND,"");
                     sim_search_data = best_hit->get_results();
                 } else {
-                    best_hit = pair.second->get_best_hit_alignment<SimSearchAlignment>(
+                    best_hit = query->get_best_hit_alignment<SimSearchAlignment>(
                             SIMILARITY_SEARCH, SIM_DIAMOND,database_path);
                     QuerySequence::align_database_hits_t *alignment_data =
-                            pair.second->get_database_hits(database_path,SIMILARITY_SEARCH, SIM_DIAMOND);
+                            query->get_database_hits(database_path,SIMILARITY_SEARCH, SIM_DIAMOND);
                     sim_search_data = best_hit->get_results();
+                    unselected_hits.clear();
                     for (auto &hit : *alignment_data) {
                         count_TOTAL_alignments++;
                         if (hit != best_hit) {  // If this hit is not the best hit
-                            file_unselected_hits << hit->print_delim(DEFAULT_HEADERS, 0, FileSystem::DELIM_TSV) << std::endl;
-                            count_unselected++;
-                        } else {
-                            ;   // Do notthing
+                            unselected_hits.push_back(hit);
                         }
                     }
+                    // Hits are stored unranked, written best to worst
+                    std::stable_sort(unselected_hits.begin(), unselected_hits.end(),
+                                     [](const QueryAlignment *first, const QueryAlignment *second) {
+                        return first->is_better(*second, false);
+                    });
+                    for (QueryAlignment *hit : unselected_hits) {
+                        row.clear();
+                        hit->print_delim(DEFAULT_HEADERS, 0, FileSystem::DELIM_TSV, row);
+                        row += '\n';
+                        file_unselected_hits.write(row);
+                        count_unselected++;
+                    }
                 }
                 count_filtered++;   // increment best hit
 
-                // Write to best hits files
-                _pQUERY_DATA->add_alignment_data(out_best_hits_filepath, pair.second, best_hit);
+                // Best hits files are written after stats
+                best_hits.emplace_back(query, best_hit);
 
-                frame = pair.second->getFrame();     // Used for graphing
+                frame = query->getFrame();     // Used for graphing
                 species = sim_search_data->species;
 
                 // Determine contaminant information and print to files
                 if (sim_search_data->contaminant) {
                     // Species is considered a contaminant
                     count_contam++;
-                    _pQUERY_DATA->add_alignment_data(out_best_contams_filepath, pair.second, best_hit);
-
                     contam = sim_search_data->contam_type;
                     contam_counter.add_value(contam);
                     contam_species_counter.add_value(species);
-                } else {
-                    // Species is NOT a contaminant, print to files
-                    _pQUERY_DATA->add_alignment_data(out_best_hits_no_contams, pair.second, best_hit);
                 }
 
                 // Count species type
@@ -508,6 +889,19 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
                 }
             }
         }
+
+        // Write best hits and contaminant/no contaminant files, formatted across threads
+        _pQUERY_DATA->write_alignment_rows(best_hits.size(), [&](uint64 i) {
+            QuerySequence      *query = best_hits[i].first;
+            SimSearchAlignment *hit   = best_hits[i].second;
+
+            _pQUERY_DATA->add_alignment_data(out_best_hits_filepath, query, hit);
+            if (hit->get_results()->contaminant) {
+                _pQUERY_DATA->add_alignment_data(out_best_contams_filepath, query, hit);
+            } else {
+                _pQUERY_DATA->add_alignment_data(out_best_hits_no_contams, query, hit);
+            }
+        });
     } catch (const std::exception &e){throw ExceptionHandler(e.what(), ERR_ENTAP_RUN_SIM_SEARCH_FILTER);}
 
     try {
@@ -515,9 +909,12 @@ void ModDiamond::calculate_best_stats (bool is_final, std::string database_path)
         _pQUERY_DATA->end_alignment_files(out_best_hits_filepath);
         _pQUERY_DATA->end_alignment_files(out_best_hits_no_contams);
 
-        _pFileSystem->close_file(file_no_hits_nucl);
-        _pFileSystem->close_file(file_no_hits_prot);
-        _pFileSystem->close_file(file_unselected_hits);
+        bool closed = file_no_hits_nucl.close();
+        closed &= file_no_hits_prot.close();
+        closed &= file_unselected_hits.close();
+        if (!closed) {
+            throw ExceptionHandler("Unable to write DIAMOND results to: " + base_path, ERR_ENTAP_FILE_IO);
+        }
     } catch (const ExceptionHandler &e) {throw e;}
 
     // ------------ Calculate statistics and print to output ------------ //
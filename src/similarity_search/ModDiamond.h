@@ -30,6 +30,9 @@
 
 
 #include "AbstractSimilaritySearch.h"
+#include "../QuerySequence.h"
+#include "../MappedFile.h"
+#include <memory>
 
 class ModDiamond : public AbstractSimilaritySearch {
 
@@ -51,7 +54,21 @@ public:
 
 
 private:
+    // Parsed and enriched DIAMOND row waiting to be added to its query
+    struct DiamondHit {
+        QuerySequence                   *query;
+        QuerySequence::SimSearchResults  results;
+        uint32                           owner;     // Merge thread that owns the query
+    };
+
+    // Hits of one line aligned range of a DIAMOND file
+    struct DiamondShard {
+        std::vector<DiamondHit>          hits;
+        std::exception_ptr               error;
+    };
+
     static constexpr int DMND_COL_NUMBER = 14;
+    static constexpr uint64 PARSE_CHUNK_MIN = 4 * 1024 * 1024;  // Min bytes per parse thread
     const std::string SIM_SEARCH_DATABASE_BEST_HITS              = "best_hits";
     const std::string SIM_SEARCH_DATABASE_BEST_HITS_CONTAM       = "best_hits_contam";
     const std::string SIM_SEARCH_DATABASE_BEST_HITS_NO_CONTAM    = "best_hits_no_contam";
@@ -75,7 +92,13 @@ private:
     const std::string INFORMATIVE_FLAG                           = "Informative";
     const std::string NO_HIT_FLAG                                = "No Hits";
 
+    void run_searches(std::vector<SimSearchCmd> &cmds, std::vector<uint16> &job_threads);
     void calculate_best_stats(bool is_final, std::string database_path="");
+    bool split_row(const char *begin, const char *end, std::string *fields);
+    const char* find_uniprot_start(const char *begin, const char *end, std::string &output_path);
+    void parse_hits_range(const char *begin, const char *end, const char *uniprot_start,
+                          std::string &output_path, uint32 owners, DiamondShard *shard);
+    void merge_hits(std::vector<std::unique_ptr<DiamondShard>> &shards, uint32 owner, std::string &output_path);
 };
 
 
@@ -0,0 +1,125 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//*********************** Includes *****************************
+#include "TaxonomyCache.h"
+//**************************************************************
+
+
+TaxonomyCache::TaxonomyCache(uint64 max_entries) {
+    _max_per_shard = max_entries / SHARD_COUNT;
+    if (_max_per_shard == 0) _max_per_shard = 1;
+    _hits   = 0;
+    _misses = 0;
+}
+
+
+/**
+ * ======================================================================
+ * Function bool TaxonomyCache::find(const std::string &species,
+ *                                   TaxonomyCacheEntry &entry)
+ *
+ * Description          - Looks up previously resolved taxonomic
+ *                        information for a species
+ *
+ * Notes                - Safe to call from multiple threads
+ *
+ * @param species       - Raw species string from hit title
+ * @param entry         - Filled in when found
+ *
+ * @return              - True if species was cached
+ *
+ * =====================================================================
+ */
+bool TaxonomyCache::find(const std::string &species, TaxonomyCacheEntry &entry) {
+    Shard &shard = get_shard(species);
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.entries.find(species);
+        if (it != shard.entries.end()) {
+            entry = it->second;
+            _hits++;
+            return true;
+        }
+    }
+    _misses++;
+    return false;
+}
+
+
+/**
+ * ======================================================================
+ * Function void TaxonomyCache::insert(const std::string &species,
+ *                                     const TaxonomyCacheEntry &entry)
+ *
+ * Description          - Caches taxonomic information for a species
+ *
+ * Notes                - Ignored when the species' shard is full
+ *
+ * @param species       - Raw species string from hit title
+ * @param entry         - Resolved information
+ *
+ * @return              - None
+ *
+ * =====================================================================
+ */
+void TaxonomyCache::insert(const std::string &species, const TaxonomyCacheEntry &entry) {
+    Shard &shard = get_shard(species);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.entries.size() >= _max_per_shard) return;
+    shard.entries.emplace(species, entry);
+}
+
+void TaxonomyCache::clear() {
+    for (Shard &shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.entries.clear();
+    }
+    _hits   = 0;
+    _misses = 0;
+}
+
+uint64 TaxonomyCache::hits() const {
+    return _hits;
+}
+
+uint64 TaxonomyCache::misses() const {
+    return _misses;
+}
+
+uint64 TaxonomyCache::size() {
+    uint64 ret = 0;
+    for (Shard &shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        ret += shard.entries.size();
+    }
+    return ret;
+}
+
+TaxonomyCache::Shard &TaxonomyCache::get_shard(const std::string &species) {
+    return _shards[std::hash<std::string>()(species) % SHARD_COUNT];
+}
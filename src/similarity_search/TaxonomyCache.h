@@ -0,0 +1,85 @@
+/*
+ *
+ * Developed by Alexander Hart
+ * Plant Computational Genomics Lab
+ * University of Connecticut
+ *
+ * For information, contact Alexander Hart at:
+ *     entap.dev@gmail.com
+ *
+ * Copyright 2017-2019, Alexander Hart, Dr. Jill Wegrzyn
+ *
+ * This file is part of EnTAP.
+ *
+ * EnTAP is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * EnTAP is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with EnTAP.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTAP_TAXONOMYCACHE_H
+#define ENTAP_TAXONOMYCACHE_H
+
+//*********************** Includes *****************************
+#include <atomic>
+#include <mutex>
+#include "../common.h"
+#include "../database/EntapDatabase.h"
+//**************************************************************
+
+
+/**
+ * Taxonomic information resolved for a single species string, along with
+ * the contaminant check that depends only on its lineage
+ */
+struct TaxonomyCacheEntry {
+    std::string                  species;       // Species as normalized by the database lookup
+    TaxEntry                     tax_entry;
+    std::pair<bool, std::string> contam_info;
+};
+
+
+/**
+ * Bounded, thread-safe memo of species -> taxonomic information. Keyed by the
+ * raw species string pulled from the hit title. Entries are split across
+ * independently locked shards so parse threads rarely contend. Once a shard
+ * is full new species are no longer cached, existing entries are kept.
+ */
+class TaxonomyCache {
+
+public:
+    TaxonomyCache(uint64 max_entries);
+
+    bool find(const std::string &species, TaxonomyCacheEntry &entry);
+    void insert(const std::string &species, const TaxonomyCacheEntry &entry);
+    void clear();
+    uint64 hits() const;
+    uint64 misses() const;
+    uint64 size();
+
+private:
+    static constexpr uint32 SHARD_COUNT = 16;
+
+    struct Shard {
+        std::mutex                                          lock;
+        std::unordered_map<std::string, TaxonomyCacheEntry> entries;
+    };
+
+    Shard &get_shard(const std::string &species);
+
+    Shard                   _shards[SHARD_COUNT];
+    uint64                  _max_per_shard;
+    std::atomic<uint64>     _hits;
+    std::atomic<uint64>     _misses;
+};
+
+
+#endif //ENTAP_TAXONOMYCACHE_H